@@ -0,0 +1,246 @@
+# This script runs a small, fixed matrix of RBlockSim configurations and checks their performance against a baseline.
+# Each configuration is run with a fixed seed and a short simulated duration, so that it can be run on every commit.
+# The wall time, the committed events per second, the rollback ratio and the peak RAM usage of each run are written
+# to a JSON report, and the script exits with an error if any of them regressed beyond the baseline tolerances.
+import argparse
+import json
+import os
+import platform
+import shutil
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "..", "ROOT-Sim_core", "src", "log", "parse"))
+from rootsim_stats import RSStats  # noqa: E402
+
+# The network size is fixed at compile time (N_NODES, see generate_topology.py): larger networks are simulated as
+# several independent replicas of the network (-e), which scale the LPs and the events in the same way
+replicas = [1, 2]
+worker_threads = [1, 2, 4]
+attacks = {
+    "none": "",
+    "51": "-a 51",
+    "selfish": "-a selfish -s 0",
+}
+rng_seed = 1
+duration = 600  # [seconds] of simulated time
+
+command = "{executable_path} -w {wt} -e {replicas} -r {rng_seed} -u {duration} -p {stats_file} {attack}"
+
+# Relative tolerances, except for the rollback ratio, whose tolerance is absolute
+default_tolerances = {
+    "wall_time_s": 0.20,
+    "events_per_sec": 0.20,
+    "peak_rss_bytes": 0.10,
+    "rollback_ratio": 0.05,
+}
+# If True, the metric regresses when it grows, otherwise when it shrinks
+higher_is_worse = {
+    "wall_time_s": True,
+    "events_per_sec": False,
+    "peak_rss_bytes": True,
+    "rollback_ratio": True,
+}
+
+
+# The properties of the host which the absolute timings and memory usage depend on
+host_keys = ["cpu", "cores", "platform"]
+
+
+def host_description():
+    """Describe the machine the benchmarks run on, since the baseline is only meaningful on the host it was recorded on"""
+    cpu = platform.processor()
+    if os.path.exists("/proc/cpuinfo"):
+        with open("/proc/cpuinfo", "r") as f:
+            models = [line.split(":", 1)[1].strip() for line in f if line.startswith("model name")]
+        if models:
+            cpu = models[0]
+    return {
+        "hostname": platform.node(),
+        "cpu": cpu,
+        "cores": os.cpu_count(),
+        "platform": f"{platform.system()} {platform.release()} {platform.machine()}",
+    }
+
+
+def run_name(n_replicas, wt, attack):
+    return f"e{n_replicas}_w{wt}_a{attack}"
+
+
+def all_run_names():
+    return [run_name(n_replicas, wt, attack) for n_replicas in replicas for wt in worker_threads for attack in attacks]
+
+
+def run_once(executable_path, n_replicas, wt, attack, work_folder):
+    """Run a configuration in an empty folder and return its metrics, read back from the ROOT-Sim statistics file"""
+    run_folder = os.path.join(work_folder, run_name(n_replicas, wt, attack))
+    shutil.rmtree(run_folder, ignore_errors=True)
+    os.makedirs(run_folder)
+
+    this_command = command.format(
+        executable_path=executable_path,
+        wt=wt,
+        replicas=n_replicas,
+        rng_seed=rng_seed,
+        duration=duration,
+        stats_file="rootsim_stats",
+        attack=attacks[attack],
+    )
+    print(f"Running command: {this_command}")
+
+    start = time.perf_counter()
+    with open(os.path.join(run_folder, "out.txt"), "w") as out, open(os.path.join(run_folder, "err.txt"), "w") as err:
+        ret = subprocess.run(this_command.split(), cwd=run_folder, stdout=out, stderr=err).returncode
+    wall_time = time.perf_counter() - start
+    if ret != 0:
+        print(f"Error: the run failed with exit code {ret}, see {run_folder}/err.txt")
+        exit(1)
+
+    # ROOT-Sim appends the .bin extension to the statistics file name
+    stats = RSStats(os.path.join(run_folder, "rootsim_stats.bin"))
+    processed = stats.thread_metric_get("processed messages", aggregate_gvts=True, aggregate_nodes=True)
+    rolled_back = stats.thread_metric_get("rolled back messages", aggregate_gvts=True, aggregate_nodes=True)
+    # The processing time is measured in microseconds by each node
+    processing_time = max(stats.nodes_stats["processing_time"]) / 1e6
+
+    return {
+        "wall_time_s": wall_time,
+        "committed_events": processed - rolled_back,
+        "events_per_sec": (processed - rolled_back) / processing_time,
+        "rollback_ratio": rolled_back / processed if processed else 0.0,
+        "peak_rss_bytes": sum(stats.nodes_stats["maximum_resident_set"]),
+    }
+
+
+def run_matrix(executable_path, repetitions, work_folder):
+    # ROOT-Sim refuses to run more worker threads than the available cores
+    cores = os.cpu_count()
+    report = {"host": host_description(), "duration": duration, "rng_seed": rng_seed, "runs": {}}
+    for n_replicas in replicas:
+        for wt in worker_threads:
+            if wt > cores:
+                print(f"Skipping {wt} worker threads: only {cores} cores available")
+                continue
+            for attack in attacks:
+                results = [run_once(executable_path, n_replicas, wt, attack, work_folder) for _ in range(repetitions)]
+                # The median over the repetitions smooths out the noise of the timings
+                metrics = {key: statistics.median(r[key] for r in results) for key in results[0]}
+                metrics.update({"replicas": n_replicas, "wt": wt, "attack": attack})
+                report["runs"][run_name(n_replicas, wt, attack)] = metrics
+                print(
+                    f"Finished {run_name(n_replicas, wt, attack)}: {metrics['wall_time_s']:.2f} s, "
+                    f"{metrics['events_per_sec']:.0f} events/s, rollback ratio {metrics['rollback_ratio']:.4f}, "
+                    f"peak RSS {metrics['peak_rss_bytes'] / 2**20:.1f} MiB"
+                )
+    return report
+
+
+def same_host(host, other):
+    return other is not None and all(host.get(key) == other.get(key) for key in host_keys)
+
+
+def compare(report, baseline):
+    """Compare the report against the baseline and return the list of regressions
+
+    A run missing from the baseline is skipped with a warning, since there is nothing to compare it against."""
+    tolerances = {**default_tolerances, **baseline.get("tolerances", {})}
+    regressions = []
+    if report["duration"] != baseline.get("duration") or report["rng_seed"] != baseline.get("rng_seed"):
+        regressions.append("the baseline was recorded with a different duration or seed: record it again")
+        return regressions
+
+    if not same_host(report["host"], baseline.get("host")):
+        print(f"WARNING: the baseline was recorded on a different host ({baseline.get('host')}), "
+              f"the wall times and the memory usage are not comparable")
+
+    for name in sorted(baseline["runs"].keys() - report["runs"].keys()):
+        print(f"WARNING {name}: not run on this host ({report['host']['cores']} cores), not checked")
+
+    for name, metrics in report["runs"].items():
+        base = baseline["runs"].get(name)
+        if base is None:
+            print(f"WARNING {name}: no baseline, not checked. Record it with --update_baseline on the reference host")
+            continue
+        if metrics["committed_events"] != base["committed_events"]:
+            # The runs are deterministic: a different count means that the model changed, not its performance
+            print(f"WARN {name}: {metrics['committed_events']} committed events, {base['committed_events']} in the baseline")
+
+        for key, tolerance in tolerances.items():
+            if key == "rollback_ratio":
+                delta = metrics[key] - base[key]
+            else:
+                delta = (metrics[key] - base[key]) / base[key] if base[key] else 0.0
+            worse = delta > tolerance if higher_is_worse[key] else delta < -tolerance
+            status = "REGRESSION" if worse else "ok"
+            print(f"{name} {key}: {metrics[key]:.4g} (baseline {base[key]:.4g}, {delta:+.2%}) {status}")
+            if worse:
+                regressions.append(f"{name} {key}: {metrics[key]:.4g} vs {base[key]:.4g} ({delta:+.2%}, tolerance {tolerance:.0%})")
+    return regressions
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Run the RBlockSim performance regression benchmarks")
+    parser.add_argument("--executable", default="./rblocksim", help="Path of the rblocksim executable (default: ./rblocksim)")
+    parser.add_argument("--baseline", default=os.path.join(os.path.dirname(os.path.abspath(__file__)), "bench_baseline.json"),
+                        help="Path of the baseline report (default: scripts/bench_baseline.json)")
+    parser.add_argument("--report", default="bench_report.json", help="Path of the report to write (default: bench_report.json)")
+    parser.add_argument("--repetitions", type=int, default=5,
+                        help="Runs of each configuration, the median of which is compared (default: 5)")
+    parser.add_argument("--work_folder", default=None, help="Folder to run the simulations in (default: a temporary one)")
+    parser.add_argument("--update_baseline", action="store_true", help="Store the report as the new baseline")
+    args = parser.parse_args()
+
+    executable_path = os.path.abspath(args.executable)
+    if not os.path.exists(executable_path):
+        print(f"Error: executable {executable_path} does not exist")
+        exit(1)
+
+    if args.work_folder is None:
+        work_folder = tempfile.mkdtemp(prefix="rblocksim_bench_")
+    else:
+        work_folder = os.path.abspath(args.work_folder)
+        os.makedirs(work_folder, exist_ok=True)
+
+    report = run_matrix(executable_path, args.repetitions, work_folder)
+    if args.work_folder is None:
+        shutil.rmtree(work_folder)
+
+    with open(args.report, "w") as f:
+        json.dump(report, f, indent=2)
+    print(f"Report written to {args.report}")
+
+    if args.update_baseline:
+        baseline = {"tolerances": default_tolerances, **report}
+        if os.path.exists(args.baseline):
+            with open(args.baseline, "r") as f:
+                # Keep the tolerances, and the runs recorded on this same host in a previous invocation
+                old_baseline = json.load(f)
+            baseline["tolerances"] = old_baseline.get("tolerances", default_tolerances)
+            if old_baseline.get("duration") == duration and old_baseline.get("rng_seed") == rng_seed and \
+                    same_host(report["host"], old_baseline.get("host")):
+                baseline["runs"] = {**old_baseline.get("runs", {}), **report["runs"]}
+        missing = [name for name in all_run_names() if name not in baseline["runs"]]
+        if missing:
+            print(f"WARNING: the baseline lacks {', '.join(missing)}: record it on a host with at least "
+                  f"{max(worker_threads)} cores, or these configurations will go unchecked on such hosts")
+        with open(args.baseline, "w") as f:
+            json.dump(baseline, f, indent=2)
+        print(f"Baseline written to {args.baseline}")
+        exit(0)
+
+    if not os.path.exists(args.baseline):
+        print(f"Error: baseline {args.baseline} does not exist. Record it with --update_baseline")
+        exit(1)
+    with open(args.baseline, "r") as f:
+        baseline = json.load(f)
+
+    regressions = compare(report, baseline)
+    if regressions:
+        print(f"\nPERFORMANCE REGRESSIONS ({len(regressions)}):")
+        for r in regressions:
+            print(f"  {r}")
+        exit(1)
+    print("\nNo performance regressions")
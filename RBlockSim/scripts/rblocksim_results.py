@@ -0,0 +1,69 @@
+"""Loader for the columnar binary results files written by RBlockSim (stats_*.bin)
+
+The file starts with a fixed header holding the run configuration, followed by the field names and by one uint64
+array per field, each with one entry per node. The arrays are memory mapped, so loading is zero-copy.
+"""
+import numpy as np
+
+RESULTS_MAGIC = b"RBSR"
+RESULTS_VERSION = 1
+
+# Mirrors struct ResultsHeader in src/Statistics.h
+HEADER_DTYPE = np.dtype(
+    [
+        ("magic", "S4"),
+        ("version", "<u4"),
+        ("nodes", "<u8"),
+        ("threads", "<u4"),
+        ("attack_type", "<u4"),
+        ("block_interval", "<f8"),
+        ("hashpower", "<f8"),
+        ("start_time", "<f8"),
+        ("depth", "<u8"),
+        ("catchup_tolerance", "<u8"),
+        ("rng_seed", "<u8"),
+        ("fields_count", "<u4"),
+        ("field_name_len", "<u4"),
+    ]
+)
+
+# Mirrors enum attack_type in src/Attacks.h
+ATTACK_TYPES = {0: "none", 1: "selfish", 2: "51"}
+
+
+def load_results(path):
+    """Load a results file
+
+    Returns an (info, fields, data) tuple: info is a dict with the run configuration, fields is the list of field
+    names and data is a read-only (fields x nodes) uint64 numpy array backed by the mapped file. data[i] is the column
+    of fields[i], while data.T has the (nodes x fields) layout of the "data" entry of the JSON export.
+    """
+    raw = np.memmap(path, dtype=np.uint8, mode="r")
+    header = raw[: HEADER_DTYPE.itemsize].view(HEADER_DTYPE)[0]
+    if header["magic"] != RESULTS_MAGIC:
+        raise ValueError(f"{path} is not an RBlockSim results file")
+    if header["version"] != RESULTS_VERSION:
+        raise ValueError(f"{path} has unsupported version {header['version']}")
+
+    offset = HEADER_DTYPE.itemsize
+    fields_count = int(header["fields_count"])
+    name_len = int(header["field_name_len"])
+    names = raw[offset : offset + fields_count * name_len].view(f"S{name_len}")
+    offset += fields_count * name_len
+
+    nodes = int(header["nodes"])
+    data = raw[offset : offset + fields_count * nodes * 8].view("<u8").reshape(fields_count, nodes)
+
+    info = {name: header[name].item() for name in HEADER_DTYPE.names if name not in ("magic", "fields_count", "field_name_len")}
+    info["attack_type"] = ATTACK_TYPES.get(info["attack_type"], str(info["attack_type"]))
+    return info, [name.decode() for name in names], data
+
+
+if __name__ == "__main__":
+    import sys
+
+    for p in sys.argv[1:]:
+        run_info, run_fields, run_data = load_results(p)
+        print(p, run_info)
+        for field, column in zip(run_fields, run_data):
+            print(f"  {field}: sum={int(column.sum())} max={int(column.max())}")
@@ -8,6 +8,8 @@ import sys
 import re
 import json
 
+from rblocksim_results import load_results
+
 # Some definitions for accessing the data
 # stats is a list of lists [[Attacker blocks committed to MC], [MC height], [Blocks mined by me], [Own blocks in MC], [Switches to selfish-mined chain]]
 STATS_ATTACKER_BLOCKS_COMMITTED_TO_MC = 0
@@ -338,7 +340,10 @@ def load_attack_data(folder_path):
     if not info_file:
         return None
     info_file = info_file[0]
-    data_file = [f for f in files if f.startswith("stats")]
+    # Prefer the columnar binary results, the JSON export is optional
+    data_file = [f for f in files if f.startswith("stats") and f.endswith(".bin")]
+    if not data_file:
+        data_file = [f for f in files if f.startswith("stats") and f.endswith(".json")]
     if not data_file:
         return None
     data_file = data_file[0]
@@ -346,8 +351,15 @@ def load_attack_data(folder_path):
     with open(os.path.join(folder_path, info_file), "r") as f:
         info = json.load(f)
 
-    with open(os.path.join(folder_path, data_file), "r") as f:
-        stats = json.load(f)
+    if data_file.endswith(".bin"):
+        _, fields, data = load_results(os.path.join(folder_path, data_file))
+        # The runs are dumped again to json files later on, so materialize the per-node lists here
+        stats = {"header": fields, "data": data.T.tolist()}
+        data_file = data_file[: -len(".bin")]
+    else:
+        with open(os.path.join(folder_path, data_file), "r") as f:
+            stats = json.load(f)
+        data_file = data_file[: -len(".json")]
 
     attack_info = {}
 
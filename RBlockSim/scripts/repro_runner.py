@@ -15,6 +15,7 @@ g_wts = None
 g_intervals = None
 g_iterations = None
 g_network_size = None
+g_sweep = False
 modes = ["benchmark", "51", "selfish", "figure_8"]
 catchup_tolerances = [1, 2]
 depth = [1, 2, 3]
@@ -26,8 +27,52 @@ command_51 = "{executable_path} -w {wt} -i {interval} -a 51 -h {hashrate} -c {ca
 command_selfish = "{executable_path} -w {wt} -i {interval} -a selfish -h {hashrate} -c {catchup} -d {depth} -s 0 -o out{netsize} -r {rng_seed}"
 output_file = "{outerr}_sz{netsize}_w{wt}_bi{interval}_a{attack}_h{hashrate}_c{catchup}_d{depth}_rng{rng_seed}_it{iteration}.txt"
 metadata_file = "experiments_ran_metadata_and_RAM_{netsize}_a{attack}.json"
+sweep_file = "sweep_{netsize}_a{attack}.txt"
 ram_usage_file = "RAM_usage_peaks_Bytes_{netsize}_a{attack}.json"
 global_metadata = []
+sweep_runs = []
+
+
+def run_sweep(executable_path, network_size, attack):
+    """Run the options collected in sweep_runs back to back, in a single rblocksim process"""
+    this_sweep_file = sweep_file.format(netsize=network_size, attack=attack)
+    with open(this_sweep_file, "w") as f:
+        f.write("\n".join(sweep_runs) + "\n")
+
+    this_command = f"{executable_path} -f {this_sweep_file}"
+    out_file = f"out_sweep_{network_size}_a{attack}.txt"
+    err_file = f"err_sweep_{network_size}_a{attack}.txt"
+
+    print(f"Running command: {this_command} ({len(sweep_runs)} runs)")
+    print(f"Output file: {out_file}")
+    print(f"Error file: {err_file}")
+    if dry_run:
+        return
+
+    proc = subprocess.Popen(
+        shlex.split(this_command),
+        stdout=open(out_file, "w"),
+        stderr=open(err_file, "w"),
+    )
+
+    # Track the peak RAM usage of the whole sweep
+    peak_memory = 0
+    while proc.poll() is None:
+        try:
+            peak_memory = max(peak_memory, psutil.Process(proc.pid).memory_info().rss)
+        except psutil.NoSuchProcess:
+            pass
+        time.sleep(1)
+
+    proc.wait()
+    print(f"Finished sweep of {len(sweep_runs)} runs, attack {attack}")
+
+    RAM_peaks["sweep"] = peak_memory
+    with open(ram_usage_file, "w") as f:
+        json.dump(RAM_peaks, f)
+
+    with open(metadata_file, "w") as f:
+        json.dump(global_metadata, f)
 
 
 def run_benchmark(executable_path, wts, intervals, iterations, network_size):
@@ -193,6 +238,10 @@ def run_51(executable_path, wts, intervals, iterations, network_size):
                             iteration=it,
                         )
 
+                        if g_sweep:
+                            sweep_runs.append(shlex.join(shlex.split(this_command)[1:]))
+                            continue
+
                         print(f"Running command: {this_command}")
                         print(f"Output file: {out_file}")
                         print(f"Error file: {err_file}")
@@ -307,6 +356,10 @@ def run_selfish(executable_path, wts, intervals, iterations, network_size):
                                 iteration=it,
                             )
 
+                            if g_sweep:
+                                sweep_runs.append(shlex.join(shlex.split(this_command)[1:]))
+                                continue
+
                             print(f"Running command: {this_command}")
                             print(f"Output file: {out_file}")
                             print(f"Error file: {err_file}")
@@ -422,6 +475,10 @@ def run_figure_8(executable_path, wts, intervals, iterations, network_size):
                     iteration=it,
                 )
 
+                if g_sweep:
+                    sweep_runs.append(shlex.join(shlex.split(this_command)[1:]))
+                    continue
+
                 print(f"Running command: {this_command}")
                 print(f"Output file: {out_file}")
                 print(f"Error file: {err_file}")
@@ -491,6 +548,9 @@ if __name__ == "__main__":
     g_intervals = config["intervals"]
     g_iterations = config["iterations"]
     g_network_size = config["network_size"]
+    # If set, the attack runs are executed back to back by a single rblocksim process (-f). Benchmark runs are not,
+    # since their timings and memory usage are measured per run
+    g_sweep = config.get("sweep", False)
 
     if g_run_type not in modes:
         print(f"Invalid run type {g_run_type}")
@@ -527,3 +587,6 @@ if __name__ == "__main__":
         run_selfish(executable_path, g_wts, g_intervals, g_iterations, g_network_size)
     elif g_run_type == "figure_8":
         run_figure_8(executable_path, g_wts, g_intervals, 1, g_network_size)
+
+    if sweep_runs:
+        run_sweep(executable_path, g_network_size, g_run_type)
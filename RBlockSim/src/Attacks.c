@@ -8,26 +8,28 @@ size_t num_attackers = 0;
 struct attack_config attackConfig = {.type = ATTACK_NONE};
 
 /**
- * @brief Randomly populates the attackers array with attackers_count unique IDs
+ * @brief Randomly populates the attackers array of a replica with attackers_count unique IDs
  *
+ * @brief replica The replica whose attackers are chosen
  * @brief node_count The number of nodes in the network
  * @brief attackers_count The number of attackers in this simulation
  * @brief rng The random number generator state
  * */
-void generateAttackers(size_t node_count, size_t attackers_count, struct rng_t *rng) {
+void generateAttackers(replica_id_t replica, size_t node_count, size_t attackers_count, struct rng_t *rng) {
     node_id_t idx_nodes, idx_attackers = 0;
+    node_id_t *replica_ids = attacker_ids + (size_t) replica * attackers_count;
 
     for (idx_nodes = 0; idx_nodes < node_count && idx_attackers < attackers_count; ++idx_nodes) {
         size_t remaining_nodes = node_count - idx_nodes;
         size_t remaining_attackers = attackers_count - idx_attackers;
         if ((RandomU64(rng) % remaining_nodes) < remaining_attackers) {
-            attacker_ids[idx_attackers++] = idx_nodes;
-            bitmap_set(is_attacker_bitmap, idx_nodes);
+            replica_ids[idx_attackers++] = idx_nodes;
+            bitmap_set(is_attacker_bitmap, (size_t) replica * node_count + idx_nodes);
         }
     }
 }
 
-void initAttackers(size_t attackers_count, struct rng_t *rng) {
+void initAttackers(size_t attackers_count) {
     size_t b_size = bitmap_required_size(conf.lps);
     is_attacker_bitmap = malloc(b_size);
     bitmap_initialize(is_attacker_bitmap, conf.lps);
@@ -48,35 +50,44 @@ void initAttackers(size_t attackers_count, struct rng_t *rng) {
         }
     }
 
-    if (attackers_count >= conf.lps) {
-        fprintf(stderr, "Attackers must be less than the number of nodes. (Requested %lu attackers on %lu nodes)\n",
-                attackers_count, conf.lps);
+    if (attackers_count >= N_NODES) {
+        fprintf(stderr, "Attackers must be less than the number of nodes. (Requested %lu attackers on %d nodes)\n",
+                attackers_count, N_NODES);
         exit(EXIT_FAILURE);
     }
 
     num_attackers = attackers_count;
-    attacker_ids = malloc(num_attackers * sizeof(node_id_t));
+    attacker_ids = malloc(replicas * num_attackers * sizeof(node_id_t));
     if (!attacker_ids) {
         fprintf(stderr, "Failed to allocate memory for attackers\n");
         abort();
     }
+}
+
+void chooseAttackers(replica_id_t replica, struct rng_t *rng) {
+    if (!num_attackers) {
+        return;
+    }
 
     if (attackConfig.type == ATTACK_SELFISH_MINING || attackConfig.type == ATTACK_FIFTY_ONE) {
-        attacker_ids[0] = RandomU64(rng) % conf.lps;
-        bitmap_set(is_attacker_bitmap, attacker_ids[0]);
+        attacker_ids[replica] = RandomU64(rng) % N_NODES;
+        bitmap_set(is_attacker_bitmap, (size_t) replica * N_NODES + attacker_ids[replica]);
         return;
     }
 
-    generateAttackers(conf.lps, num_attackers, rng);
+    generateAttackers(replica, N_NODES, num_attackers, rng);
 }
 
 void deinitAttackers() {
     free(attacker_ids);
     free(is_attacker_bitmap);
+    attacker_ids = NULL;
+    is_attacker_bitmap = NULL;
+    num_attackers = 0;
 }
 
 bool is_attacker(node_id_t node_id) {
-    return bitmap_check(is_attacker_bitmap, node_id);
+    return bitmap_check(is_attacker_bitmap, NODE_LP(node_id));
 }
 
 void printAttackers() {
@@ -85,9 +96,14 @@ void printAttackers() {
         return;
     }
 
-    printf("Attackers: [");
-    for (size_t i = 0; i < num_attackers; i++) {
-        printf("%u, ", attacker_ids[i]);
+    for (replica_id_t r = 0; r < replicas; r++) {
+        if (replicas > 1) {
+            printf("Replica %u ", r);
+        }
+        printf("Attackers: [");
+        for (size_t i = 0; i < num_attackers; i++) {
+            printf("%u, ", attacker_ids[r * num_attackers + i]);
+        }
+        printf("]\n");
     }
-    printf("]\n");
 }
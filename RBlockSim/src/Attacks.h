@@ -44,10 +44,17 @@ extern struct attack_config attackConfig;
 /**
  * @brief Initializes the attacker management information
  *
- * @param attackers_count The number of attackers to simulate
+ * @param attackers_count The number of attackers to simulate in each replica
+ * */
+void initAttackers(size_t attackers_count);
+
+/**
+ * @brief Randomly chooses the attackers of a replica
+ *
+ * @param replica The replica whose attackers are chosen
  * @param rng The random number generator state
  * */
-void initAttackers(size_t attackers_count, struct rng_t *rng);
+void chooseAttackers(replica_id_t replica, struct rng_t *rng);
 
 /**
  * @brief Releases the resources allocated for the attackers management
@@ -55,7 +62,7 @@ void initAttackers(size_t attackers_count, struct rng_t *rng);
 void deinitAttackers();
 
 /**
- * @brief Checks if a node is an attacker
+ * @brief Checks if a node of the replica being processed is an attacker
  *
  * @param node_id The ID of the node to check
  *
@@ -1,11 +1,15 @@
 #include "Block.h"
+#include "BlockStore.h"
 #include "util.h"
 #include "Attacks.h"
 #include "Statistics.h"
+#include "Stake.h"
 #include <string.h>
 
 // Cumulative hash power of the honest nodes
-struct SharedHashPower totalHashPower = {.hashpower = 0};
+struct SharedHashPower *totalHashPower = NULL;
+
+enum fork_choice_rule forkChoice = FORK_CHOICE_LONGEST;
 
 const struct ChainNode genesis_block = {
         .miner = NODE_ID_MAX,
@@ -14,7 +18,8 @@ const struct ChainNode genesis_block = {
         .timestamp = -1.0,
         .score = 0,
         .height = 0,
-        .flags = 0
+        .flags = 0,
+        .weight = 1
 };
 
 #define setOrphan(ChainNode_ptr) ((ChainNode_ptr)->flags |= CHAIN_NODE_FLAG_ORPHAN)
@@ -107,6 +112,7 @@ void initBlockchain(struct Blockchain *chain) {
 
     chain->main_chain_index = 0;
     chain->min_height = 0;
+    chain->min_height_time = 0;
     chain->height = 0;
     chain->max_height = 0;
 
@@ -117,21 +123,41 @@ void initBlockchain(struct Blockchain *chain) {
     level->nodes[0] = genesis_block;
 }
 
+/**
+ * @brief Initializes a ValidationQueue
+ *
+ * @param queue the ValidationQueue to initialize
+ */
+static void initValidationQueue(struct ValidationQueue *queue) {
+    queue->busy_until = 0;
+    queue->pending = NULL;
+    queue->pending_count = 0;
+    queue->pending_capacity = 0;
+}
+
 void initBlockchainState(struct BlockchainState *state, struct rng_t *rng) {
     initBlockchain(&state->chain);
+    initValidationQueue(&state->validation);
     state->mined_by_me = 0;
 
     state->miningState.hashPower = (uint_fast64_t) NormalExpanded(rng, 5000, 1000);
-    atomic_fetch_add_explicit(&(totalHashPower.hashpower_atomic), state->miningState.hashPower, memory_order_relaxed);
+    atomic_fetch_add_explicit(&(totalHashPower[currentReplica].hashpower_atomic), state->miningState.hashPower, memory_order_relaxed);
 }
 
 void attackerInitBlockchainState(struct BlockchainState *state, struct rng_t *rng) {
+    (void) rng;
     initBlockchain(&state->chain);
+    initValidationQueue(&state->validation);
     state->mined_by_me = 0;
 }
 
 void afterInitBlockchainState(struct BlockchainState *state) {
-    state->miningState.hashPowerPortion = (double) state->miningState.hashPower / (double) totalHashPower.hashpower;
+    if (proposalPolicy == PROPOSAL_POS) {
+        // The stakes already account for the attackers
+        state->miningState.hashPowerPortion = getStakePortion(currentNode);
+        return;
+    }
+    state->miningState.hashPowerPortion = (double) state->miningState.hashPower / (double) totalHashPower[currentReplica].hashpower;
 
     // If simulating an attack, scale the hash power portion
     if (attackConfig.type == ATTACK_SELFISH_MINING) {
@@ -147,7 +173,9 @@ void attackerAfterInitBlockchainState(struct BlockchainState *state) {
         abort();
     }
 
-    if (attackConfig.type == ATTACK_SELFISH_MINING) {
+    if (proposalPolicy == PROPOSAL_POS) {
+        state->miningState.hashPowerPortion = getStakePortion(currentNode);
+    } else if (attackConfig.type == ATTACK_SELFISH_MINING) {
         state->miningState.hashPowerPortion = attackConfig.selfish.hashPowerPortion;
     } else if (attackConfig.type == ATTACK_FIFTY_ONE) {
         state->miningState.hashPowerPortion = attackConfig.fiftyOne.hashPowerPortion;
@@ -157,7 +185,8 @@ void attackerAfterInitBlockchainState(struct BlockchainState *state) {
 }
 
 void scheduleNextBlockGeneration(simtime_t now, struct rng_t *rng, struct BlockchainState *state) {
-    if (state->miningState.hashPowerPortion <= 0.0) return;
+    // With proof of stake, the block proposals are scheduled once per led slot instead
+    if (proposalPolicy != PROPOSAL_POW || state->miningState.hashPowerPortion <= 0.0) return;
 
     simtime_t next_gen_time = now + getNextGenDelay(rng, state->miningState.hashPowerPortion);
     // A block will be generated when extracting this event.
@@ -174,10 +203,83 @@ inline struct ChainNode *getMainChain(const struct Blockchain *blockchain) {
     return getChainNode(blockchain, blockchain->height, blockchain->main_chain_index);
 }
 
+/**
+ * @brief Computes the processing time needed to validate a block
+ *
+ * @param txn_count the number of transactions included in the block
+ */
+static simtime_t getValidationTime(unsigned txn_count) {
+    return BLOCK_VALIDATION_TIME + txn_count * TXN_VALIDATION_TIME;
+}
+
 simtime_t validateBlock(const struct Block *block, bool *is_valid) {
-    (void) block;
     *is_valid = true;
-    return BLOCK_VALIDATION_TIME;
+    return getValidationTime(block->transactionData.count);
+}
+
+/**
+ * @brief Searches the pending Blocks of a node
+ *
+ * @return The entry of the Block, NULL if it is not pending
+ */
+static struct PendingBlock *findPendingBlock(const struct ValidationQueue *queue, node_id_t miner, size_t height) {
+    for (size_t i = 0; i < queue->pending_count; i++) {
+        if (queue->pending[i].miner == miner && queue->pending[i].height == height) {
+            return &queue->pending[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Adds a Block to the pending ones, unless it is already there
+ *
+ * @return The entry of the Block
+ */
+static struct PendingBlock *addPendingBlock(struct ValidationQueue *queue, node_id_t miner, size_t height, bool fetching) {
+    struct PendingBlock *entry = findPendingBlock(queue, miner, height);
+    if (entry) {
+        return entry;
+    }
+    if (queue->pending_count == queue->pending_capacity) {
+        queue->pending_capacity = queue->pending_capacity ? queue->pending_capacity * 2 : 4;
+        queue->pending = rs_realloc(queue->pending, queue->pending_capacity * sizeof(struct PendingBlock));
+    }
+    entry = &queue->pending[queue->pending_count++];
+    *entry = (struct PendingBlock) {.miner = miner, .height = height, .fetching = fetching};
+    return entry;
+}
+
+void markBlockFetching(struct ValidationQueue *queue, node_id_t miner, size_t height) {
+    addPendingBlock(queue, miner, height, true);
+}
+
+simtime_t enqueueBlockValidation(struct ValidationQueue *queue, simtime_t now, const struct CompactBlock *cblock, bool *is_valid) {
+    *is_valid = true;
+    simtime_t elapsed = getValidationTime(cblock->txn_count);
+
+    addPendingBlock(queue, cblock->miner, cblock->height, false)->fetching = false;
+    queue->busy_until = (queue->busy_until > now ? queue->busy_until : now) + elapsed;
+    return queue->busy_until;
+}
+
+void dequeueBlockValidation(struct ValidationQueue *queue, node_id_t miner, size_t height) {
+    for (size_t i = 0; i < queue->pending_count; i++) {
+        if (queue->pending[i].miner == miner && queue->pending[i].height == height) {
+            queue->pending[i] = queue->pending[--queue->pending_count];
+            return;
+        }
+    }
+}
+
+bool isBlockPendingValidation(const struct ValidationQueue *queue, node_id_t miner, size_t height) {
+    const struct PendingBlock *entry = findPendingBlock(queue, miner, height);
+    return entry && !entry->fetching;
+}
+
+bool isBlockFetching(const struct ValidationQueue *queue, node_id_t miner, size_t height) {
+    const struct PendingBlock *entry = findPendingBlock(queue, miner, height);
+    return entry && entry->fetching;
 }
 
 /**
@@ -194,41 +296,68 @@ void populateChainNode(const struct Block *block, struct ChainNode *chainNode) {
     chainNode->height = block->height; // For maintenance purposes
     chainNode->score = 0;
     chainNode->ancestorsMined = 0;
+    chainNode->weight = 1;
 
-    size_t transaction_data_size = sizeofTransactionData(&block->transactionData);
-    chainNode->transactionData = rs_malloc(transaction_data_size);
-    memcpy(chainNode->transactionData, &block->transactionData, transaction_data_size);
+    chainNode->transactionData = storeTransactionData(block->miner, block->height, &block->transactionData);
 }
 
 /**
- * @brief Creates and populates a Block starting from a ChainNode
+ * @brief Creates the CompactBlock used to relay a ChainNode
  *
  * @warning Caller owns the returned pointer and must free it when done
  *
  * @param chain the Blockchain
  * @param node the starting Node
  *
- * @returns pointer to the newly created and populated Block
+ * @returns pointer to the newly created and populated CompactBlock. Its sender is the miner of the block
  */
-struct Block *blockFromNode(const struct Blockchain *chain, const struct ChainNode *node) {
-    size_t block_mem_size = sizeof(struct Block);
-    struct TransactionData *txn_data = node->transactionData;
-    block_mem_size += sizeofAdditionalTransactionDataBuffer(txn_data->high - txn_data->low);
-
-    struct Block *block = malloc(block_mem_size);
+static struct CompactBlock *compactBlockFromNode(const struct Blockchain *chain, const struct ChainNode *node) {
+    const struct TransactionData *txn_data = node->transactionData;
+    struct CompactBlock *cblock = malloc(sizeof(struct CompactBlock) + txn_data->count * sizeof(txn_id_t));
     if (isOrphan(node)) { // Bit of coupling -> Todo: Introduce function getParentsMiner
-        block->prevBlockMiner = node->parentMinerId;
+        cblock->prevBlockMiner = node->parentMinerId;
     } else {
         struct ChainNode *parent = getChainNode(chain, node->height - 1, node->parent_index);
-        block->prevBlockMiner = parent->miner;
-    }
-    block->timestamp = node->timestamp;
-    block->miner = node->miner;
-    block->height = node->height;
-    block->size = 10; // TODO: Actually compute size
-    block->is_attack_block = false;
-    size_t transaction_data_size = sizeofTransactionData(node->transactionData);
-    memcpy(&block->transactionData, node->transactionData, transaction_data_size);
+        cblock->prevBlockMiner = parent->miner;
+    }
+    cblock->timestamp = node->timestamp;
+    cblock->size = BLOCK_HEADER_SIZE + txn_data->size;
+    cblock->miner = node->miner;
+    cblock->sender = node->miner;
+    cblock->height = node->height;
+    cblock->is_attack_block = false;
+    cblock->txn_count = txn_data->count ? getTransactionIds(txn_data, cblock->txn_ids) : 0;
+    return cblock;
+}
+
+size_t sizeofCompactBlock(const struct CompactBlock *cblock) {
+    return sizeof(struct CompactBlock) + cblock->txn_count * sizeof(txn_id_t);
+}
+
+struct CompactBlock *compactBlock(const struct Block *block) {
+    struct CompactBlock *cblock = malloc(sizeof(struct CompactBlock) + block->transactionData.count * sizeof(txn_id_t));
+    cblock->timestamp = block->timestamp;
+    cblock->size = block->size;
+    cblock->miner = block->miner;
+    cblock->prevBlockMiner = block->prevBlockMiner;
+    cblock->sender = block->sender;
+    cblock->height = block->height;
+    cblock->is_attack_block = block->is_attack_block;
+    cblock->txn_count = block->transactionData.count ? getTransactionIds(&block->transactionData, cblock->txn_ids) : 0;
+    return cblock;
+}
+
+struct Block *blockFromCompact(const struct CompactBlock *cblock) {
+    size_t range = cblock->txn_count ? cblock->txn_ids[cblock->txn_count - 1] - cblock->txn_ids[0] + 1 : 0;
+    struct Block *block = malloc(sizeof(struct Block) + sizeofAdditionalTransactionDataBuffer(range));
+    block->timestamp = cblock->timestamp;
+    block->size = cblock->size;
+    block->miner = cblock->miner;
+    block->prevBlockMiner = cblock->prevBlockMiner;
+    block->sender = cblock->sender;
+    block->height = cblock->height;
+    block->is_attack_block = cblock->is_attack_block;
+    fillTransactionData(&block->transactionData, cblock->txn_ids, cblock->txn_count, cblock->size - BLOCK_HEADER_SIZE);
     return block;
 }
 
@@ -306,6 +435,32 @@ struct ChainNode *chainNodeMax(struct ChainNode *nodeA, struct ChainNode *nodeB)
     }
 }
 
+/**
+ * @brief Links a ChainNode to its parent
+ *
+ * @param[in,out] chain the blockchain
+ * @param[in,out] node the ChainNode to link
+ * @param parent the parent of @a node
+ * @param parent_index Displacement of the parent ChainNode in its own ChainLevel
+ *
+ * With the GHOST fork choice, the weight of @a node is added to the subtree weights of all its ancestors still held.
+ * Dropping the deepest levels leaves the weights of the remaining ChainNodes untouched, as it only removes ancestors.
+ */
+static void linkChainNode(struct Blockchain *chain, struct ChainNode *node, struct ChainNode *parent, size_t parent_index) {
+    node->parent_index = parent_index;
+    node->ancestorsMined = parent->ancestorsMined;
+    node->score = parent->score + 1;
+    if (forkChoice != FORK_CHOICE_GHOST) {
+        return;
+    }
+    for (struct ChainNode *ancestor = parent;; ancestor = getChainNode(chain, ancestor->height - 1, ancestor->parent_index)) {
+        ancestor->weight += node->weight;
+        if (ancestor->height == chain->min_height) {
+            break;
+        }
+    }
+}
+
 /**
  * @brief Links all orphans related to block 'parent'
  *
@@ -335,9 +490,7 @@ unorphanBlocks(struct Blockchain *chain, struct ChainNode *parent, size_t parent
 
         if (orphanNode->parentMinerId == parent->miner) { // It IS a child
             unOrphan(orphanNode);
-            orphanNode->parent_index = parent_index;
-            orphanNode->ancestorsMined = parent->ancestorsMined;
-            orphanNode->score = parent->score + 1; // TODO use function for score update
+            linkChainNode(chain, orphanNode, parent, parent_index);
             if (!bestChild) {
                 bestChild = orphanNode;
                 *orphan_index = i;
@@ -447,6 +600,78 @@ void switchChains(struct Blockchain *chain, struct TransactionState *transaction
     free(to_apply);
 }
 
+/**
+ * @brief Selects the head of the chain with the GHOST fork choice, after a ChainNode has been linked
+ *
+ * Only the subtree weights of the ancestors of the new ChainNode changed, so the head moves only if its branch is now
+ * strictly heavier than the main chain where the two fork. In that case, the new head is found by descending that
+ * branch, following the heaviest child at each level.
+ *
+ * @param chain the blockchain
+ * @param node a newly linked ChainNode
+ * @param[in,out] index index of @a node inside its own ChainLevel, set to the index of the returned ChainNode
+ *
+ * @return the new head of the chain, or NULL if the main chain is still the heaviest
+ */
+static struct ChainNode *ghostHead(const struct Blockchain *chain, struct ChainNode *node, size_t *index) {
+    struct ChainNode *main_node = getMainChain(chain);
+    struct ChainNode *main_child = NULL; // Ancestor of the main chain head right after the fork
+    while (main_node->height > node->height) {
+        main_child = main_node;
+        main_node = getChainNode(chain, main_node->height - 1, main_node->parent_index);
+    }
+
+    struct ChainNode *fork = NULL;       // Ancestor of node right after the fork
+    size_t fork_index = 0;
+    while (node->height > main_node->height) {
+        fork = node;
+        fork_index = *index;
+        *index = node->parent_index;
+        node = getChainNode(chain, node->height - 1, node->parent_index);
+    }
+    while (node != main_node) {
+        fork = node;
+        fork_index = *index;
+        main_child = main_node;
+        if (node->height == chain->min_height) {
+            break; // The branches fork below the levels still held, compare their deepest ChainNodes
+        }
+        *index = node->parent_index;
+        node = getChainNode(chain, node->height - 1, node->parent_index);
+        main_node = getChainNode(chain, main_node->height - 1, main_node->parent_index);
+    }
+
+    if (!fork || (main_child && fork->weight <= main_child->weight)) {
+        return NULL;
+    }
+
+    // Descend the heavier branch. Ties go to the earliest received child
+    node = fork;
+    *index = fork_index;
+    while (node->height < chain->max_height) {
+        struct ChainLevel *level = getChainLevel(chain, node->height + 1);
+        struct ChainNode *best = NULL;
+        size_t best_index = 0;
+        for (size_t i = 0; i < level->size; i++) {
+            struct ChainNode *child = &level->nodes[i];
+            if (isOrphan(child) || child->parent_index != *index) {
+                continue;
+            }
+            if (!best || child->weight > best->weight ||
+                (child->weight == best->weight && chainNodeMaxHonest(best, child) == child)) {
+                best = child;
+                best_index = i;
+            }
+        }
+        if (!best) {
+            break;
+        }
+        node = best;
+        *index = best_index;
+    }
+    return node;
+}
+
 /**
  * @brief Checks whether the new chain is better than the old main chain. In which case, the new chain becomes main.
  *
@@ -459,10 +684,18 @@ void switchChains(struct Blockchain *chain, struct TransactionState *transaction
  *
  * If new_chain_node's score is better than that of the current main chain, the chain ending in new_chain_node becomes the
  * main chain. This takes care of de-applying changes made by the old chain, and applying the effects of the new chain.
+ * With the GHOST fork choice honest nodes follow the heaviest subtree instead, while attackers keep to the longest chain.
  */
 void
 maybeSwitchChains(struct Blockchain *chain, struct TransactionState *transactionState, struct ChainNode *new_chain_node,
                   size_t new_chain_index, node_id_t me, struct StatsState *statsState) {
+    if (forkChoice == FORK_CHOICE_GHOST && !is_attacker(me)) {
+        struct ChainNode *head = ghostHead(chain, new_chain_node, &new_chain_index);
+        if (head) {
+            switchChains(chain, transactionState, head, new_chain_index, me, statsState);
+        }
+        return;
+    }
     if (new_chain_node == chainNodeMax(getMainChain(chain), new_chain_node)) {
         switchChains(chain, transactionState, new_chain_node, new_chain_index, me, statsState);
     }
@@ -478,11 +711,7 @@ maybeSwitchChains(struct Blockchain *chain, struct TransactionState *transaction
 void resetLevels(struct ChainLevel *levels) {
     for (int i = 0; i < DEPTH_TO_KEEP; i++) {
         struct ChainLevel *l = &levels[i];
-        for (size_t j = 0; j < l->size; j++) { // Iterate up to l->size otherwise we double free
-            struct ChainNode *node = &l->nodes[j];
-            rs_free(node->transactionData);
-            //node->transactionData = NULL; // Not really needed
-        }
+        // The transactions of the nodes are held by the block store
         l->size = 0;
     }
 }
@@ -491,21 +720,23 @@ void resetLevels(struct ChainLevel *levels) {
  * @brief Moves @a chain one step forward by emptying @a old_levels and swapping @a current_levels and @a old_levels
  *
  * @param[in,out] chain the Blockchain to move forward
+ * @param now the current simulation time
  *
  * Empties @a chain->old_levels and swaps it with @a chain->current_levels. Also updates auxiliary fields
  */
-void moveChainForward(struct Blockchain *chain) {
+void moveChainForward(struct Blockchain *chain, simtime_t now) {
     resetLevels(chain->old_levels);
     struct ChainLevel *aux = chain->old_levels;
     chain->old_levels = chain->current_levels;
     chain->current_levels = aux;
     chain->min_height += DEPTH_TO_KEEP;
+    chain->min_height_time = now;
 }
 
-struct Block *retrieveBlock(struct Blockchain *chain, node_id_t miner, size_t height) {
+struct CompactBlock *retrieveBlock(struct Blockchain *chain, node_id_t miner, size_t height) {
     struct ChainNode *node = findChainNode(chain, miner, height);
     if (node) {
-        return blockFromNode(chain, node);
+        return compactBlockFromNode(chain, node);
     }
     return NULL;
 }
@@ -541,7 +772,7 @@ struct ChainNode *addBlock(simtime_t now, struct Blockchain *chain, struct Trans
         chain->max_height = block->height;
         // See whether there the chain needs to move forward to make space
         if (block->height >= chain->min_height + 2 * DEPTH_TO_KEEP) {
-            moveChainForward(chain);
+            moveChainForward(chain, now);
         }
     }
 
@@ -575,9 +806,7 @@ struct ChainNode *addBlock(simtime_t now, struct Blockchain *chain, struct Trans
         struct ChainNode *maybe_parent = &parentLevel->nodes[i];
         if (maybe_parent->miner == chainNode->parentMinerId) {
             if (isOrphan(maybe_parent)) break;
-            chainNode->parent_index = i;
-            chainNode->ancestorsMined = maybe_parent->ancestorsMined;
-            chainNode->score = maybe_parent->score + 1; // TODO use function for score update
+            linkChainNode(chain, chainNode, maybe_parent, i);
             found = true;
             break;
         }
@@ -618,9 +847,9 @@ generateBlock(node_id_t me, simtime_t now, struct BlockchainState *state, struct
         }
     }
 
-    struct Block *b = rs_malloc(block_mem_size);
+    struct Block *b = malloc(block_mem_size);
     b->timestamp = now;
-    b->size = 10; // TODO: actually use a size
+    b->size = BLOCK_HEADER_SIZE + (txn_data ? txn_data->size : 0);
     b->miner = me;
     b->sender = me;
     struct ChainNode *mainChain = getMainChain(&state->chain);
@@ -663,15 +892,10 @@ simtime_t receiveBlock(simtime_t now, struct BlockchainState *state, struct Tran
 
 void deinitBlockchainState(struct BlockchainState *state) {
     deinitBlockChain(&(state->chain));
-}
-
-void deinitChainNode(struct ChainNode *node) {
-    rs_free(node->transactionData);
+    rs_free(state->validation.pending);
 }
 
 void deinitChainLevel(struct ChainLevel *level) {
-    for (size_t i = 0; i < level->size; i++)
-        deinitChainNode(&level->nodes[i]);
     rs_free(level->nodes);
 }
 
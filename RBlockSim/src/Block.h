@@ -17,12 +17,20 @@ struct SharedHashPower {
     };
 };
 
-extern struct SharedHashPower totalHashPower;
+extern struct SharedHashPower *totalHashPower; ///< The total hash power of each replica
+
+/// The rule honest nodes follow to select their main chain among the forks
+enum fork_choice_rule {
+    FORK_CHOICE_LONGEST, ///< The highest chain
+    FORK_CHOICE_GHOST,   ///< The chain found descending the heaviest subtree at each fork
+};
+
+extern enum fork_choice_rule forkChoice;
 
 /// Transfer object for a Block in the chain. Counterpart of ChainNode
 struct Block {
     double timestamp;          ///< Creation timestamp
-    size_t size;               ///< Size in memory
+    size_t size;               ///< Size in Bytes, header and included transactions
     node_id_t miner;           ///< ID of node that mined the block
     node_id_t prevBlockMiner;  ///< ID of node that mined the PARENT block
     node_id_t sender;          ///< ID of node that last relayed the block
@@ -31,6 +39,19 @@ struct Block {
     struct TransactionData transactionData; ///< Transaction information, transparent for this layer
 };
 
+/// Wire format of a Block. Carries the ids of the included transactions, which receivers look up in their own view
+struct CompactBlock {
+    double timestamp;          ///< Creation timestamp
+    size_t size;               ///< Size in Bytes of the full Block, header and included transactions
+    node_id_t miner;           ///< ID of node that mined the block
+    node_id_t prevBlockMiner;  ///< ID of node that mined the PARENT block
+    node_id_t sender;          ///< ID of node that last relayed the block
+    size_t height;             ///< Block number AND height
+    bool is_attack_block;      ///< True if the block is the last of a selfish mining attack
+    unsigned txn_count;        ///< Number of included transactions
+    txn_id_t txn_ids[];        ///< IDs of the included transactions, sorted
+};
+
 enum chain_node_flag { CHAIN_NODE_FLAG_ORPHAN = 1, CHAIN_NODE_FLAG_INCLUDED = 2 };
 
 /// Storage object for a Block in the chain. Counterpart of Block
@@ -39,13 +60,14 @@ struct ChainNode {
         size_t parent_index;                  ///< Index of parent ChainNode inside of the ChainLevel previous height
         node_id_t parentMinerId;              ///< Id of the parent's miner. Used when still an orphan.
     };
-    struct TransactionData *transactionData;  ///< Transaction information, transparent for this layer
+    const struct TransactionData *transactionData; ///< Transaction information, transparent for this layer. Held by the block store
     double timestamp;                         ///< Block timestamp
     node_id_t miner;                          ///< ID of node that mined the block
     size_t height;                            ///< Block number AND height (no miner will mine at the same height twice)
-    uint32_t score;                           ///< Consensus score for the chain this block is the last of. For longest chain it is the height, for GHOST it is the amount of work done.
+    uint32_t score;                           ///< Consensus score for the chain this block is the last of. It is the height, GHOST relies on @a weight instead.
     uint32_t flags;                           ///< Flags of the node.
     uint32_t ancestorsMined;                  ///< How many ancestors of this node have been mined by me, including this node
+    uint32_t weight;                          ///< Number of blocks in the subtree rooted at this node, including it. Only maintained for GHOST
 };
 
 /// Single level of the blockchain. Contains all Blocks at a given height
@@ -63,6 +85,7 @@ struct Blockchain {
     size_t height;                       ///< Height of last block of main chain
     size_t max_height;                   ///< Height of the highest block in the chain. Includes orphans
     size_t min_height;                   ///< Height of the deepest block still held in the chain
+    simtime_t min_height_time;           ///< Time at which @a min_height was last raised
 };
 
 /// Portion of the state dedicated to mining information
@@ -73,10 +96,26 @@ struct MiningState {
     };
 };
 
+/// Identifies a Block waiting to be validated, or for its missing transactions
+struct PendingBlock {
+    node_id_t miner;           ///< ID of node that mined the block
+    size_t height;             ///< Height of the block
+    bool fetching;             ///< True while the missing transactions are being fetched, false once queued for validation
+};
+
+/// The CPU of a node, which validates the received Blocks one at a time
+struct ValidationQueue {
+    simtime_t busy_until;          ///< Time at which the queued Blocks will have been validated
+    struct PendingBlock *pending;  ///< The queued Blocks
+    size_t pending_count;          ///< How many Blocks are actually queued
+    size_t pending_capacity;       ///< How many Blocks the @a pending array can hold before growing
+};
+
 /// Portion of the state dedicated to blockchain management
 struct BlockchainState {
     struct Blockchain chain;   /// The actual chain
     struct MiningState miningState;
+    struct ValidationQueue validation; /// Blocks received and waiting to be validated
     unsigned mined_by_me;      /// Count of Blocks produced by the node
 };
 
@@ -87,7 +126,7 @@ struct BlockchainState {
 struct ChainNode *getMainChain(const struct Blockchain *blockchain);
 
 /**
- * @brief Retrieves a Block starting from the chain
+ * @brief Retrieves a Block starting from the chain, in the format used to relay it
  *
  * @warning Caller owns the returned pointer and must free it when done
  *
@@ -95,9 +134,38 @@ struct ChainNode *getMainChain(const struct Blockchain *blockchain);
  * @param[in] miner ID of the block miner
  * @param[in] height the height of the ChainNode
  *
- * @return pointer to the Block if found
+ * @return pointer to the CompactBlock if found, NULL otherwise
  */
-struct Block *retrieveBlock(struct Blockchain *chain, node_id_t miner, size_t height);
+struct CompactBlock *retrieveBlock(struct Blockchain *chain, node_id_t miner, size_t height);
+
+/**
+ * @brief Calculates the size in Bytes of a CompactBlock
+ *
+ * @param[in] cblock the CompactBlock of which the size is required
+ */
+size_t sizeofCompactBlock(const struct CompactBlock *cblock);
+
+/**
+ * @brief Creates the CompactBlock used to relay a Block
+ *
+ * @warning Caller owns the returned pointer and must free it when done
+ *
+ * @param[in] block the Block to relay
+ *
+ * @return pointer to the newly created CompactBlock
+ */
+struct CompactBlock *compactBlock(const struct Block *block);
+
+/**
+ * @brief Rebuilds a Block from a CompactBlock
+ *
+ * @warning Caller owns the returned pointer and must free it when done
+ *
+ * @param[in] cblock the received CompactBlock
+ *
+ * @return pointer to the newly created and populated Block
+ */
+struct Block *blockFromCompact(const struct CompactBlock *cblock);
 
 /**
  * @brief Finds a ChainNode in the chain
@@ -128,10 +196,66 @@ struct Block *generateBlock(node_id_t me, simtime_t now, struct BlockchainState
  * @param block the block to validate
  * @param[out] is_valid will hold True if the block is considered valid
  *
- * @return The processing time needed to validate the block
+ * @return The processing time needed to validate the block, which grows with the number of included transactions
  */
 simtime_t validateBlock(const struct Block *block, bool *is_valid);
 
+/**
+ * @brief Queues a received Block for validation
+ *
+ * The Block is validated once the node has finished validating the Blocks queued before it.
+ *
+ * @param queue the validation queue of the node
+ * @param now the time at which the block is received
+ * @param cblock the block to validate
+ * @param[out] is_valid will hold True if the block is considered valid. Invalid blocks are not queued
+ *
+ * @return The time at which the node finishes validating the block
+ */
+simtime_t enqueueBlockValidation(struct ValidationQueue *queue, simtime_t now, const struct CompactBlock *cblock, bool *is_valid);
+
+/**
+ * @brief Marks a Block as waiting for its missing transactions, which are being fetched
+ *
+ * Marking a Block which is already pending has no effect. Enqueueing the Block for validation clears the mark.
+ *
+ * @param queue the validation queue of the node
+ * @param miner ID of the block miner
+ * @param height the height of the block
+ */
+void markBlockFetching(struct ValidationQueue *queue, node_id_t miner, size_t height);
+
+/**
+ * @brief Removes a validated Block from the validation queue
+ *
+ * @param queue the validation queue of the node
+ * @param miner ID of the block miner
+ * @param height the height of the block
+ */
+void dequeueBlockValidation(struct ValidationQueue *queue, node_id_t miner, size_t height);
+
+/**
+ * @brief Checks if a Block is waiting to be validated
+ *
+ * @param queue the validation queue of the node
+ * @param miner ID of the block miner
+ * @param height the height of the block
+ *
+ * @return true if the block is in the validation queue
+ */
+bool isBlockPendingValidation(const struct ValidationQueue *queue, node_id_t miner, size_t height);
+
+/**
+ * @brief Checks if a Block is waiting for its missing transactions
+ *
+ * @param queue the validation queue of the node
+ * @param miner ID of the block miner
+ * @param height the height of the block
+ *
+ * @return true if the block has been marked with markBlockFetching() and not enqueued for validation yet
+ */
+bool isBlockFetching(const struct ValidationQueue *queue, node_id_t miner, size_t height);
+
 /**
  * @brief The node receives a Block. Adds it to the local chain if valid
  * @param now the time at which the block is received
@@ -165,7 +289,7 @@ simtime_t getNextGenDelay(struct rng_t *rng, double hashPowerPortion);
  * @param hashPowerPortion The node's portion of hash power with respect to the entire network
  *
  * This selects a generation timestamp and schedules a retractable event.
- * The block is actually generated once the scheduled event is extracted.
+ * The block is actually generated once the scheduled event is extracted. Does nothing with proof of stake.
  */
 void scheduleNextBlockGeneration(simtime_t now, struct rng_t *rng, struct BlockchainState *state);
 
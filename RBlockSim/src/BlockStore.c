@@ -0,0 +1,162 @@
+#include "BlockStore.h"
+#include <string.h>
+
+/// An entry of the block store, followed in memory by the shared copy of the transactions of the block
+struct StoredTransactionData {
+    struct StoredTransactionData *next; ///< The next entry of the same height
+    node_id_t miner;                    ///< ID of node that mined the block
+};
+
+/// The entries of a replica at a height. Entries are only prepended to the list, until the height is released
+struct StoreLevel {
+    _Atomic(struct StoredTransactionData *) head; ///< The list of entries
+    _Atomic size_t height;                        ///< The height of the entries of the list
+    _Atomic unsigned holders;                     ///< The count of nodes which have not released the height yet
+};
+
+/// The entries of a replica
+struct StoreReplica {
+    struct StoreLevel levels[BLOCK_STORE_WINDOW]; ///< The entries of each height, indexed by height modulo the window
+    size_t horizons[N_NODES];                     ///< The height below which each node has released the entries
+};
+
+/**
+ * @brief Gets the transactions of an entry, stored right after it
+ *
+ * The size of the entry is a multiple of its alignment, which is the one of TransactionData as well.
+ */
+static struct TransactionData *storedData(struct StoredTransactionData *entry) {
+    return (struct TransactionData *) (entry + 1);
+}
+
+static struct StoreReplica *stores = NULL; ///< The entries of each replica
+static _Atomic size_t storedCount = 0;     ///< The count of entries held
+
+/**
+ * @brief Checks whether two TransactionData hold the same transactions. The unused bits of their bitmaps are ignored
+ */
+static bool sameTransactionData(const struct TransactionData *a, const struct TransactionData *b) {
+    return a->low == b->low && a->high == b->high && a->count == b->count && a->size == b->size &&
+           !memcmp(a->included_transactions, b->included_transactions, bitmap_required_size(a->high - a->low));
+}
+
+/**
+ * @brief Searches a list of entries for the transactions of a block
+ *
+ * @param first the first entry to check
+ * @param last the entry to stop at, excluded. NULL to check the whole list
+ * @param miner ID of the block miner
+ * @param data the transactions of the block
+ *
+ * @return The matching entry, NULL if not found
+ */
+static struct StoredTransactionData *findStored(struct StoredTransactionData *first, const struct StoredTransactionData *last,
+                                                node_id_t miner, const struct TransactionData *data) {
+    for (struct StoredTransactionData *e = first; e != last; e = e->next) {
+        if (e->miner == miner && sameTransactionData(storedData(e), data)) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Frees a list of entries
+ *
+ * @param e the first entry of the list
+ */
+static void freeStored(struct StoredTransactionData *e) {
+    while (e) {
+        struct StoredTransactionData *next = e->next;
+        free(e);
+        atomic_fetch_sub_explicit(&storedCount, 1, memory_order_relaxed);
+        e = next;
+    }
+}
+
+void initBlockStore() {
+    stores = malloc(replicas * sizeof(*stores));
+    if (!stores) {
+        fprintf(stderr, "Failed to allocate memory for the block store\n");
+        abort();
+    }
+    for (replica_id_t r = 0; r < replicas; r++) {
+        for (size_t h = 0; h < BLOCK_STORE_WINDOW; h++) {
+            struct StoreLevel *level = &stores[r].levels[h];
+            atomic_init(&level->head, NULL);
+            atomic_init(&level->height, h);
+            atomic_init(&level->holders, N_NODES);
+        }
+        memset(stores[r].horizons, 0, sizeof(stores[r].horizons));
+    }
+}
+
+void deinitBlockStore() {
+    if (!stores) {
+        return;
+    }
+    for (replica_id_t r = 0; r < replicas; r++) {
+        for (size_t h = 0; h < BLOCK_STORE_WINDOW; h++) {
+            freeStored(atomic_load_explicit(&stores[r].levels[h].head, memory_order_relaxed));
+        }
+    }
+    free(stores);
+    stores = NULL;
+}
+
+const struct TransactionData *storeTransactionData(node_id_t miner, size_t height, const struct TransactionData *data) {
+    struct StoreLevel *level = &stores[currentReplica].levels[height % BLOCK_STORE_WINDOW];
+    if (atomic_load_explicit(&level->height, memory_order_acquire) != height) {
+        fprintf(stderr, "storeTransactionData - Height %lu is more than %u heights past the lowest one still held.\n",
+                height, BLOCK_STORE_WINDOW);
+        abort();
+    }
+
+    struct StoredTransactionData *head = atomic_load_explicit(&level->head, memory_order_acquire);
+    struct StoredTransactionData *found = findStored(head, NULL, miner, data);
+    if (found) {
+        return storedData(found);
+    }
+
+    size_t data_size = sizeofTransactionData(data);
+    struct StoredTransactionData *entry = malloc(sizeof(*entry) + data_size);
+    if (!entry) {
+        fprintf(stderr, "Failed to allocate memory for the block store\n");
+        abort();
+    }
+    entry->miner = miner;
+    memcpy(storedData(entry), data, data_size);
+
+    entry->next = head;
+    while (!atomic_compare_exchange_weak_explicit(&level->head, &entry->next, entry, memory_order_release,
+                                                  memory_order_acquire)) {
+        // Other threads prepended their entries in the meantime, one of them may hold the same transactions
+        found = findStored(entry->next, head, miner, data);
+        if (found) {
+            free(entry);
+            return storedData(found);
+        }
+        head = entry->next;
+    }
+    atomic_fetch_add_explicit(&storedCount, 1, memory_order_relaxed);
+    return storedData(entry);
+}
+
+void releaseTransactionData(node_id_t node, size_t height) {
+    struct StoreReplica *store = &stores[currentReplica];
+    for (size_t h = store->horizons[node]; h < height; h++) {
+        struct StoreLevel *level = &store->levels[h % BLOCK_STORE_WINDOW];
+        if (atomic_fetch_sub_explicit(&level->holders, 1, memory_order_acq_rel) == 1) {
+            // No node of the replica can reach the entries anymore, the level is recycled for a higher height
+            freeStored(atomic_load_explicit(&level->head, memory_order_relaxed));
+            atomic_store_explicit(&level->head, NULL, memory_order_relaxed);
+            atomic_store_explicit(&level->holders, N_NODES, memory_order_relaxed);
+            atomic_store_explicit(&level->height, h + BLOCK_STORE_WINDOW, memory_order_release);
+        }
+        store->horizons[node] = h + 1;
+    }
+}
+
+size_t countStoredTransactionData() {
+    return atomic_load_explicit(&storedCount, memory_order_relaxed);
+}
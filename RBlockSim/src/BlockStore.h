@@ -0,0 +1,60 @@
+#pragma once
+
+#include "RBlockSim.h"
+#include "Transaction.h"
+
+/**
+ * Header for the block store.
+ * The transactions of each block are stored once per process and shared by all the nodes holding the block, which only
+ * keep a pointer to them. Entries are immutable and keyed by miner and height: since a rolled back miner may mine a
+ * different block at the same height, entries with the same key are told apart by their contents.
+ *
+ * Every node of a replica holds a reference to each height of the replica, released once the levels below it have been
+ * dropped from the chain of the node by a committed event. The entries of a height are freed along with its last
+ * reference, since no node can store nor read them anymore.
+ * */
+
+/// The count of consecutive heights of a replica the block store can hold. Entries are stored at most this many heights
+/// above the lowest height still referenced by some node of the replica
+#define BLOCK_STORE_WINDOW (1U << 12U)
+
+/**
+ * @brief Initializes the block store
+ */
+void initBlockStore();
+
+/**
+ * @brief Releases the block store. The simulation must be over, since every stored entry is released
+ */
+void deinitBlockStore();
+
+/**
+ * @brief Gets the shared copy of the transactions of a block of the replica being processed
+ *
+ * The copy is created if no node of the replica has stored the same transactions for the block yet. It is safe to call
+ * this concurrently from multiple threads.
+ *
+ * @param miner ID of the block miner
+ * @param height the height of the block
+ * @param data the transactions of the block
+ *
+ * @return A pointer to the shared copy, valid until every node of the replica has released @a height
+ */
+const struct TransactionData *storeTransactionData(node_id_t miner, size_t height, const struct TransactionData *data);
+
+/**
+ * @brief Releases the references of a node of the replica being processed to the heights below @a height
+ *
+ * The node must never store nor read again the entries of the released heights: this is the case once the event which
+ * dropped them from its chain is committed. Releasing heights already released has no effect. Only the thread hosting
+ * the node may call this.
+ *
+ * @param node ID of the node
+ * @param height the lowest height the node still references
+ */
+void releaseTransactionData(node_id_t node, size_t height);
+
+/**
+ * @brief Counts the entries held by the block store, across all the replicas
+ */
+size_t countStoredTransactionData();
@@ -8,7 +8,8 @@ struct simulation_configuration conf = {
         .log_level = LOG_DEBUG,
         .core_binding = true,
         .dispatcher = ProcessEvent,
-        .committed = CanEnd
+        .on_gvt = OnGvt,
+        .committed = NULL // The simulation ends when the GVT reaches the termination time
 };
 
 double BLOCK_INTERVAL = 13; //(10*60) // [seconds] Expected block time
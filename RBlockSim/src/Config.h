@@ -6,11 +6,20 @@
 #define REGIONS_NUM 6
 #define RNG_SEED 1234
 #define TERMINATION_TIME (60 * 60 * 24) // 24 hours
-#define TXN_NUMBER 500000
+#define TXN_NUMBER 500000 // The ramp arrival process creates a transaction every TXN_NUMBER / TERMINATION_TIME seconds
+#define TXN_MIN_SIZE 150 // [Bytes] Generated transactions sizes are uniform in [TXN_MIN_SIZE, TXN_MAX_SIZE]
+#define TXN_MAX_SIZE 650
+#define TXN_MEAN_FEE 10.0 // Mean of the exponentially distributed fees of generated transactions
+#define DEFAULT_TXN_RATE 7.0 // [transactions/second] Default rate of the Poisson arrival process
 #define BLOCK_SIZE 0.18 //0.8  // Mb
+#define BLOCK_MAX_BYTES ((size_t) (BLOCK_SIZE * 1000000 / 8)) // [Bytes] Transactions are selected into a block up to this size
 extern double BLOCK_INTERVAL; // [seconds] Expected block time
 
 #define BLOCK_VALIDATION_TIME 0.03 // [seconds] to validate a block
+#define TXN_VALIDATION_TIME 0.0002 // [seconds] to validate each transaction included in a block
+#define BLOCK_HEADER_SIZE 80 // [Bytes] Size of a block, on top of its transactions
+
+#define POS_SLOTS_PER_EPOCH 32 // Number of slots whose leaders are drawn from the same seed, in proof of stake
 
 #define DEPTH_TO_KEEP 200 // Maximum depth to keep blocks for. Blocks deeper than this, might get dropped
 
@@ -41,6 +41,7 @@ int getRegion(node_id_t node) {
  * @return Transmission delay
  */
 simtime_t getTransmissionDelay(node_id_t src, node_id_t dst, size_t data_size, struct rng_t *rng) {
+    (void) data_size; // Only the latency is modelled
     if (!rng) {
         return LATENCIES[getRegion(src)][getRegion(dst)];
     }
@@ -52,39 +53,37 @@ simtime_t getTransmissionDelay(node_id_t src, node_id_t dst, size_t data_size, s
  * @param sender The ID of the node sending the block
  * @param receiver The ID of the node receiving the block
  * @param send_time The time at which the block sending starts
- * @param block The Block itself
+ * @param cblock The Block itself, in its relayed format
  * @param rng Random Number Generator state
  * @param evt_type The event type for the message scheduling
  */
-void sendSingleBlock(node_id_t sender, node_id_t receiver, simtime_t send_time, struct Block *block, struct rng_t *rng,
-                     enum rblocksim_event evt_type) {
-    size_t event_size = sizeof(struct Block) + sizeofAdditionalTransactionDataBuffer(
-            block->transactionData.high - block->transactionData.low);
-    simtime_t delivery_time = send_time + getTransmissionDelay(sender, receiver, block->size, rng);
-    ScheduleNewEvent(receiver, delivery_time, evt_type, block, event_size);
+void sendSingleBlock(node_id_t sender, node_id_t receiver, simtime_t send_time, const struct CompactBlock *cblock,
+                     struct rng_t *rng, enum rblocksim_event evt_type) {
+    size_t event_size = sizeofCompactBlock(cblock);
+    simtime_t delivery_time = send_time + getTransmissionDelay(sender, receiver, cblock->size, rng);
+    ScheduleNewEvent(NODE_LP(receiver), delivery_time, evt_type, cblock, event_size);
 }
 
 /**
  * @brief Propagates a block via gossiping
  * @param sender The ID of the node sending the block
  * @param send_time The time at which the block sending starts
- * @param block The Block itself
+ * @param cblock The Block itself, in its relayed format
  * @param rng Random Number Generator state
  * @param peers The list of connected peers
  * @param n_peers The number of connected peers
  */
 void
-gossipBlock(node_id_t sender, simtime_t send_time, const struct Block *block, struct rng_t *rng, const node_id_t *peers,
-            size_t n_peers) {
-    size_t event_size = sizeof(struct Block) + sizeofAdditionalTransactionDataBuffer(
-            block->transactionData.high - block->transactionData.low);
+gossipBlock(node_id_t sender, simtime_t send_time, const struct CompactBlock *cblock, struct rng_t *rng,
+            const node_id_t *peers, size_t n_peers) {
+    size_t event_size = sizeofCompactBlock(cblock);
 
     // From the list of connected nodes, select a random subset of nodes to send the block to, and send it to them
-    if (!GOSSIP_FANOUT || n_peers <= GOSSIP_FANOUT || block->miner == sender) {
+    if (!GOSSIP_FANOUT || n_peers <= GOSSIP_FANOUT || cblock->miner == sender) {
         // If the fanout is not bigger than the number of peers, send to all
         for (size_t i = 0; i < n_peers; i++) {
-            simtime_t delivery_time = send_time + getTransmissionDelay(sender, peers[i], block->size, rng);
-            ScheduleNewEvent(peers[i], delivery_time, RECEIVE_BLOCK, block, event_size);
+            simtime_t delivery_time = send_time + getTransmissionDelay(sender, peers[i], cblock->size, rng);
+            ScheduleNewEvent(NODE_LP(peers[i]), delivery_time, RECEIVE_BLOCK, cblock, event_size);
         }
     } else {
         // Otherwise, select a random subset of nodes. Do not select the same node twice.
@@ -96,8 +95,8 @@ gossipBlock(node_id_t sender, simtime_t send_time, const struct Block *block, st
                 selected_peer = (node_id_t) RandomRange(rng, 0, (int) n_peers - 1);
             }
             bitmap_set(selected, selected_peer);
-            simtime_t delivery_time = send_time + getTransmissionDelay(sender, peers[selected_peer], block->size, rng);
-            ScheduleNewEvent(peers[selected_peer], delivery_time, RECEIVE_BLOCK, block, event_size);
+            simtime_t delivery_time = send_time + getTransmissionDelay(sender, peers[selected_peer], cblock->size, rng);
+            ScheduleNewEvent(NODE_LP(peers[selected_peer]), delivery_time, RECEIVE_BLOCK, cblock, event_size);
         }
         free(selected);
     }
@@ -105,17 +104,16 @@ gossipBlock(node_id_t sender, simtime_t send_time, const struct Block *block, st
     // Other changes that need to be done: when a block without parent is received, keep it but ask for the parent from the sender node
 }
 
-void send_to_everyone(node_id_t sender, simtime_t send_time, struct Block *block, struct NodeState *state) {
+void send_to_everyone(node_id_t sender, simtime_t send_time, const struct CompactBlock *cblock, struct NodeState *state) {
     simtime_t max_d_time = 0;
-    size_t event_size = sizeof(struct Block) + sizeofAdditionalTransactionDataBuffer(
-            block->transactionData.high - block->transactionData.low);
-    for (int d = 0; d < conf.lps; d++) {
+    size_t event_size = sizeofCompactBlock(cblock);
+    for (node_id_t d = 0; d < N_NODES; d++) {
         if (d == sender) {
             continue;
         }
-        simtime_t delivery_time = send_time + getTransmissionDelay(sender, d, block->size, state->rng);
+        simtime_t delivery_time = send_time + getTransmissionDelay(sender, d, cblock->size, state->rng);
         max_d_time = max_d_time > delivery_time ? max_d_time : delivery_time;
-        ScheduleNewEvent(d, delivery_time, RECEIVE_BLOCK, block, event_size);
+        ScheduleNewEvent(NODE_LP(d), delivery_time, RECEIVE_BLOCK, cblock, event_size);
     }
 }
 
@@ -123,11 +121,12 @@ void send_to_everyone(node_id_t sender, simtime_t send_time, struct Block *block
  * @brief Propagates the newly generated block with the chosen approach
  * @param sender The ID of the node generating the block
  * @param send_time The time at which the block sending starts
- * @param block Pointer to the created Block
+ * @param cblock Pointer to the created Block, in its relayed format
  * @param rng Random number generator state
  *
  * Takes care of propagating the block to OTHER NODES using the chosen propagation algorithm
  */
-void propagateBlock(node_id_t sender, simtime_t send_time, const struct Block *block, struct rng_t *rng) {
-    gossipBlock(sender, send_time, block, rng, peer_lists[sender], peer_list_sizes[sender]);
+void propagateBlock(node_id_t sender, simtime_t send_time, const struct CompactBlock *cblock, struct rng_t *rng) {
+    // Blocks are relayed by their header and transaction ids, the receivers have most of the transactions already
+    gossipBlock(sender, send_time, cblock, rng, peer_lists[sender], peer_list_sizes[sender]);
 }
@@ -1,10 +1,13 @@
 #include "RBlockSim.h"
 #include "Block.h"
+#include "BlockStore.h"
 #include "Network.h"
 #include "Node.h"
 #include "Transaction.h"
 #include "Statistics.h"
 #include "Attacks.h"
+#include "Stake.h"
+#include "util.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -21,28 +24,79 @@ char old_stats_folder[256] = "results_0/";
 char *old_stats_filename = "stats_%07d.json";
 char *stats_extension = "_%07d.json";
 
-char single_stats_fullpath[2048] = "";
-char single_stats_filename[1024] = "stats_sz%lu_w%lu_bi%lf_a%s_h%lf_c%u_d%u_rng%u.json";
+char single_stats_filename[1024] = "stats_sz%lu_w%lu_bi%lf_a%s_h%lf_c%u_d%u_rng%u.bin";
+char *json_stats_extension = ".json";
+bool json_stats = false; // If set, the per-node statistics are exported in JSON format as well
 char stats_folder_long[1024] = "Results_sz%lu_w%lu_bi%lf_a%s_h%lf_c%u_d%u_rng%u_%d/";
 
-char single_stats_metadata_fullpath[2048] = "";
+char detailed_stats_prefix[2048] = "";
+char *detailed_stats_filename = "blocks";
 
 __thread node_id_t currentNode = 0;
+__thread replica_id_t currentReplica = 0;
 
-struct SelfishStatsState *selfishStats = NULL;
+replica_id_t replicas = 1; // The number of independent replicas of the network simulated together
+
+bool statelessRng = false; // If set, the random numbers of each event are drawn from a stream derived from the event itself
+struct rng_t *eventRngs = NULL; // The stateless streams of the events, one per LP. They are not part of the LP state
+
+// The statistics folder and file of each replica
+struct ReplicaStatsPaths {
+    char folder[2048];
+    char file[2048];
+};
+struct ReplicaStatsPaths *replicaStatsPaths = NULL;
+
+struct SelfishStatsResults *selfishResults = NULL; // The per-node statistics of each replica
+
+char *sweep_file = NULL; // If set, the runs listed in this file are executed back to back in this process
+
+// The defaults of the run options, restored before parsing the options of each run of a sweep
+struct simulation_configuration default_conf;
+double default_block_interval;
 
 char *attack_metadata_filename = "attack_info.json";
 char attack_metadata_format[] = "{\n\"attack_type\":\"%s\",\"attacker\":%u,\"attacker_hashpower\":%lf,\"depth\":%u,\"catchup_tolerance\":%u,\"failed_attacks\":%u,\"successful_conceals\":%u\n}\n";
 
-void requestParent(lp_id_t requester, simtime_t request_time, struct NodeState *node_state, const struct Block *block) {
+/**
+ * @brief Requests a block from a peer
+ *
+ * @param requester The ID of the node requesting the block
+ * @param request_time The time at which the request is sent
+ * @param node_state The state of the requesting node
+ * @param peer The ID of the node the block is requested from
+ * @param miner ID of the block miner
+ * @param height The height of the block
+ * @param transactions True if the requester already has the block header and is only missing some of its transactions
+ */
+void requestBlock(lp_id_t requester, simtime_t request_time, struct NodeState *node_state, node_id_t peer,
+                  node_id_t miner, size_t height, bool transactions) {
     struct request_block_evt *evt = malloc(sizeof(struct request_block_evt));
     evt->requester = requester;
-    evt->miner = block->prevBlockMiner;
-    evt->height = block->height - 1;
-    ScheduleNewEvent(block->sender, request_time + getTransmissionDelay(requester, block->sender, 0, node_state->rng), REQUEST_BLOCK, evt, sizeof(struct request_block_evt));
+    evt->miner = miner;
+    evt->height = height;
+    evt->transactions = transactions;
+    ScheduleNewEvent(NODE_LP(peer), request_time + getTransmissionDelay(requester, peer, 0, node_state->rng), REQUEST_BLOCK, evt, sizeof(struct request_block_evt));
     free(evt);
 }
 
+/**
+ * @brief Queues a received block for validation, then schedules its handling
+ *
+ * @param lp The LP simulating the node
+ * @param now The time at which the whole block is available to the node
+ * @param node_state The state of the node
+ * @param cblock The received block
+ */
+void queueBlockValidation(lp_id_t lp, simtime_t now, struct NodeState *node_state, const struct CompactBlock *cblock) {
+    // The node validates the received blocks one at a time, then handles them
+    bool valid;
+    simtime_t validated_time = enqueueBlockValidation(&node_state->blockchainState.validation, now, cblock, &valid);
+    if (valid) {
+        ScheduleNewEvent(lp, validated_time, BLOCK_VALIDATED, cblock, sizeofCompactBlock(cblock));
+    }
+}
+
 /**
  * @brief Propagates a block and N of its ancestors
  *
@@ -57,7 +111,7 @@ void propagateBlockAndNAncestors(struct Blockchain *chain, node_id_t sender, sim
     // Get the block's ancestors and propagate them
     for (size_t i = 1; i < n_ancestors; i++) {
         size_t height = block->height - n_ancestors + i;
-        struct Block *retrieved_block = retrieveBlock(chain, block->miner, height);
+        struct CompactBlock *retrieved_block = retrieveBlock(chain, block->miner, height);
         if (!retrieved_block) {
             fprintf(stderr, "Block at height %lu (%luth ancestor of block at height %lu) not found in the chain\n", height, n_ancestors - i, block->height);
             abort();
@@ -67,17 +121,28 @@ void propagateBlockAndNAncestors(struct Blockchain *chain, node_id_t sender, sim
         free(retrieved_block);
         send_time += 0.002;
     }
-    propagateBlock(sender, send_time, block, rng);
+    struct CompactBlock *cblock = compactBlock(block);
+    propagateBlock(sender, send_time, cblock, rng);
+    free(cblock);
 }
 
-void ProcessEvent(lp_id_t me, simtime_t now, unsigned event_type, const void *event_content, unsigned event_size,
+void ProcessEvent(lp_id_t lp, simtime_t now, unsigned event_type, const void *event_content, unsigned event_size,
                   void *v_state) {
+    (void) event_size; // The size of the content of each event is implied by its type
+    // The LPs of each replica simulate the same network, so the model works with node IDs local to the replica
+    currentReplica = lp / N_NODES;
+    node_id_t me = lp % N_NODES;
+    currentNode = me;
     struct NodeState *state = (struct NodeState *) v_state;
     struct AttackerNodeState *attackerState = is_attacker(me) ? (struct AttackerNodeState *) v_state : NULL;
-    currentNode = me;
 
-    if (now > conf.termination_time && event_type != LP_FINI) {
-        return;
+    if (statelessRng && event_type != LP_FINI) {
+        // The stream only depends on the node, the event type and the event time, so that it needs no checkpointing and
+        // a rolled back event draws the same numbers when it is processed again
+        uint64_t time_bits;
+        memcpy(&time_bits, &now, sizeof(time_bits));
+        initialize_counter_stream(rng_seed + currentReplica, RNG_STREAM(RNG_STREAM_EVENT, (uint64_t) event_type << 32 | me),
+                                  time_bits, &eventRngs[lp]);
     }
 
     switch (event_type) {
@@ -95,13 +160,16 @@ void ProcessEvent(lp_id_t me, simtime_t now, unsigned event_type, const void *ev
                 new_state = rs_malloc(sizeof(struct NodeState));
             }
 
-            // Init RNG
-            new_state->rng = rs_malloc(sizeof(struct rng_t));
-            initialize_stream(RNG_SEED + me, new_state->rng);
+            // Init RNG. Replica r draws the same numbers as a standalone run with seed rng_seed + r
+            if (statelessRng) {
+                new_state->rng = &eventRngs[lp];
+            } else {
+                new_state->rng = rs_malloc(sizeof(struct rng_t));
+                initialize_counter_stream(rng_seed + currentReplica, RNG_STREAM(RNG_STREAM_NODE, me), 0, new_state->rng);
+            }
 
             //printf("[N %lu] INIT - HashPower %lu\tTotalHP %lu\n", me, new_state->hashPower, totalHashPower.hashpower_atomic);
 
-            initNetwork();
             if (is_attacker(me)) {
                 attackerInitBlockchainState(&new_state->blockchainState, new_state->rng);
             } else {
@@ -129,12 +197,12 @@ void ProcessEvent(lp_id_t me, simtime_t now, unsigned event_type, const void *ev
             SetState(new_state);
 
             // Generate internal init event
-            ScheduleNewEvent(me, now, RBLOCKSIM_INIT, NULL, 0);
+            ScheduleNewEvent(lp, now, RBLOCKSIM_INIT, NULL, 0);
             return;
         }
         case LP_FINI: {
             atomic_fetch_add_explicit(&(tot_mined), state->blockchainState.mined_by_me, memory_order_relaxed);
-            if (me == N_NODES - 1) {
+            if (lp == conf.lps - 1) {
                 printf("Total mined blocks: %lu\n", tot_mined); // This does not work because not all other LPs are guaranteed to have finished
                 printf("Height: %lu\n", state->blockchainState.chain.height);
             }
@@ -142,7 +210,7 @@ void ProcessEvent(lp_id_t me, simtime_t now, unsigned event_type, const void *ev
             if (is_attacker(me) && (attackConfig.type == ATTACK_FIFTY_ONE || attackConfig.type == ATTACK_SELFISH_MINING)) {
                 // Print attack metadata in json format
                 char filename[2048];
-                strcpy(filename, single_stats_metadata_fullpath);
+                strcpy(filename, replicaStatsPaths[currentReplica].folder);
                 sprintf(filename + strlen(filename), "%s", attack_metadata_filename);
                 FILE *file = fopen(filename, "w");
                 if (!file) {
@@ -164,11 +232,12 @@ void ProcessEvent(lp_id_t me, simtime_t now, unsigned event_type, const void *ev
             }
 
             if (statsType == STATS_SELFISH) {
-                copySelfishStatisticsState(&selfishStats[me], &state->statsState.selfishStats);
+                storeSelfishStatsResults(&selfishResults[currentReplica], me, &state->statsState.selfishStats);
             }
 
-            rs_free(state->rng);
-            deinitNetwork();
+            if (!statelessRng) {
+                rs_free(state->rng);
+            }
             deinitBlockchainState(&state->blockchainState);
             deinitTransactionState(&state->transactionState);
             deinitStatisticsState(&state->statsState);
@@ -181,8 +250,15 @@ void ProcessEvent(lp_id_t me, simtime_t now, unsigned event_type, const void *ev
             } else {
                 afterInitBlockchainState(&state->blockchainState);
             }
+            if (proposalPolicy == PROPOSAL_POS) {
+                scheduleFirstProposal(me);
+            }
             break;
         }
+        case PROPOSE_BLOCK:
+            // The node leads this slot. Schedule the proposal for its next one, then produce the block like a miner
+            scheduleNextProposal(me, *(const size_t *) event_content);
+            // fallthrough
         case GENERATE_BLOCK: {
             struct Block *b = generateBlock(me, now, &state->blockchainState, &state->transactionState, &state->statsState);
 
@@ -225,58 +301,95 @@ void ProcessEvent(lp_id_t me, simtime_t now, unsigned event_type, const void *ev
                     }
                 }
             } else {
-                propagateBlock(me, now, b, state->rng);
+                struct CompactBlock *cblock = compactBlock(b);
+                propagateBlock(me, now, cblock, state->rng);
+                free(cblock);
             }
 
             if (statsType == STATS_DETAILED) {
-                statsMineBlockDetailed(&state->statsState, me, b->height, now);
+                statsMineBlockDetailed(me, b->height, now);
             } else if (statsType == STATS_SELFISH) {
                 statsMineBlockSelfish(&state->statsState);
             }
+            free(b);
             break;
         }
         case RECEIVE_BLOCK: {
-            struct Block *b = (struct Block *) event_content;
-            //printf("[N %lu - t %lf] Block received. Miner %lu Depth %d\n", me, now, b->miner, b->height);
-            struct ChainNode *seeked_node = findChainNode(&state->blockchainState.chain, b->miner, b->height);
+            const struct CompactBlock *cb = (const struct CompactBlock *) event_content;
+            //printf("[N %lu - t %lf] Block received. Miner %lu Depth %d\n", me, now, cb->miner, cb->height);
+            struct ChainNode *seeked_node = findChainNode(&state->blockchainState.chain, cb->miner, cb->height);
             if (seeked_node) { // Block already received
                 if (isOrphan(seeked_node)) { // If it is an orphan, request the parent
-                    requestParent(me, now, state, b);
+                    requestBlock(me, now, state, cb->sender, cb->prevBlockMiner, cb->height - 1, false);
                 }
                 return;
             }
-            if (statsType == STATS_DETAILED) {
-                statsReceiveBlockDetailed(&state->statsState, b->miner, b->height, now);
+            if (isBlockPendingValidation(&state->blockchainState.validation, cb->miner, cb->height)) {
+                return; // Block already waiting to be validated
+            }
+            // A block waiting for its missing transactions is announced again: the peer asked for them may not hold the
+            // block anymore, so the transactions are checked again and, if still missing, requested from this sender too
+            bool fetching = isBlockFetching(&state->blockchainState.validation, cb->miner, cb->height);
+            if (statsType == STATS_DETAILED && !fetching) {
+                statsReceiveBlockDetailed(cb->miner, cb->height, now);
+            }
+
+            // The block is relayed by its header and transaction ids. If some of them have not reached the node yet,
+            // fetch them from the sender before validating it
+            if (countUnknownTransactions(&state->transactionState, cb->txn_ids, cb->txn_count, now, getRegion(me))) {
+                markBlockFetching(&state->blockchainState.validation, cb->miner, cb->height);
+                requestBlock(me, now, state, cb->sender, cb->miner, cb->height, true);
+                return;
+            }
+            queueBlockValidation(lp, now, state, cb);
+            return;
+        }
+        case RECEIVE_BLOCK_TRANSACTIONS: {
+            // The sender answered with the transactions the node was missing. The block may have been queued already,
+            // thanks to the answer of another peer or to the transactions reaching the node in the meantime
+            const struct CompactBlock *cb = (const struct CompactBlock *) event_content;
+            if (isBlockFetching(&state->blockchainState.validation, cb->miner, cb->height)) {
+                queueBlockValidation(lp, now, state, cb);
             }
+            return;
+        }
+        case BLOCK_VALIDATED: {
+            const struct CompactBlock *cb = (const struct CompactBlock *) event_content;
+            dequeueBlockValidation(&state->blockchainState.validation, cb->miner, cb->height);
+            struct Block *b = blockFromCompact(cb);
 
             bool updated_mainchain = false;
             bool found_parent = false;
             receiveBlock(now, &state->blockchainState, &state->transactionState, b, me, &state->statsState, &updated_mainchain, &found_parent);
             if (!found_parent) {
                 // Request the parent block
-                requestParent(me, now, state, b);
+                requestBlock(me, now, state, b->sender, b->prevBlockMiner, b->height - 1, false);
             }
 
-            node_id_t old_sender = b->sender;
-            b->sender = me;
-            propagateBlock(me, now, b, state->rng);
-            b->sender = old_sender;
-
-            if (!updated_mainchain) {
-                return;
-            }
+            // Relay the block as it has been received
+            struct CompactBlock *relayed = malloc(sizeofCompactBlock(cb));
+            memcpy(relayed, cb, sizeofCompactBlock(cb));
+            relayed->sender = me;
+            propagateBlock(me, now, relayed, state->rng);
+            free(relayed);
+
+            if (updated_mainchain) {
+                if (b->is_attack_block) {
+                    // I received an attack block and switched to the attacker's chain
+                    if (statsType == STATS_SELFISH) {
+                        statsSwitchToSelfishChain(&state->statsState);
+                    }
+                }
 
-            if (b->is_attack_block) {
-                // I received an attack block and switched to the attacker's chain
-                if (statsType == STATS_SELFISH) {
-                    statsSwitchToSelfishChain(&state->statsState);
+                if (is_attacker(me)) {
+                    attackerState->last_propagated_height = b->height;
                 }
             }
+            free(b);
 
-            if (is_attacker(me)) {
-                attackerState->last_propagated_height = b->height;
+            if (!updated_mainchain) {
+                return;
             }
-
             break;
         }
         case REQUEST_BLOCK: {
@@ -284,11 +397,12 @@ void ProcessEvent(lp_id_t me, simtime_t now, unsigned event_type, const void *ev
             // Identified by using height and miner
             struct request_block_evt *evt = (struct request_block_evt *) event_content;
             // Find the Block from the blockchain
-            struct Block *block = retrieveBlock(&state->blockchainState.chain, evt->miner, evt->height);
+            struct CompactBlock *block = retrieveBlock(&state->blockchainState.chain, evt->miner, evt->height);
             if (!block) return;
             block->sender = me;
             // Send the block
-            sendSingleBlock(me, evt->requester, now, block, state->rng, RECEIVE_BLOCK);
+            sendSingleBlock(me, evt->requester, now, block, state->rng,
+                            evt->transactions ? RECEIVE_BLOCK_TRANSACTIONS : RECEIVE_BLOCK);
             free(block);
             return;
         }
@@ -301,7 +415,14 @@ void ProcessEvent(lp_id_t me, simtime_t now, unsigned event_type, const void *ev
     scheduleNextBlockGeneration(now, state->rng, &state->blockchainState);
 }
 
-bool CanEnd(lp_id_t me, const void *snapshot) { return false; }
+void OnGvt(lp_id_t lp, simtime_t gvt, const void *v_state) {
+    currentReplica = lp / N_NODES;
+    const struct Blockchain *chain = &((const struct NodeState *) v_state)->blockchainState.chain;
+    // The levels below the minimum height are dropped for good once the event which dropped them is committed
+    if (chain->min_height_time < gvt) {
+        releaseTransactionData(lp % N_NODES, chain->min_height);
+    }
+}
 
 #ifndef TESTING
 void handle_options(int argc, char **argv) {
@@ -312,8 +433,9 @@ void handle_options(int argc, char **argv) {
     bool depth_set = false;
     size_t opt_catchup_tolerance = 0;
     bool catchup_tolerance_set = false;
+    bool detailed_stats = false;
 
-    while ((opt = getopt(argc, argv, "a:c:d:h:i:o:r:s:w:")) != -1) {
+    while ((opt = getopt(argc, argv, "a:bc:d:e:f:g:h:i:jk:l:m:no:p:r:s:t:u:w:x:S")) != -1) {
         switch (opt) {
             case 'w':
             {
@@ -321,6 +443,13 @@ void handle_options(int argc, char **argv) {
                 printf("Threads set to: %d\n", conf.n_threads);
                 break;
             }
+            case 'S':
+            {
+                // Run the simulation on the sequential runtime, which is faster for small networks
+                conf.serial = true;
+                printf("Sequential simulation enabled\n");
+                break;
+            }
             case 'i':
             {
                 // Read BLOCK_INTERVAL from command line. It is a double
@@ -328,6 +457,50 @@ void handle_options(int argc, char **argv) {
                 printf("Block interval set to: %lf\n", BLOCK_INTERVAL);
                 break;
             }
+            case 'j':
+            {
+                // Export the per-node statistics in JSON format too, besides the columnar binary file
+                json_stats = true;
+                printf("JSON statistics export enabled\n");
+                break;
+            }
+            case 'k':
+            {
+                // Read the block proposal policy from command line
+                if (strcmp(optarg, "pow") == 0) {
+                    proposalPolicy = PROPOSAL_POW;
+                } else if (strcmp(optarg, "pos") == 0) {
+                    proposalPolicy = PROPOSAL_POS;
+                } else {
+                    fprintf(stderr, "Unknown block proposal policy: %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                printf("Block proposal policy set to: %s\n", optarg);
+                break;
+            }
+            case 'l':
+            {
+                // Read the checkpointing engine from command line
+                conf.ckpt_cow = false;
+                conf.ckpt_compress = false;
+                if (strcmp(optarg, "cow") == 0) {
+                    conf.ckpt_cow = true;
+                } else if (strcmp(optarg, "delta") == 0) {
+                    conf.ckpt_compress = true;
+                } else if (strcmp(optarg, "copy") != 0) {
+                    fprintf(stderr, "Unknown checkpointing engine: %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                printf("Checkpointing engine set to: %s\n", optarg);
+                break;
+            }
+            case 'm':
+            {
+                // Read the memory budget in MiB from command line. It is an unsigned int
+                conf.mem_budget = strtoul(optarg, NULL, 10);
+                printf("Memory budget set to: %u MiB\n", conf.mem_budget);
+                break;
+            }
             case 'a':
             {
                 // Read ATTACK_TYPE from command line. It is a string
@@ -345,6 +518,41 @@ void handle_options(int argc, char **argv) {
                 }
                 break;
             }
+            case 'b': {
+                // Track every block received and mined by each node. The records are written by ROOT-Sim once committed
+                detailed_stats = true;
+                printf("Detailed block statistics enabled\n");
+                break;
+            }
+            case 'e': {
+                // Read the number of replicas from command line. It is an unsigned int
+                long opt_replicas = strtol(optarg, NULL, 10);
+                if (opt_replicas < 1 || opt_replicas > UINT32_MAX / N_NODES) {
+                    fprintf(stderr, "Invalid replicas count: %s. It must be between 1 and %u.\n", optarg, UINT32_MAX / N_NODES);
+                    exit(EXIT_FAILURE);
+                }
+                replicas = opt_replicas;
+                printf("Replicas set to: %u\n", replicas);
+                break;
+            }
+            case 'f': {
+                // Read the path of the sweep file from command line. It is a string
+                sweep_file = optarg;
+                break;
+            }
+            case 'g': {
+                // Read the fork choice rule of the honest nodes from command line
+                if (strcmp(optarg, "longest") == 0) {
+                    forkChoice = FORK_CHOICE_LONGEST;
+                } else if (strcmp(optarg, "ghost") == 0) {
+                    forkChoice = FORK_CHOICE_GHOST;
+                } else {
+                    fprintf(stderr, "Unknown fork choice rule: %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                printf("Fork choice rule set to: %s\n", optarg);
+                break;
+            }
             case 'h': {
                 // Read attacker's portion of hash power from command line. It is a double
                 opt_hashpower = atof(optarg);
@@ -380,6 +588,13 @@ void handle_options(int argc, char **argv) {
                 }
                 break;
             }
+            case 'n':
+            {
+                // Draw the random numbers of each event from a stream derived from the event, instead of a per-node one
+                statelessRng = true;
+                printf("Stateless random number generation enabled\n");
+                break;
+            }
             case 'o':
             {
                 // Allocate memory for the filename and a `.json` extension
@@ -394,6 +609,14 @@ void handle_options(int argc, char **argv) {
                 //printf("Output file set to: %s\n", old_stats_filename);
                 break;
             }
+            case 'p':
+            {
+                // Read the path of the ROOT-Sim profiling statistics file from command line. It is a string
+                conf.stats_file = optarg;
+                conf.stats_profile = true;
+                printf("Profiling statistics file set to: %s\n", conf.stats_file);
+                break;
+            }
             case 'r':
             {
                 // Read RNG_SEED from command line. It is an unsigned long
@@ -401,14 +624,73 @@ void handle_options(int argc, char **argv) {
                 printf("RNG seed set to: %u\n", rng_seed);
                 break;
             }
+            case 't':
+            {
+                // Read the live telemetry endpoint from command line. It is a string
+                conf.telemetry_endpoint = optarg;
+                printf("Telemetry endpoint set to: %s\n", conf.telemetry_endpoint);
+                break;
+            }
+            case 'u':
+            {
+                // Read the simulated duration in seconds from command line. It is a double
+                conf.termination_time = atof(optarg);
+                if (conf.termination_time <= 0.0) {
+                    fprintf(stderr, "Invalid simulated duration: %s. It must be greater than 0.0.\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                printf("Simulated duration set to: %lf\n", conf.termination_time);
+                break;
+            }
+            case 'x':
+            {
+                // Read the transactions arrival process from command line
+                if (strcmp(optarg, "ramp") == 0) {
+                    txnArrivalConfig.type = TXN_ARRIVAL_RAMP;
+                } else if (strncmp(optarg, "poisson", 7) == 0) {
+                    txnArrivalConfig.type = TXN_ARRIVAL_POISSON;
+                    txnArrivalConfig.rate = optarg[7] == ':' ? atof(optarg + 8) : DEFAULT_TXN_RATE;
+                    if (txnArrivalConfig.rate <= 0) {
+                        fprintf(stderr, "Invalid transactions rate: %s\n", optarg);
+                        exit(EXIT_FAILURE);
+                    }
+                } else if (strncmp(optarg, "trace:", 6) == 0) {
+                    txnArrivalConfig.type = TXN_ARRIVAL_TRACE;
+                    txnArrivalConfig.traceFile = optarg + 6;
+                } else {
+                    fprintf(stderr, "Unknown transactions arrival process: %s\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                printf("Transactions arrival process set to: %s\n", optarg);
+                break;
+            }
             default:
             {
-                fprintf(stderr, "Usage: %s [-w thread_count] [-i block_interval (seconds)] [-a attack_type in {51, selfish} [-h percentage of network total hash power for the attacker] [-d depth of attack for selfish mining] [-s start time of attack for selfish mining] [-c maximum depth the node can lag behind before switching chains to one on which it has mined fewer blocks]] [-o statistics_output_filename] [-r rng_seed]\n", argv[0]);
+                fprintf(stderr, "Usage: %s [-S] [-w thread_count] [-i block_interval (seconds)] [-b] [-j] [-e replicas] [-f sweep_file] [-g longest|ghost] [-k pow|pos] [-x ramp|poisson:rate|trace:file] [-a attack_type in {51, selfish} [-h percentage of network total hash power for the attacker] [-d depth of attack for selfish mining] [-s start time of attack for selfish mining] [-c maximum depth the node can lag behind before switching chains to one on which it has mined fewer blocks]] [-m memory_budget (MiB)] [-n] [-o statistics_output_filename] [-p profiling_statistics_filename] [-r rng_seed] [-t telemetry_endpoint] [-u simulated_duration (seconds)]\n", argv[0]);
                 exit(EXIT_FAILURE);
             }
         }
     }
 
+    if (conf.serial) { // The sequential runtime ignores the thread count
+        conf.n_threads = 1;
+    }
+
+    if (detailed_stats) {
+        if (attackConfig.type != ATTACK_NONE) {
+            fprintf(stderr, "Detailed block statistics are not available together with attacks!\n");
+            exit(EXIT_FAILURE);
+        }
+        if (replicas > 1) {
+            fprintf(stderr, "Detailed block statistics are not available together with replicas!\n");
+            exit(EXIT_FAILURE);
+        }
+        setStatsType(STATS_DETAILED);
+    }
+
+    // Replica r is simulated by the LPs [r * N_NODES, (r + 1) * N_NODES)
+    conf.lps = (lp_id_t) replicas * N_NODES;
+
     if (opt_hashpower == -1.0) { // Attacker hash power not specified
         switch (attackConfig.type) {
             case ATTACK_FIFTY_ONE:
@@ -501,85 +783,143 @@ void handle_options(int argc, char **argv) {
     }
 }
 
-size_t formatStatsFolder(char *dest, int folder_num, size_t maxlen) {
+size_t formatStatsFolder(char *dest, unsigned int seed, int folder_num, size_t maxlen) {
     switch (attackConfig.type) {
         case ATTACK_FIFTY_ONE:
-            return snprintf(dest, maxlen, stats_folder_long, conf.lps, conf.n_threads, BLOCK_INTERVAL, "51", attackConfig.fiftyOne.hashPowerPortion, attackConfig.fiftyOne.catchupTolerance, 0, rng_seed, folder_num);
+            return snprintf(dest, maxlen, stats_folder_long, (size_t) N_NODES, conf.n_threads, BLOCK_INTERVAL, "51", attackConfig.fiftyOne.hashPowerPortion, attackConfig.fiftyOne.catchupTolerance, 0, seed, folder_num);
         case ATTACK_SELFISH_MINING:
-            return snprintf(dest, maxlen, stats_folder_long, conf.lps, conf.n_threads, BLOCK_INTERVAL, "selfish", attackConfig.selfish.hashPowerPortion, attackConfig.selfish.catchupTolerance, attackConfig.selfish.depth, rng_seed, folder_num);
+            return snprintf(dest, maxlen, stats_folder_long, (size_t) N_NODES, conf.n_threads, BLOCK_INTERVAL, "selfish", attackConfig.selfish.hashPowerPortion, attackConfig.selfish.catchupTolerance, attackConfig.selfish.depth, seed, folder_num);
         default:
-            return snprintf(dest, maxlen, stats_folder_long, conf.lps, conf.n_threads, BLOCK_INTERVAL, "none", 0.0, 0, 0, rng_seed, folder_num);
+            return snprintf(dest, maxlen, stats_folder_long, (size_t) N_NODES, conf.n_threads, BLOCK_INTERVAL, "none", 0.0, 0, 0, seed, folder_num);
     }
 }
 
-size_t formatStatsFile(char *dest, size_t maxlen) {
+size_t formatStatsFile(char *dest, unsigned int seed, size_t maxlen) {
     switch (attackConfig.type) {
         case ATTACK_FIFTY_ONE:
-            return snprintf(dest, maxlen, single_stats_filename, conf.lps, conf.n_threads, BLOCK_INTERVAL, "51", attackConfig.fiftyOne.hashPowerPortion, attackConfig.fiftyOne.catchupTolerance, 0, rng_seed);
+            return snprintf(dest, maxlen, single_stats_filename, (size_t) N_NODES, conf.n_threads, BLOCK_INTERVAL, "51", attackConfig.fiftyOne.hashPowerPortion, attackConfig.fiftyOne.catchupTolerance, 0, seed);
         case ATTACK_SELFISH_MINING:
-            return snprintf(dest, maxlen, single_stats_filename, conf.lps, conf.n_threads, BLOCK_INTERVAL, "selfish", attackConfig.selfish.hashPowerPortion, attackConfig.selfish.catchupTolerance, attackConfig.selfish.depth, rng_seed);
+            return snprintf(dest, maxlen, single_stats_filename, (size_t) N_NODES, conf.n_threads, BLOCK_INTERVAL, "selfish", attackConfig.selfish.hashPowerPortion, attackConfig.selfish.catchupTolerance, attackConfig.selfish.depth, seed);
         default:
-            return snprintf(dest, maxlen, single_stats_filename, conf.lps, conf.n_threads, BLOCK_INTERVAL, "none", 0.0, 0, 0, rng_seed);
+            return snprintf(dest, maxlen, single_stats_filename, (size_t) N_NODES, conf.n_threads, BLOCK_INTERVAL, "none", 0.0, 0, 0, seed);
     }
 }
 
-int main(int argc, char **argv) {
+/**
+ * @brief Creates the statistics folder of a replica and fills in its statistics paths
+ *
+ * @param paths The paths to fill in
+ * @param seed The RNG seed of the replica, which names its folder as if it were a standalone run
+ * */
+void createStatsFolder(struct ReplicaStatsPaths *paths, unsigned int seed) {
+    // Find the next available folder
+    int folder_num = 0;
+    formatStatsFolder(paths->folder, seed, folder_num, sizeof(paths->folder));
+    while (access(paths->folder, F_OK) != -1) {
+        folder_num++;
+        formatStatsFolder(paths->folder, seed, folder_num, sizeof(paths->folder));
+    }
+
+    printf("Statistics will be saved in folder %s\n", paths->folder);
+
+    // Create the folder
+    if (mkdir(paths->folder, 0777) == -1) {
+        perror("Could not create folder for statistics");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t len = strlen(strcpy(paths->file, paths->folder));
+    formatStatsFile(paths->file + len, seed, sizeof(paths->file) - len);
+    printf("Statistics will be saved in file %s\n", paths->file);
+}
+
+/**
+ * @brief Restores the run options to their defaults, before parsing the options of a run
+ */
+void resetRunOptions() {
+    conf = default_conf;
+    BLOCK_INTERVAL = default_block_interval;
+    rng_seed = RNG_SEED;
+    replicas = 1;
+    json_stats = false;
+    statelessRng = false;
     setStatsType(STATS_NONE);
-    attackConfig.type = ATTACK_NONE;
+    attackConfig = (struct attack_config) {.type = ATTACK_NONE};
+    txnArrivalConfig = (struct txn_arrival_config) {.type = TXN_ARRIVAL_RAMP};
+    forkChoice = FORK_CHOICE_LONGEST;
+    proposalPolicy = PROPOSAL_POW;
+}
 
-    handle_options(argc, argv);
+/**
+ * @brief Runs a simulation with the current run options
+ *
+ * The topology of the previous run is reused.
+ */
+void runSimulation() {
+    tot_mined = 0;
+    totalHashPower = calloc(replicas, sizeof(*totalHashPower));
+    if (!totalHashPower) {
+        fprintf(stderr, "Failed to allocate memory for the hash power of the replicas\n");
+        abort();
+    }
 
     if (statsType != STATS_NONE) {
         if (conf.lps > 1000000) {
             fprintf(stderr, "More than a million LPs. Stats files will not have leading zeros.\n");
         }
 
-        // Find the next available folder
-        size_t max_path_len = sizeof(old_stats_folder) / sizeof(*old_stats_folder);
-        int folder_num = 0;
-        char *write_ptr = single_stats_fullpath;
-
-        write_ptr = single_stats_fullpath + formatStatsFolder(single_stats_fullpath, folder_num, max_path_len);
-
-        while (access(single_stats_fullpath, F_OK) != -1) {
-            folder_num++;
-            write_ptr = single_stats_fullpath + formatStatsFolder(single_stats_fullpath, folder_num, max_path_len);
+        // Each replica gets its own statistics folder, named after its seed as if it were a standalone run
+        replicaStatsPaths = malloc(replicas * sizeof(*replicaStatsPaths));
+        if (!replicaStatsPaths) {
+            fprintf(stderr, "Failed to allocate memory for the statistics paths\n");
+            abort();
         }
-
-        printf("Statistics will be saved in folder %s\n", single_stats_fullpath);
-
-        // Create the folder
-        if (mkdir(single_stats_fullpath, 0777) == -1) {
-            perror("Could not create folder for statistics");
-            exit(EXIT_FAILURE);
+        for (replica_id_t r = 0; r < replicas; r++) {
+            createStatsFolder(&replicaStatsPaths[r], rng_seed + r);
         }
-
-        strcpy(single_stats_metadata_fullpath, single_stats_fullpath);
-
-        formatStatsFile(write_ptr, sizeof(single_stats_fullpath) - (write_ptr - single_stats_fullpath));
-        printf("Statistics will be saved in file %s\n", single_stats_fullpath);
     }
 
-    struct rng_t rng;
-    initialize_stream(rng_seed, &rng);
+    if (statsType == STATS_DETAILED) {
+        // Each ROOT-Sim thread writes its own file, named after this prefix
+        snprintf(detailed_stats_prefix, sizeof(detailed_stats_prefix), "%s%s", replicaStatsPaths[0].folder, detailed_stats_filename);
+        conf.records_file = detailed_stats_prefix;
+        conf.record_size = sizeof(struct BlockStat);
+    }
 
     switch (attackConfig.type) {
         case ATTACK_FIFTY_ONE:
         case ATTACK_SELFISH_MINING:
-            initAttackers(1, &rng);
+            initAttackers(1);
             break;
         default:
-            initAttackers(0, NULL);
+            initAttackers(0);
             break;
 
     }
+
+    // Replica r chooses its attackers with the seed rng_seed + r
+    struct rng_t rng;
+    for (replica_id_t r = 0; r < replicas; r++) {
+        initialize_counter_stream(rng_seed + r, RNG_STREAM(RNG_STREAM_ATTACKERS, 0), 0, &rng);
+        chooseAttackers(r, &rng);
+    }
     printAttackers();
 
+    // The slot leaders depend on the attackers, who own a fixed portion of the stake
+    initLeaderSchedules(rng_seed);
+
     switch (statsType) {
         // For now only for selfish, since I only use this one.
         case STATS_SELFISH:
-            // At the end of the simulation, each LP writes their statistics data. Later, we will dump the statistics in a JSON file
-            selfishStats = malloc(sizeof(struct SelfishStatsState) * conf.lps);
+            // At the end of the simulation, each LP writes their statistics data. Later, we will dump the statistics in a columnar file per replica
+            selfishResults = malloc(replicas * sizeof(*selfishResults));
+            if (!selfishResults) {
+                fprintf(stderr, "Failed to allocate memory for the statistics results\n");
+                abort();
+            }
+            for (replica_id_t r = 0; r < replicas; r++) {
+                initSelfishStatsResults(&selfishResults[r], N_NODES);
+            }
             break;
         case STATS_FIFTY_ONE:
         case STATS_NONE:
@@ -590,36 +930,129 @@ int main(int argc, char **argv) {
             exit(1);
     }
 
-    generateTransactions(&rng);
+    // The transaction attributes are derived from the seed, so that replica r gets the ones of seed rng_seed + r
+    initTransactions(rng_seed);
+    initBlockStore();
+
+    if (statelessRng) {
+        eventRngs = malloc(conf.lps * sizeof(*eventRngs));
+        if (!eventRngs) {
+            fprintf(stderr, "Failed to allocate memory for the random number generators\n");
+            abort();
+        }
+    }
 
-    RootsimInit(&conf);
-    RootsimRun();
+    if (RootsimInit(&conf) || RootsimRun()) {
+        fprintf(stderr, "The simulation failed!\n");
+        exit(EXIT_FAILURE);
+    }
 
     if (statsType == STATS_SELFISH) {
-        // Dump the grouped together statistics.
-        size_t buf_size = sizeof(char) * (conf.lps * 256 + 256);
-        char *stats_buf = malloc(buf_size);
-        char *write_ptr = stats_buf;
-        char *buf_end = stats_buf + (buf_size - 1);
-
-        write_ptr += sprintf(write_ptr, "{\n\"header\":");
-        write_ptr += sprintSelfishStatsHeader(write_ptr, buf_end - write_ptr);
-        write_ptr += sprintf(write_ptr, ",\n\"data\": [\n");
-        for (node_id_t i = 0; i < conf.lps; i++) {
-            write_ptr += sprintSelfishStats(&selfishStats[i], write_ptr, buf_end - write_ptr);
-            write_ptr += sprintf(write_ptr, ",\n");
+        // Dump the grouped together statistics of each replica, along with its run configuration
+        struct ResultsHeader header = {
+            .threads = conf.n_threads,
+            .attackType = attackConfig.type,
+            .blockInterval = BLOCK_INTERVAL
+        };
+        if (attackConfig.type == ATTACK_SELFISH_MINING) {
+            header.hashPowerPortion = attackConfig.selfish.hashPowerPortion;
+            header.startTime = attackConfig.selfish.startTime;
+            header.depth = attackConfig.selfish.depth;
+            header.catchupTolerance = attackConfig.selfish.catchupTolerance;
+        } else if (attackConfig.type == ATTACK_FIFTY_ONE) {
+            header.hashPowerPortion = attackConfig.fiftyOne.hashPowerPortion;
+            header.catchupTolerance = attackConfig.fiftyOne.catchupTolerance;
         }
-        write_ptr -= 2; // Remove the last comma
-        write_ptr += sprintf(write_ptr, "\n]\n}\n");
+        for (replica_id_t r = 0; r < replicas; r++) {
+            header.rngSeed = rng_seed + r;
+            dumpSelfishStatsResults(&selfishResults[r], &header, replicaStatsPaths[r].file);
+
+            if (json_stats) {
+                char json_path[sizeof(replicaStatsPaths[r].file) + 8];
+                strcpy(json_path, replicaStatsPaths[r].file);
+                strcpy(strrchr(json_path, '.'), json_stats_extension);
+                dumpSelfishStatsResultsJson(&selfishResults[r], json_path);
+            }
+            deinitSelfishStatsResults(&selfishResults[r]);
+        }
+        free(selfishResults);
+        selfishResults = NULL;
+    }
 
-        FILE *stats_file = fopen(single_stats_fullpath, "w");
-        fwrite(stats_buf, sizeof(char), write_ptr - stats_buf, stats_file);
+    deinitBlockStore();
+    deinitTransactions();
+    deinitLeaderSchedules();
+    free(replicaStatsPaths);
+    replicaStatsPaths = NULL;
+    free(totalHashPower);
+    totalHashPower = NULL;
+    free(eventRngs);
+    eventRngs = NULL;
+    deinitAttackers();
+}
 
-        fclose(stats_file);
-        free(selfishStats);
+/**
+ * @brief Runs the simulations listed in the sweep file back to back
+ *
+ * Each non-empty line of the sweep file which doesn't start with '#' holds the command line options of a run, which
+ * are parsed after the ones given on the actual command line.
+ */
+void runSweep(int argc, char **argv) {
+    FILE *f = fopen(sweep_file, "r");
+    if (!f) {
+        perror("Could not open the sweep file");
+        exit(EXIT_FAILURE);
     }
 
-    deinitAttackers();
+    char *line = NULL;
+    size_t line_cap = 0;
+    size_t run_argv_cap = argc + 1;
+    char **run_argv = malloc(run_argv_cap * sizeof(*run_argv));
+    unsigned runs = 0;
+
+    while (getline(&line, &line_cap, f) != -1) {
+        int run_argc = argc;
+        memcpy(run_argv, argv, argc * sizeof(*run_argv));
+        for (char *tok = strtok(line, " \t\r\n"); tok; tok = strtok(NULL, " \t\r\n")) {
+            if ((size_t) run_argc + 1 >= run_argv_cap) {
+                run_argv_cap *= 2;
+                run_argv = realloc(run_argv, run_argv_cap * sizeof(*run_argv));
+            }
+            run_argv[run_argc++] = tok;
+        }
+        run_argv[run_argc] = NULL;
+
+        if (run_argc == argc || run_argv[argc][0] == '#') {
+            continue;
+        }
+
+        printf("Sweep run %u\n", runs++);
+        resetRunOptions();
+        optind = 1;
+        handle_options(run_argc, run_argv);
+        runSimulation();
+    }
+
+    free(run_argv);
+    free(line);
+    fclose(f);
+    printf("Sweep completed: %u runs\n", runs);
+}
+
+int main(int argc, char **argv) {
+    default_conf = conf;
+    default_block_interval = BLOCK_INTERVAL;
+
+    resetRunOptions();
+    handle_options(argc, argv);
+
+    initNetwork();
+    if (sweep_file) {
+        runSweep(argc, argv);
+    } else {
+        runSimulation();
+    }
+    deinitNetwork();
     return 0;
 }
 
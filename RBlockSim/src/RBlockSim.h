@@ -7,6 +7,11 @@
 #include "Config.h"
 
 extern __thread node_id_t currentNode;
+extern __thread replica_id_t currentReplica;
+extern replica_id_t replicas;
+
+/// The LP simulating a node of the replica being processed. Replica r is simulated by the LPs [r * N_NODES, (r + 1) * N_NODES)
+#define NODE_LP(node) ((lp_id_t) currentReplica * N_NODES + (node))
 
 /**
  * Main file for the model.
@@ -17,22 +22,30 @@ enum rblocksim_event {
     RBLOCKSIM_INIT = 0, // Internal initialization event. Used for e.g. computing the portion of hashpower w.r.t. the total.
     RECEIVE_BLOCK,
     REQUEST_BLOCK,
+    RECEIVE_BLOCK_TRANSACTIONS, // Answer to a REQUEST_BLOCK for the transactions of a block missing from the local view
+    BLOCK_VALIDATED, // Internal event. The node has finished validating a received block
+    PROPOSE_BLOCK, // Internal event. The node leads the slot carried in the event (proof of stake)
     GENERATE_BLOCK = LP_RETRACTABLE
 };
 
 //simtime_t transmissionDelays[N_NODES][N_NODES];
 
 extern struct simulation_configuration conf;
-extern struct SharedHashPower totalHashPower;
+extern struct SharedHashPower *totalHashPower;
 
-bool CanEnd(lp_id_t me, const void *snapshot);
 
 void ProcessEvent(lp_id_t me, simtime_t now, unsigned event_type, const void *event_content,
                   unsigned event_size, void *st);
 
+/**
+ * @brief Releases the resources the node only needed to roll back the events committed by a new GVT
+ */
+void OnGvt(lp_id_t lp, simtime_t gvt, const void *st);
+
 /// Information to uniquely identify the requested block
 struct request_block_evt {
     node_id_t requester;
     node_id_t miner;
     size_t height;
+    bool transactions; ///< If set, the requester already has the block header and is only missing some of its transactions
 };
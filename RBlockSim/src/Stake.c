@@ -0,0 +1,180 @@
+#include "Stake.h"
+#include "Attacks.h"
+#include "util.h"
+
+enum proposal_policy proposalPolicy = PROPOSAL_POW;
+static struct LeaderSchedule *leaderSchedules = NULL; ///< The leader schedule of each replica
+
+/// The random streams a leader schedule is derived from
+enum stake_stream {
+    STAKE_STREAM_RADIUS, ///< Indexed by node, first draw of the normally distributed stake
+    STAKE_STREAM_ANGLE,  ///< Indexed by node, second draw of the normally distributed stake
+    STAKE_STREAM_EPOCH,  ///< Indexed by epoch, seed of the leaders of its slots
+    STAKE_STREAMS
+};
+
+/**
+ * @brief Draws a number uniformly distributed in [0, 1) from a counter-based stream
+ *
+ * @param seed the seed of the stream
+ * @param counter the position of the number in the stream
+ */
+static double stakeUniform(uint64_t seed, uint64_t counter) {
+    return CounterRandom(seed, RNG_STREAM(RNG_STREAM_STAKES, 0), counter);
+}
+
+/**
+ * @brief Gets the portion of the total stake owned by the attackers
+ */
+static double getAttackersStakePortion() {
+    switch (attackConfig.type) {
+        case ATTACK_SELFISH_MINING:
+            return attackConfig.selfish.hashPowerPortion;
+        case ATTACK_FIFTY_ONE:
+            return attackConfig.fiftyOne.hashPowerPortion;
+        default:
+            return 0.0;
+    }
+}
+
+/**
+ * @brief Computes the portion of the total stake owned by each node of a replica
+ *
+ * @param[out] stakes the array to fill in, holding N_NODES entries
+ * @param replica the replica
+ * @param seed the seed of the replica
+ */
+static void generateStakes(double *stakes, replica_id_t replica, uint64_t seed) {
+    const node_id_t *attackers = num_attackers ? attacker_ids + (size_t) replica * num_attackers : NULL;
+    double honest_total = 0.0;
+    for (node_id_t n = 0; n < N_NODES; n++) {
+        // Box-Muller transform, with the same distribution of the honest hash power
+        double radius = sqrt(-2.0 * log(1.0 - stakeUniform(seed, (uint64_t) n * STAKE_STREAMS + STAKE_STREAM_RADIUS)));
+        double angle = 2.0 * M_PI * stakeUniform(seed, (uint64_t) n * STAKE_STREAMS + STAKE_STREAM_ANGLE);
+        double stake = 5000 + 1000 * radius * cos(angle);
+        stakes[n] = stake > 0.0 ? stake : 0.0;
+        for (size_t a = 0; a < num_attackers; a++) {
+            if (attackers[a] == n) {
+                stakes[n] = 0.0;
+            }
+        }
+        honest_total += stakes[n];
+    }
+
+    double attackers_portion = getAttackersStakePortion();
+    for (node_id_t n = 0; n < N_NODES; n++) {
+        stakes[n] *= (1 - attackers_portion) / honest_total;
+    }
+    for (size_t a = 0; a < num_attackers; a++) {
+        stakes[attackers[a]] = attackers_portion / (double) num_attackers;
+    }
+}
+
+/**
+ * @brief Draws the leaders of the slots of a replica
+ *
+ * @param[in,out] schedule the schedule to fill in. Its stakes must have been computed
+ * @param seed the seed of the replica
+ */
+static void generateLeaders(struct LeaderSchedule *schedule, uint64_t seed) {
+    double cumulative[N_NODES];
+    double total = 0.0;
+    for (node_id_t n = 0; n < N_NODES; n++) {
+        total += schedule->stakes[n];
+        cumulative[n] = total;
+    }
+
+    uint64_t epoch_seed = 0;
+    for (size_t s = 0; s < schedule->slots; s++) {
+        if (s % POS_SLOTS_PER_EPOCH == 0) {
+            epoch_seed = CounterRandomU64(seed, RNG_STREAM(RNG_STREAM_STAKES, 0), (uint64_t) (s / POS_SLOTS_PER_EPOCH) * STAKE_STREAMS + STAKE_STREAM_EPOCH);
+        }
+        double target = stakeUniform(epoch_seed, s % POS_SLOTS_PER_EPOCH) * total;
+        node_id_t lo = 0, hi = N_NODES - 1;
+        while (lo < hi) {
+            node_id_t mid = lo + (hi - lo) / 2;
+            if (cumulative[mid] > target) {
+                hi = mid;
+            } else {
+                lo = mid + 1;
+            }
+        }
+        schedule->leaders[s] = lo;
+    }
+
+    // Chain the slots of each leader, walking them backwards
+    for (node_id_t n = 0; n < N_NODES; n++) {
+        schedule->first_slot[n] = schedule->slots;
+    }
+    for (size_t s = schedule->slots; s > 0; s--) {
+        node_id_t leader = schedule->leaders[s - 1];
+        schedule->next_slot[s - 1] = schedule->first_slot[leader];
+        schedule->first_slot[leader] = s - 1;
+    }
+}
+
+void initLeaderSchedules(uint64_t seed) {
+    if (proposalPolicy != PROPOSAL_POS) {
+        return;
+    }
+
+    leaderSchedules = malloc(replicas * sizeof(*leaderSchedules));
+    if (!leaderSchedules) {
+        fprintf(stderr, "Failed to allocate memory for the leader schedules\n");
+        abort();
+    }
+
+    // Slot s starts at (s + 1) * BLOCK_INTERVAL, right after the genesis block
+    size_t slots = (size_t) (conf.termination_time / BLOCK_INTERVAL);
+    for (replica_id_t r = 0; r < replicas; r++) {
+        struct LeaderSchedule *schedule = &leaderSchedules[r];
+        schedule->slots = slots;
+        schedule->stakes = malloc(N_NODES * sizeof(*schedule->stakes));
+        schedule->leaders = malloc(slots * sizeof(*schedule->leaders));
+        schedule->next_slot = malloc(slots * sizeof(*schedule->next_slot));
+        if (!schedule->stakes || (slots && (!schedule->leaders || !schedule->next_slot))) {
+            fprintf(stderr, "Failed to allocate memory for the leader schedules\n");
+            abort();
+        }
+        generateStakes(schedule->stakes, r, seed + r);
+        generateLeaders(schedule, seed + r);
+    }
+}
+
+void deinitLeaderSchedules() {
+    if (!leaderSchedules) {
+        return;
+    }
+    for (replica_id_t r = 0; r < replicas; r++) {
+        free(leaderSchedules[r].stakes);
+        free(leaderSchedules[r].leaders);
+        free(leaderSchedules[r].next_slot);
+    }
+    free(leaderSchedules);
+    leaderSchedules = NULL;
+}
+
+double getStakePortion(node_id_t node) {
+    return leaderSchedules[currentReplica].stakes[node];
+}
+
+/**
+ * @brief Schedules the proposal of a node for a slot it leads
+ *
+ * @param node the ID of the node
+ * @param slot the slot. Nothing is scheduled if it is past the end of the schedule
+ */
+static void scheduleProposal(node_id_t node, size_t slot) {
+    if (slot >= leaderSchedules[currentReplica].slots) {
+        return;
+    }
+    ScheduleNewEvent(NODE_LP(node), (double) (slot + 1) * BLOCK_INTERVAL, PROPOSE_BLOCK, &slot, sizeof(slot));
+}
+
+void scheduleFirstProposal(node_id_t node) {
+    scheduleProposal(node, leaderSchedules[currentReplica].first_slot[node]);
+}
+
+void scheduleNextProposal(node_id_t node, size_t slot) {
+    scheduleProposal(node, leaderSchedules[currentReplica].next_slot[slot]);
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "RBlockSim.h"
+
+/**
+ * Header for the proof of stake block proposal.
+ * Time is divided in slots of BLOCK_INTERVAL seconds, each one led by a node drawn with probability proportional to its
+ * stake. The leaders of a replica are precomputed, epoch by epoch, from a seed shared by all its nodes.
+ * */
+
+/// How nodes earn the right to produce a block
+enum proposal_policy {
+    PROPOSAL_POW, ///< Proof of work: each node mines with exponentially distributed delays
+    PROPOSAL_POS, ///< Proof of stake: the leader of each slot proposes a block
+};
+
+extern enum proposal_policy proposalPolicy;
+
+/// The leaders of the slots of a replica
+struct LeaderSchedule {
+    double *stakes;             ///< Portion of the total stake owned by each node
+    size_t slots;               ///< Number of slots starting before the end of the simulation
+    node_id_t *leaders;         ///< Leader of each slot
+    size_t *next_slot;          ///< For each slot, the next one with the same leader. @a slots if none
+    size_t first_slot[N_NODES]; ///< First slot led by each node. @a slots if none
+};
+
+/**
+ * @brief Computes the stakes and the leader schedules of every replica
+ *
+ * The stakes of the honest nodes are normally distributed, while attackers own the portion of the total stake set in
+ * attackConfig. The leader of each slot is drawn from a seed derived for its epoch.
+ *
+ * @param seed The seed the schedules are derived from. Each replica offsets it by its id
+ */
+void initLeaderSchedules(uint64_t seed);
+
+/**
+ * @brief Releases the resources allocated by initLeaderSchedules()
+ */
+void deinitLeaderSchedules();
+
+/**
+ * @brief Gets the portion of the total stake owned by a node of the replica being processed
+ *
+ * @param node the ID of the node
+ */
+double getStakePortion(node_id_t node);
+
+/**
+ * @brief Schedules the proposal of the first slot led by a node of the replica being processed, if any
+ *
+ * @param node the ID of the node
+ */
+void scheduleFirstProposal(node_id_t node);
+
+/**
+ * @brief Schedules the proposal of the slot a node leads after @a slot, if any
+ *
+ * @param node the ID of the node
+ * @param slot a slot led by @a node
+ */
+void scheduleNextProposal(node_id_t node, size_t slot);
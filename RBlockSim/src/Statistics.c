@@ -1,20 +1,15 @@
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
 #include "Statistics.h"
 #include "Attacks.h"
 
 enum StatsType statsType = STATS_NONE;
 
 void initDetailedStatisticsState(struct StatsState *state) {
+    (void) state; // The detailed statistics are streamed as committed records, they keep nothing in the state
     statsType = STATS_DETAILED;
-
-    struct DetailedStatsState *receivedState = &state->detailedStats;
-    receivedState->blockStatsCapacity = 1;
-    receivedState->blockStatsSize = 0;
-    receivedState->blockStats = rs_malloc(receivedState->blockStatsCapacity * sizeof(struct BlockStat));
-
-    receivedState->minedBlockStatsCapacity = 1;
-    receivedState->minedBlockStatsSize = 0;
-    receivedState->minedBlockStats = rs_malloc(receivedState->minedBlockStatsCapacity * sizeof(struct MinedBlockStat));
 }
 
 void initFiftyOneStatisticsState(struct StatsState *state) {
@@ -36,16 +31,10 @@ void initSelfishStatisticsState(struct StatsState *state) {
     selfishState->switchesToSelfishChain = 0;
 }
 
-void deinitReceivedStatisticsState(struct DetailedStatsState *state) {
-    rs_free(state->blockStats);
-    rs_free(state->minedBlockStats);
-}
-
 void deinitStatisticsState(struct StatsState *state) {
+    (void) state; // None of the statistics types allocates memory in the state
     switch (statsType) {
         case STATS_DETAILED:
-            deinitReceivedStatisticsState(&state->detailedStats);
-            break;
         case STATS_FIFTY_ONE:
         case STATS_SELFISH:
         case STATS_NONE:
@@ -56,29 +45,6 @@ void deinitStatisticsState(struct StatsState *state) {
     }
 }
 
-void copyReceivedStatisticsState(struct DetailedStatsState *dest, const struct DetailedStatsState *src) {
-    dest->blockStatsCapacity = src->blockStatsCapacity;
-    dest->blockStatsSize = src->blockStatsSize;
-    struct BlockStat *destBlockStat = rs_realloc(dest->blockStats, dest->blockStatsCapacity * sizeof(struct BlockStat));
-    if (!destBlockStat) {
-        perror("copyStatisticsState: could not realloc blockStats");
-        exit(1);
-    }
-    dest->blockStats = destBlockStat;
-    memcpy(dest->blockStats, src->blockStats, dest->blockStatsSize * sizeof(struct BlockStat));
-
-    dest->minedBlockStatsCapacity = src->minedBlockStatsCapacity;
-    dest->minedBlockStatsSize = src->minedBlockStatsSize;
-    struct MinedBlockStat *destMinedBlockStat = rs_realloc(dest->minedBlockStats,
-                                                        dest->minedBlockStatsCapacity * sizeof(struct MinedBlockStat));
-    if (!destMinedBlockStat) {
-        perror("copyStatisticsState: could not realloc minedBlockStats");
-        exit(1);
-    }
-    dest->minedBlockStats = destMinedBlockStat;
-    memcpy(dest->minedBlockStats, src->minedBlockStats, dest->minedBlockStatsSize * sizeof(struct MinedBlockStat));
-}
-
 void copyFiftyOneStatisticsState(struct FiftyOneStatsState *dest, const struct FiftyOneStatsState *src) {
     *dest = *src;
 }
@@ -90,9 +56,7 @@ void copySelfishStatisticsState(struct SelfishStatsState *dest, const struct Sel
 void copyStatisticsState(struct StatsState *dest, const struct StatsState *src) {
     switch (statsType) {
         case STATS_NONE:
-            break;
         case STATS_DETAILED:
-            copyReceivedStatisticsState(&dest->detailedStats, &src->detailedStats);
             break;
         case STATS_FIFTY_ONE:
             copyFiftyOneStatisticsState(&dest->fiftyOneStats, &src->fiftyOneStats);
@@ -106,55 +70,28 @@ void copyStatisticsState(struct StatsState *dest, const struct StatsState *src)
     }
 }
 
-void statsReceiveBlockDetailed(struct StatsState *state, node_id_t miner, size_t height, simtime_t receivedTime) {
+void statsReceiveBlockDetailed(node_id_t miner, size_t height, simtime_t receivedTime) {
     if (statsType != STATS_DETAILED) {
         perror("statsReceiveBlockDetailed: state type is not DETAILED_STATS");
         exit(1);
     }
 
-    struct DetailedStatsState *receivedState = &state->detailedStats;
-    while (receivedState->blockStatsSize >= receivedState->blockStatsCapacity) {
-        receivedState->blockStatsCapacity *= 2;
-        struct BlockStat *newBlockStats = rs_realloc(receivedState->blockStats,
-                                                  receivedState->blockStatsCapacity * sizeof(struct BlockStat));
-        if (!newBlockStats) {
-            perror("Could not realloc blockStats");
-            exit(1);
-        }
-        receivedState->blockStats = newBlockStats;
-    }
-
-    struct BlockStat *blockStat = &receivedState->blockStats[receivedState->blockStatsSize++];
-    blockStat->miner = miner;
-    blockStat->height = height;
-    blockStat->receivedTime = receivedTime;
+    struct BlockStat blockStat = {.miner = miner, .height = height, .receivedTime = receivedTime};
+    CommitRecord(receivedTime, STATS_RECORD_RECEIVED_BLOCK, &blockStat);
 }
 
-void statsMineBlockDetailed(struct StatsState *state, node_id_t miner, size_t height, simtime_t minedTime) {
+void statsMineBlockDetailed(node_id_t miner, size_t height, simtime_t minedTime) {
     if (statsType != STATS_DETAILED) {
-        perror("statsReceiveBlockDetailed: state type is not DETAILED_STATS");
+        perror("statsMineBlockDetailed: state type is not DETAILED_STATS");
         exit(1);
     }
 
-    struct DetailedStatsState *receivedState = &state->detailedStats;
-    while (receivedState->minedBlockStatsSize >= receivedState->minedBlockStatsCapacity) {
-        receivedState->minedBlockStatsCapacity *= 2;
-        struct MinedBlockStat *newMinedStats = rs_realloc(receivedState->minedBlockStats,
-                                                       receivedState->minedBlockStatsCapacity * sizeof(struct BlockStat));
-        if (!newMinedStats) {
-            perror("Could not realloc blockStats");
-            exit(1);
-        }
-        receivedState->minedBlockStats = newMinedStats;
-    }
-
-    struct MinedBlockStat *minedStat = &receivedState->minedBlockStats[receivedState->minedBlockStatsSize++];
-    minedStat->miner = miner;
-    minedStat->height = height;
-    minedStat->minedTime = minedTime;
+    struct MinedBlockStat minedStat = {.miner = miner, .height = height, .minedTime = minedTime};
+    CommitRecord(minedTime, STATS_RECORD_MINED_BLOCK, &minedStat);
 }
 
 void statsAddBlockFiftyOne(struct StatsState *state, node_id_t miner, node_id_t me) {
+    (void) me;
     if (statsType != STATS_FIFTY_ONE) {
         perror("statsAddBlockFiftyOne: stats type is not STATS_FIFTY_ONE");
         exit(1);
@@ -167,6 +104,7 @@ void statsAddBlockFiftyOne(struct StatsState *state, node_id_t miner, node_id_t
 }
 
 void statsRemoveBlockFiftyOne(struct StatsState *state, node_id_t miner, node_id_t me) {
+    (void) me;
     if (statsType != STATS_FIFTY_ONE) {
         perror("statsRemoveBlockFiftyOne: stats type is not STATS_FIFTY_ONE");
         exit(1);
@@ -229,9 +167,7 @@ void statsSwitchToSelfishChain(struct StatsState *state) {
 void dumpStats(struct StatsState *state, const char *filename) {
     switch (statsType) {
         case STATS_NONE:
-            break;
-        case STATS_DETAILED:
-            dumpDetailedStats(&state->detailedStats, filename);
+        case STATS_DETAILED: // Written by ROOT-Sim as the records are committed
             break;
         case STATS_FIFTY_ONE:
             dumpFiftyOneStats(&state->fiftyOneStats, filename);
@@ -248,9 +184,7 @@ void dumpStats(struct StatsState *state, const char *filename) {
 void dumpStatsBinary(struct StatsState *state, const char *filename) {
     switch (statsType) {
         case STATS_NONE:
-            break;
-        case STATS_DETAILED:
-            dumpDetailedStatsBinary(&state->detailedStats, filename);
+        case STATS_DETAILED: // Written by ROOT-Sim as the records are committed
             break;
         case STATS_FIFTY_ONE:
             dumpFiftyOneStatsBinary(&state->fiftyOneStats, filename);
@@ -267,9 +201,7 @@ void dumpStatsBinary(struct StatsState *state, const char *filename) {
 void printStats(struct StatsState *state) {
     switch (statsType) {
         case STATS_NONE:
-            break;
-        case STATS_DETAILED:
-            printDetailedStats(&state->detailedStats);
+        case STATS_DETAILED: // Written by ROOT-Sim as the records are committed
             break;
         case STATS_FIFTY_ONE:
             printFiftyOneStats(&state->fiftyOneStats);
@@ -283,92 +215,6 @@ void printStats(struct StatsState *state) {
     }
 }
 
-void dumpDetailedStats(struct DetailedStatsState *state, const char *filename) {
-    // Open the file
-    FILE *file = fopen(filename, "w");
-    if (!file) {
-        fprintf(stderr, "Could not open file %s for writing", filename);
-        perror("ERROR: ");
-        exit(1);
-    }
-
-    // Write the block stats in json format
-    fprintf(file, "{\n\"blockStats\":[\n");
-    for (size_t i = 0; i < state->blockStatsSize; i++) {
-        struct BlockStat *blockStat = &state->blockStats[i];
-        fprintf(file, "{\"miner\":%d,\"height\":%lu,\"receivedTime\":%lf}", blockStat->miner, blockStat->height,
-                blockStat->receivedTime);
-        if (i < state->blockStatsSize - 1) {
-            fprintf(file, ",");
-        }
-        fprintf(file, "\n");
-    }
-    fprintf(file, "],\n");
-
-    // Write the mined block stats in json format
-    fprintf(file, "\"minedBlockStats\":[\n");
-    for (size_t i = 0; i < state->minedBlockStatsSize; i++) {
-        struct MinedBlockStat *minedStat = &state->minedBlockStats[i];
-        fprintf(file, "{\"miner\":%d,\"height\":%lu,\"minedTime\":%lf}", minedStat->miner, minedStat->height,
-                minedStat->minedTime);
-        if (i < state->minedBlockStatsSize - 1) {
-            fprintf(file, ",");
-        }
-        fprintf(file, "\n");
-    }
-    fprintf(file, "]\n}\n");
-
-    fclose(file);
-}
-
-void dumpDetailedStatsBinary(struct DetailedStatsState *state, const char *filename) {
-    // Open file
-    FILE *file = fopen(filename, "wb");
-    if (!file) {
-        fprintf(stderr, "Could not open file %s for writing", filename);
-        perror("ERROR: ");
-        exit(1);
-    }
-
-    // Write block stats
-    fwrite(&state->blockStatsSize, sizeof(size_t), 1, file);
-    fwrite(state->blockStats, sizeof(struct BlockStat), state->blockStatsSize, file);
-
-    // Write mined block stats
-    fwrite(&state->minedBlockStatsSize, sizeof(size_t), 1, file);
-    fwrite(state->minedBlockStats, sizeof(struct MinedBlockStat), state->minedBlockStatsSize, file);
-
-    fclose(file);
-}
-
-void printDetailedStats(struct DetailedStatsState *state) {
-    // Write the block stats in json format
-    printf("{\n\"blockStats\":[\n");
-    for (size_t i = 0; i < state->blockStatsSize; i++) {
-        struct BlockStat *blockStat = &state->blockStats[i];
-        printf("{\"miner\":%d,\"height\":%lu,\"receivedTime\":%lf}", blockStat->miner, blockStat->height,
-               blockStat->receivedTime);
-        if (i < state->blockStatsSize - 1) {
-            printf(",");
-        }
-        printf("\n");
-    }
-    printf("],\n");
-
-    // Write the mined block stats in json format
-    printf("\"minedBlockStats\":[\n");
-    for (size_t i = 0; i < state->minedBlockStatsSize; i++) {
-        struct MinedBlockStat *minedStat = &state->minedBlockStats[i];
-        printf("{\"miner\":%d,\"height\":%lu,\"minedTime\":%lf}", minedStat->miner, minedStat->height,
-               minedStat->minedTime);
-        if (i < state->minedBlockStatsSize - 1) {
-            printf(",");
-        }
-        printf("\n");
-    }
-    printf("]\n}\n");
-}
-
 void dumpFiftyOneStats(struct FiftyOneStatsState *state, const char *filename) {
     // Open the file
     FILE *file = fopen(filename, "w");
@@ -459,19 +305,88 @@ void printSelfishStats(struct SelfishStatsState *state) {
            state->attackerBlocksInMainChain, state->totalBlocksInMainChain, state->totalBlocksMined, state->ownBlocksInMainChain, state->switchesToSelfishChain);
 }
 
-size_t sprintSelfishStatsHeader(char *buffer, size_t buffer_size) {
-    size_t written = 0;
-    written += snprintf(buffer + written, buffer_size - written, "[\"attackerBlocksInMainChain\",\"totalBlocksInMainChain\",\"totalBlocksMined\",\"ownBlocksInMainChain\",\"switchesToSelfishChain\"]");
-    return written;
+/// The names of the SelfishStatsState fields, in the order of the results columns
+static const char *selfishStatsFields[SELFISH_STATS_FIELDS] = {
+    "attackerBlocksInMainChain", "totalBlocksInMainChain", "totalBlocksMined", "ownBlocksInMainChain", "switchesToSelfishChain"
+};
+
+void initSelfishStatsResults(struct SelfishStatsResults *results, size_t nodes) {
+    results->nodes = nodes;
+    uint64_t *buffer = calloc(SELFISH_STATS_FIELDS * nodes, sizeof(uint64_t));
+    if (!buffer) {
+        perror("initSelfishStatsResults: could not allocate the results columns");
+        exit(1);
+    }
+    for (size_t f = 0; f < SELFISH_STATS_FIELDS; f++) {
+        results->columns[f] = buffer + f * nodes;
+    }
 }
 
-size_t sprintSelfishStats(struct SelfishStatsState *state, char *buffer, size_t buffer_size) {
-    size_t written = 0;
-    written += snprintf(buffer + written, buffer_size - written, "[%lu,%lu,%lu,%lu,%lu]",
-                        state->attackerBlocksInMainChain, state->totalBlocksInMainChain, state->totalBlocksMined, state->ownBlocksInMainChain, state->switchesToSelfishChain);
-    if (written > buffer_size) {
-        perror("sprintSelfishStats: buffer too small. Truncated output");
+void deinitSelfishStatsResults(struct SelfishStatsResults *results) {
+    free(results->columns[0]);
+}
+
+void storeSelfishStatsResults(struct SelfishStatsResults *results, node_id_t node, const struct SelfishStatsState *state) {
+    results->columns[0][node] = state->attackerBlocksInMainChain;
+    results->columns[1][node] = state->totalBlocksInMainChain;
+    results->columns[2][node] = state->totalBlocksMined;
+    results->columns[3][node] = state->ownBlocksInMainChain;
+    results->columns[4][node] = state->switchesToSelfishChain;
+}
+
+void dumpSelfishStatsResults(const struct SelfishStatsResults *results, struct ResultsHeader *header, const char *filename) {
+    char names[SELFISH_STATS_FIELDS][RESULTS_FIELD_NAME_LEN] = {0};
+    for (size_t f = 0; f < SELFISH_STATS_FIELDS; f++) {
+        strncpy(names[f], selfishStatsFields[f], RESULTS_FIELD_NAME_LEN - 1);
+    }
+
+    memcpy(header->magic, RESULTS_MAGIC, sizeof(header->magic));
+    header->version = RESULTS_VERSION;
+    header->nodes = results->nodes;
+    header->fieldsCount = SELFISH_STATS_FIELDS;
+    header->fieldNameLen = RESULTS_FIELD_NAME_LEN;
+
+    // The columns are contiguous in memory, so three buffers are enough
+    struct iovec iov[3] = {
+        {.iov_base = header, .iov_len = sizeof(*header)},
+        {.iov_base = names, .iov_len = sizeof(names)},
+        {.iov_base = results->columns[0], .iov_len = SELFISH_STATS_FIELDS * results->nodes * sizeof(uint64_t)}
+    };
+    size_t total = iov[0].iov_len + iov[1].iov_len + iov[2].iov_len;
+
+    int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) {
+        fprintf(stderr, "Could not open file %s for writing", filename);
+        perror("ERROR: ");
         exit(1);
     }
-    return written;
+    ssize_t written = writev(fd, iov, 3);
+    if (written < 0 || (size_t) written != total) {
+        fprintf(stderr, "Could not write file %s", filename);
+        perror("ERROR: ");
+        exit(1);
+    }
+    close(fd);
+}
+
+void dumpSelfishStatsResultsJson(const struct SelfishStatsResults *results, const char *filename) {
+    FILE *file = fopen(filename, "w");
+    if (!file) {
+        fprintf(stderr, "Could not open file %s for writing", filename);
+        perror("ERROR: ");
+        exit(1);
+    }
+
+    fprintf(file, "{\n\"header\":[");
+    for (size_t f = 0; f < SELFISH_STATS_FIELDS; f++) {
+        fprintf(file, f ? ",\"%s\"" : "\"%s\"", selfishStatsFields[f]);
+    }
+    fprintf(file, "],\n\"data\": [\n");
+    for (size_t i = 0; i < results->nodes; i++) {
+        fprintf(file, "[%lu,%lu,%lu,%lu,%lu]%s\n", results->columns[0][i], results->columns[1][i], results->columns[2][i],
+                results->columns[3][i], results->columns[4][i], i < results->nodes - 1 ? "," : "");
+    }
+    fprintf(file, "]\n}\n");
+
+    fclose(file);
 }
@@ -3,20 +3,28 @@
 #include <ROOT-Sim.h>
 #include "Typedefs.h"
 
-/// Used to gather statistics about the blocks. Each node will have a list of these, one entry per block received.
+/// Used to gather statistics about the blocks. Each node emits one of these per block received.
 struct BlockStat {
     node_id_t miner;
     size_t height;
     simtime_t receivedTime;
 };
 
-/// Used to gather statistics about the blocks mined locally. Each node will have a list of these, one entry per block mined.
+/// Used to gather statistics about the blocks mined locally. Each node emits one of these per block mined.
 struct MinedBlockStat {
     node_id_t miner;
     size_t height;
     simtime_t minedTime;
 };
 
+/// The types of the records emitted with detailed statistics, passed to CommitRecord()
+enum DetailedStatsRecord {
+    STATS_RECORD_RECEIVED_BLOCK, ///< The record is a struct BlockStat
+    STATS_RECORD_MINED_BLOCK     ///< The record is a struct MinedBlockStat
+};
+
+_Static_assert(sizeof(struct BlockStat) == sizeof(struct MinedBlockStat), "Detailed statistics records must have the same size");
+
 enum StatsType {
     STATS_NONE,
     STATS_DETAILED,
@@ -28,19 +36,6 @@ extern enum StatsType statsType;
 
 /// State variations for the statistics module
 
-/// Tracks the blocks received and mined by the node
-struct DetailedStatsState {
-    // FIXME: This gets too big for managed memory.
-    struct BlockStat *blockStats;
-    size_t blockStatsSize;
-    size_t blockStatsCapacity;
-
-    // FIXME: too big for managed memory, same as blockStats
-    struct MinedBlockStat *minedBlockStats;
-    size_t minedBlockStatsSize;
-    size_t minedBlockStatsCapacity;
-};
-
 /// For 51% attack: tracks the blocks mined by the attacker that are in the main chain
 struct FiftyOneStatsState {
     size_t attackerBlocksInMainChain; ///< Number of blocks mined by the attacker that are in the main chain
@@ -56,9 +51,48 @@ struct SelfishStatsState {
     size_t switchesToSelfishChain;    ///< Number of times the node switched chain after receiving selfish blocks
 };
 
+/// The number of fields of SelfishStatsState
+#define SELFISH_STATS_FIELDS 5
+
+/// The per-node selfish mining statistics of a whole run, one array per SelfishStatsState field
+struct SelfishStatsResults {
+    size_t nodes;                                 ///< Number of entries in each column
+    uint64_t *columns[SELFISH_STATS_FIELDS];      ///< The columns, in the order of the SelfishStatsState fields
+};
+
+/// The magic string at the beginning of a results file
+#define RESULTS_MAGIC "RBSR"
+/// The version of the results file format, to be bumped at any change of the layout
+#define RESULTS_VERSION 1
+/// The fixed length of a field name in a results file, including the NUL terminator
+#define RESULTS_FIELD_NAME_LEN 32
+
+/**
+ * @brief The header of a results file, which holds the run configuration
+ *
+ * The header is followed by fieldsCount names of fieldNameLen bytes each, then by fieldsCount arrays of nodes uint64_t
+ * entries. Every value is in the host byte order.
+ * */
+struct ResultsHeader {
+    char magic[4];             ///< RESULTS_MAGIC, without NUL terminator
+    uint32_t version;          ///< RESULTS_VERSION
+    uint64_t nodes;            ///< Number of nodes, i.e. the length of each field array
+    uint32_t threads;          ///< Number of worker threads
+    uint32_t attackType;       ///< The enum attack_type value of the attack
+    double blockInterval;      ///< Expected block time in seconds
+    double hashPowerPortion;   ///< Attacker portion of the network hash power
+    double startTime;          ///< Start time of the attack in seconds
+    uint64_t depth;            ///< Depth of the selfish mining attack
+    uint64_t catchupTolerance; ///< Attacker catchup tolerance
+    uint64_t rngSeed;          ///< The RNG seed of the run
+    uint32_t fieldsCount;      ///< Number of field arrays
+    uint32_t fieldNameLen;     ///< RESULTS_FIELD_NAME_LEN
+};
+
+_Static_assert(sizeof(struct ResultsHeader) == 80, "The results header must have no padding");
+
 struct StatsState {
     union {
-        struct DetailedStatsState detailedStats;
         struct FiftyOneStatsState fiftyOneStats;
         struct SelfishStatsState selfishStats;
     };
@@ -77,6 +111,9 @@ static inline void setStatsType(enum StatsType type) {
  * @brief Initialize the LP state of the statistics module with detailed block reception and mining statistics
  *
  * @param state The state of the statistics module
+ *
+ * Detailed statistics are not kept in the LP state: they are emitted as records through CommitRecord(), and ROOT-Sim
+ * writes them to the records files once committed.
  * */
 void initDetailedStatisticsState(struct StatsState *state);
 
@@ -126,22 +163,20 @@ void copySelfishStatisticsState(struct SelfishStatsState *dest, const struct Sel
 /**
  * @brief Track the reception of a block
  *
- * @param state The state of the statistics module
  * @param miner The ID of the miner that mined the block
  * @param height The height of the block
- * @param receivedTime The time at which the block was received
+ * @param receivedTime The time at which the block was received, which must be the current simulation time
  * */
-void statsReceiveBlockDetailed(struct StatsState *state, node_id_t miner, size_t height, simtime_t receivedTime);
+void statsReceiveBlockDetailed(node_id_t miner, size_t height, simtime_t receivedTime);
 
 /**
  * @brief Track the mining of a block
  *
- * @param state The state of the statistics module
  * @param miner The ID of the miner that mined the block
  * @param height The height of the block
- * @param receivedTime The time at which the block was received
+ * @param minedTime The time at which the block was mined, which must be the current simulation time
  * */
-void statsMineBlockDetailed(struct StatsState *state, node_id_t miner, size_t height, simtime_t minedTime);
+void statsMineBlockDetailed(node_id_t miner, size_t height, simtime_t minedTime);
 
 /**
  * @brief Track the inclusion of a block in the main chain
@@ -214,14 +249,6 @@ void dumpStatsBinary(struct StatsState *state, const char *filename);
  * */
 void printStats(struct StatsState *state);
 
-/**
- * @brief Writes all the statistics to a file
- *
- * @param state The state of the statistics module
- * @param filename The path to the file where the statistics will be written
- * */
-void dumpDetailedStats(struct DetailedStatsState *state, const char *filename);
-
 /**
  * @brief Writes the statistics to a file, in binary format
  *
@@ -238,14 +265,6 @@ void dumpFiftyOneStats(struct FiftyOneStatsState *state, const char *filename);
  * */
 void dumpSelfishStats(struct SelfishStatsState *state, const char *filename);
 
-/**
- * @brief Writes the statistics to a file, in binary format
- *
- * @param state The state of the statistics module
- * @param filename The path to the file where the statistics will be written
- * */
-void dumpDetailedStatsBinary(struct DetailedStatsState *state, const char *filename);
-
 /**
  * @brief Writes the statistics to a file, in binary format
  *
@@ -267,39 +286,54 @@ void dumpSelfishStatsBinary(struct SelfishStatsState *state, const char *filenam
  *
  * @param state The state of the statistics module
  * */
-void printDetailedStats(struct DetailedStatsState *state);
+void printFiftyOneStats(struct FiftyOneStatsState *state);
 
 /**
  * @brief Prints all the statistics to stdout
  *
  * @param state The state of the statistics module
  * */
-void printFiftyOneStats(struct FiftyOneStatsState *state);
+void printSelfishStats(struct SelfishStatsState *state);
 
 /**
- * @brief Prints all the statistics to stdout
+ * @brief Allocate the columns of the per-node selfish mining statistics of a run
  *
- * @param state The state of the statistics module
+ * @param results The results to initialize
+ * @param nodes The number of nodes
  * */
-void printSelfishStats(struct SelfishStatsState *state);
+void initSelfishStatsResults(struct SelfishStatsResults *results, size_t nodes);
 
 /**
- * @brief Prints all the statistics to stdout
+ * @brief Release the columns of the per-node selfish mining statistics of a run
  *
- * @param state The state of the statistics module
- * @param buffer The buffer to write the statistics to
- * @param buffer_size The size of the buffer
+ * @param results The results to release
+ * */
+void deinitSelfishStatsResults(struct SelfishStatsResults *results);
+
+/**
+ * @brief Store the final selfish mining statistics of a node in the results columns
  *
- * @returns The number of characters written to the buffer
+ * @param results The results of the run
+ * @param node The ID of the node
+ * @param state The final statistics state of the node
  * */
-size_t sprintSelfishStats(struct SelfishStatsState *state, char *buffer, size_t buffer_size);
+void storeSelfishStatsResults(struct SelfishStatsResults *results, node_id_t node, const struct SelfishStatsState *state);
 
 /**
- * @brief Prints the header of the statistics to stdout
+ * @brief Write the per-node selfish mining statistics in the columnar binary results format
+ *
+ * @param results The results of the run
+ * @param header The header with the run configuration. The fields describing the columns are filled in here
+ * @param filename The path to the file where the results will be written
  *
- * @param buffer The buffer to write the statistics to
- * @param buffer_size The size of the buffer
+ * The whole file is written with a single writev() call, see struct ResultsHeader for the layout.
+ * */
+void dumpSelfishStatsResults(const struct SelfishStatsResults *results, struct ResultsHeader *header, const char *filename);
+
+/**
+ * @brief Write the per-node selfish mining statistics in JSON format
  *
- * @returns The number of characters written to the buffer
+ * @param results The results of the run
+ * @param filename The path to the file where the results will be written
  * */
-size_t sprintSelfishStatsHeader(char *buffer, size_t buffer_size);
\ No newline at end of file
+void dumpSelfishStatsResultsJson(const struct SelfishStatsResults *results, const char *filename);
@@ -1,14 +1,20 @@
 #include "Transaction.h"
-
-#ifndef NDEBUG
-
 #include "util.h"
 #include "Network.h"
 
-#endif
+struct txn_arrival_config txnArrivalConfig = {.type = TXN_ARRIVAL_RAMP};
+uint64_t transactions_seed;
+struct TransactionSchedule *schedules = NULL; ///< The transaction schedule of each replica
+struct Transaction *trace_transactions = NULL; ///< The transactions read from the trace file, if any
+size_t trace_count = 0; ///< The number of transactions read from the trace file
 
-atomic_bool txns_initialized = false;
-struct Transaction transactions[TXN_NUMBER];
+/// The attributes of a generated transaction, each one drawn from its own counter-based stream
+enum txn_attribute {
+    TXN_ATTR_SENDER,
+    TXN_ATTR_SIZE,
+    TXN_ATTR_FEE,
+    TXN_ATTR_GAP
+};
 
 size_t sizeofAdditionalTransactionDataBuffer(size_t transactions_count) {
     int b_size = bitmap_required_size(transactions_count);
@@ -28,102 +34,505 @@ struct TransactionData *allocTransactionData(size_t transactions_count) {
 }
 
 void initTransactionState(struct TransactionState *state) {
-    size_t b_size = bitmap_required_size(TXN_NUMBER);
-    state->transactions_bitmap = rs_malloc(b_size);
-    bitmap_initialize(state->transactions_bitmap, TXN_NUMBER);
+    state->window = rs_malloc(bitmap_required_size(TXN_WINDOW_MIN_BITS));
+    bitmap_initialize(state->window, TXN_WINDOW_MIN_BITS);
+    state->base = 0;
+    state->window_bits = TXN_WINDOW_MIN_BITS;
     state->low = 0;
-    state->high = 0;
+    state->arrived = 0;
+    state->mempool = NULL;
+    state->mempool_size = 0;
+    state->mempool_pages = 0;
 #ifndef NDEBUG
-    bitmap_check_aux(state->transactions_bitmap, 0);
+    bitmap_check_aux(state->window, 0);
 #endif
 }
 
 void deinitTransactionState(struct TransactionState *state) {
-    rs_free(state->transactions_bitmap);
+    rs_free(state->window);
+    for (size_t i = 0; i < state->mempool_pages; i++) {
+        rs_free(state->mempool[i]);
+    }
+    rs_free(state->mempool);
+}
+
+/**
+ * @brief Draws a number uniformly distributed in [0, 1) for an attribute of a generated transaction
+ *
+ * @param seed the seed of the replica
+ * @param transaction_id the id of the transaction
+ * @param attribute the attribute to draw
+ */
+static double transactionUniform(uint64_t seed, txn_id_t transaction_id, enum txn_attribute attribute) {
+    return CounterRandom(seed, RNG_STREAM(RNG_STREAM_TRANSACTIONS, attribute), transaction_id);
+}
+
+void getTransaction(txn_id_t transaction_id, struct Transaction *transaction) {
+    if (trace_transactions) {
+        *transaction = trace_transactions[transaction_id];
+        return;
+    }
+
+    uint64_t seed = transactions_seed + currentReplica;
+    transaction->timestamp = schedules[currentReplica].timestamps[transaction_id];
+    transaction->sender = CounterRandomU64(seed, RNG_STREAM(RNG_STREAM_TRANSACTIONS, TXN_ATTR_SENDER), transaction_id) % N_NODES;
+    transaction->size = TXN_MIN_SIZE + (size_t) (transactionUniform(seed, transaction_id, TXN_ATTR_SIZE) * (TXN_MAX_SIZE - TXN_MIN_SIZE + 1));
+    transaction->id = transaction_id;
+    transaction->fee = -log(1 - transactionUniform(seed, transaction_id, TXN_ATTR_FEE)) * TXN_MEAN_FEE;
+}
+
+/**
+ * @brief Reads the transactions of the trace file
+ *
+ * The lines holding the transactions, sorted by timestamp, have the format "timestamp sender size fee". Empty lines and
+ * lines starting with '#' are skipped. Only the transactions created before the end of the simulation are kept.
+ */
+static void readTransactionsTrace() {
+    FILE *f = fopen(txnArrivalConfig.traceFile, "r");
+    if (!f) {
+        perror("Could not open the transactions trace file");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t count = 0, capacity = 1024;
+    trace_transactions = malloc(capacity * sizeof(struct Transaction));
+    char *line = NULL;
+    size_t line_len = 0;
+    size_t line_num = 0;
+    while (getline(&line, &line_len, f) != -1) {
+        line_num++;
+        if (line[strspn(line, " \t\r\n")] == '\0' || line[0] == '#') {
+            continue;
+        }
+
+        struct Transaction txn = {.id = count};
+        if (sscanf(line, "%lf %u %zu %lf", &txn.timestamp, &txn.sender, &txn.size, &txn.fee) != 4 ||
+            txn.sender >= N_NODES || (count && txn.timestamp < trace_transactions[count - 1].timestamp)) {
+            fprintf(stderr, "Invalid transaction at line %lu of the trace file %s\n", line_num, txnArrivalConfig.traceFile);
+            exit(EXIT_FAILURE);
+        }
+        if (txn.timestamp > conf.termination_time) {
+            break;
+        }
+
+        if (count == capacity) {
+            capacity *= 2;
+            trace_transactions = realloc(trace_transactions, capacity * sizeof(struct Transaction));
+            if (!trace_transactions) {
+                fprintf(stderr, "Failed to allocate memory for the transactions\n");
+                abort();
+            }
+        }
+        trace_transactions[count++] = txn;
+    }
+    free(line);
+    fclose(f);
+
+    trace_count = count;
+    printf("Read %lu transactions from the trace file %s\n", count, txnArrivalConfig.traceFile);
+}
+
+/**
+ * @brief Runs the arrival process of the current replica, filling in the creation time of its transactions
+ *
+ * The process runs until the end of the simulation, the buffer of the timestamps grows as needed.
+ *
+ * @param schedule the transaction schedule of the replica
+ * @param seed the seed of the replica
+ */
+static void generateTransactionTimestamps(struct TransactionSchedule *schedule, uint64_t seed) {
+    size_t capacity = txnArrivalConfig.type == TXN_ARRIVAL_TRACE ? trace_count + 1 : 1024;
+    schedule->timestamps = malloc(capacity * sizeof(simtime_t));
+    if (!schedule->timestamps) {
+        fprintf(stderr, "Failed to allocate memory for the transactions\n");
+        abort();
+    }
+
+    simtime_t t = 0;
+    size_t i;
+    for (i = 0; txnArrivalConfig.type != TXN_ARRIVAL_TRACE || i < trace_count; i++) {
+        switch (txnArrivalConfig.type) {
+            case TXN_ARRIVAL_POISSON:
+                t += -log(1 - transactionUniform(seed, i, TXN_ATTR_GAP)) / txnArrivalConfig.rate;
+                break;
+            case TXN_ARRIVAL_TRACE:
+                t = trace_transactions[i].timestamp;
+                break;
+            default:
+                t = (double) i * ((double) TXN_NUMBER / TERMINATION_TIME);
+                break;
+        }
+        if (t > conf.termination_time) {
+            break;
+        }
+        if (i == capacity) {
+            capacity *= 2;
+            schedule->timestamps = realloc(schedule->timestamps, capacity * sizeof(simtime_t));
+            if (!schedule->timestamps) {
+                fprintf(stderr, "Failed to allocate memory for the transactions\n");
+                abort();
+            }
+        }
+        schedule->timestamps[i] = t;
+    }
+    schedule->count = i;
+    schedule->timestamps = realloc(schedule->timestamps, (i + 1) * sizeof(simtime_t));
+}
+
+/// A transaction of a region schedule while it is being sorted
+struct ArrivalSortEntry {
+    simtime_t arrival;
+    txn_id_t id;
+};
+
+static int compareArrivals(const void *a, const void *b) {
+    const struct ArrivalSortEntry *x = a, *y = b;
+    if (x->arrival != y->arrival) {
+        return x->arrival < y->arrival ? -1 : 1;
+    }
+    return x->id < y->id ? -1 : x->id > y->id;
+}
+
+/**
+ * @brief Computes the time at which a transaction reaches a region
+ *
+ * @param txn the transaction
+ * @param region the region
+ */
+static simtime_t getTransactionArrivalTime(const struct Transaction *txn, int region) {
+    return txn->timestamp + LATENCIES[getRegion(txn->sender)][region];
+}
+
+void initTransactions(uint64_t seed) {
+    transactions_seed = seed;
+    schedules = calloc(replicas, sizeof(struct TransactionSchedule));
+    if (txnArrivalConfig.type == TXN_ARRIVAL_TRACE) {
+        readTransactionsTrace();
+    }
+
+    for (replica_id_t r = 0; r < replicas; r++) {
+        struct TransactionSchedule *schedule = &schedules[r];
+        generateTransactionTimestamps(schedule, seed + r);
+
+        // Sort the transactions by their arrival time at each region, so that the nodes can pick them up in order
+        currentReplica = r;
+        struct ArrivalSortEntry *entries = malloc((schedule->count + 1) * sizeof(struct ArrivalSortEntry));
+        for (int region = 0; region < REGIONS_NUM; region++) {
+            for (size_t i = 0; i < schedule->count; i++) {
+                struct Transaction txn;
+                getTransaction(i, &txn);
+                entries[i] = (struct ArrivalSortEntry) {.arrival = getTransactionArrivalTime(&txn, region), .id = i};
+            }
+            qsort(entries, schedule->count, sizeof(struct ArrivalSortEntry), compareArrivals);
+
+            schedule->arrivals[region] = malloc((schedule->count + 1) * sizeof(txn_id_t));
+            for (size_t i = 0; i < schedule->count; i++) {
+                schedule->arrivals[region][i] = entries[i].id;
+            }
+        }
+        free(entries);
+    }
+    currentReplica = 0;
+}
+
+void deinitTransactions() {
+    for (replica_id_t r = 0; r < replicas; r++) {
+        free(schedules[r].timestamps);
+        for (int region = 0; region < REGIONS_NUM; region++) {
+            free(schedules[r].arrivals[region]);
+        }
+    }
+    free(schedules);
+    free(trace_transactions);
+    schedules = NULL;
+    trace_transactions = NULL;
+    trace_count = 0;
+}
+
+/**
+ * @brief Returns an entry of the mempool of the node
+ *
+ * @param[in] state the transactionState
+ * @param i the index of the entry in the heap
+ */
+static inline struct MempoolEntry *mempoolAt(const struct TransactionState *state, size_t i) {
+    return &state->mempool[i / TXN_MEMPOOL_PAGE_ENTRIES][i % TXN_MEMPOOL_PAGE_ENTRIES];
+}
+
+/**
+ * @brief Checks if a mempool entry comes before another one. Ties on the fee are broken by the id, so that duplicate
+ * entries are popped one after the other
+ */
+static inline bool mempoolBefore(const struct MempoolEntry *a, const struct MempoolEntry *b) {
+    return a->fee > b->fee || (a->fee == b->fee && a->id > b->id);
+}
+
+/**
+ * @brief Adds a transaction to the mempool of the node
+ *
+ * @param[in,out] state the transactionState
+ * @param transaction_id the id of the transaction
+ * @param fee the fee of the transaction
+ */
+static void pushMempool(struct TransactionState *state, txn_id_t transaction_id, double fee) {
+    if (state->mempool_size == state->mempool_pages * TXN_MEMPOOL_PAGE_ENTRIES) {
+        state->mempool = rs_realloc(state->mempool, (state->mempool_pages + 1) * sizeof(struct MempoolEntry *));
+        state->mempool[state->mempool_pages++] = rs_malloc(TXN_MEMPOOL_PAGE_ENTRIES * sizeof(struct MempoolEntry));
+    }
+
+    struct MempoolEntry entry = {.fee = fee, .id = transaction_id};
+    size_t i = state->mempool_size++;
+    while (i) {
+        size_t parent = (i - 1) / 2;
+        if (!mempoolBefore(&entry, mempoolAt(state, parent))) {
+            break;
+        }
+        *mempoolAt(state, i) = *mempoolAt(state, parent);
+        i = parent;
+    }
+    *mempoolAt(state, i) = entry;
+}
+
+/**
+ * @brief Removes the transaction with the highest fee from the mempool of the node
+ *
+ * @param[in,out] state the transactionState, with a non-empty mempool
+ *
+ * @return the removed entry
+ */
+static struct MempoolEntry popMempool(struct TransactionState *state) {
+    struct MempoolEntry top = *mempoolAt(state, 0);
+    struct MempoolEntry last = *mempoolAt(state, --state->mempool_size);
+    size_t n = state->mempool_size;
+    size_t i = 0;
+    while (2 * i + 1 < n) {
+        size_t child = 2 * i + 1;
+        if (child + 1 < n && mempoolBefore(mempoolAt(state, child + 1), mempoolAt(state, child))) {
+            child++;
+        }
+        if (!mempoolBefore(mempoolAt(state, child), &last)) {
+            break;
+        }
+        *mempoolAt(state, i) = *mempoolAt(state, child);
+        i = child;
+    }
+    if (n) {
+        *mempoolAt(state, i) = last;
+    }
+    return top;
+}
+
+/**
+ * @brief Checks if a transaction has been used by the node
+ *
+ * @param[in] state the transactionState
+ * @param transaction_id the id of the transaction to check
+ */
+static bool isTransactionExecuted(const struct TransactionState *state, int transaction_id) {
+    if (transaction_id < state->base) {
+        return true;
+    }
+    if (transaction_id >= state->base + state->window_bits) {
+        return false;
+    }
+    return bitmap_check(state->window, transaction_id - state->base);
 }
 
-void generateTransactions(struct rng_t *rng) {
-    simtime_t increment = ((double) TXN_NUMBER) / TERMINATION_TIME;
-    for (size_t i = 0; i < TXN_NUMBER; i++) {
-        transactions[i].timestamp = (double) i * increment;
-        transactions[i].sender = (node_id_t) Random(rng) * conf.lps;
-        transactions[i].size = i;
-        transactions[i].id = i;
-        transactions[i].fee = (double) i;
+/**
+ * @brief Extends the window of the node, so that it tracks the transactions in [from, to)
+ *
+ * Extending the window backwards marks the newly tracked transactions as used, as they were before the window base.
+ *
+ * @param[in,out] state the transactionState
+ * @param from the index of the first transaction to track
+ * @param to the index of the first transaction past the ones to track
+ */
+static void fitTransactionWindow(struct TransactionState *state, int from, int to) {
+    int base = state->base;
+    int end = state->base + state->window_bits;
+    if (from >= base && to <= end) {
+        return;
+    }
+
+    int new_base = from < base ? from - (int) B_MOD_OF_BPB(from) : base;
+    int new_bits = end - new_base;
+    while (new_base + new_bits < to) {
+        new_bits *= 2;
     }
+
+    block_bitmap *window = rs_malloc(bitmap_required_size(new_bits));
+    size_t prefix_size = (base - new_base) / CHAR_BIT;
+    size_t old_size = bitmap_required_size(state->window_bits);
+    memset(window, 0xff, prefix_size);
+    memcpy(window + prefix_size, state->window, old_size);
+    memset(window + prefix_size + old_size, 0, bitmap_required_size(new_bits) - prefix_size - old_size);
+    rs_free(state->window);
+
+    state->window = window;
+    state->base = new_base;
+    state->window_bits = new_bits;
 }
 
-void markTransactionExecuted(block_bitmap *transactions_bitmap, txn_id_t transaction_id) {
-    bitmap_set(transactions_bitmap, transaction_id);
+/**
+ * @brief Slides the window of the node forward, dropping the used transactions before the first available one
+ *
+ * The window is only compacted once at least half of it is behind state->low, so that the cost is amortized.
+ *
+ * @param[in,out] state the transactionState
+ */
+static void compactTransactionWindow(struct TransactionState *state) {
+    int shift = state->low - state->base;
+    if (shift < state->window_bits / 2) {
+        return;
+    }
+
+    shift -= (int) B_MOD_OF_BPB(shift);
+    if (shift >= state->window_bits) {
+        bitmap_initialize(state->window, state->window_bits);
+    } else {
+        size_t shift_size = shift / CHAR_BIT;
+        size_t size = bitmap_required_size(state->window_bits);
+        memmove(state->window, state->window + shift_size, size - shift_size);
+        memset(state->window + size - shift_size, 0, shift_size);
+    }
+    state->base += shift;
 }
 
-void markTransactionAvailable(block_bitmap *transactions_bitmap, txn_id_t transaction_id) {
-    bitmap_reset(transactions_bitmap, transaction_id);
+void markTransactionExecuted(struct TransactionState *state, txn_id_t transaction_id) {
+    if ((int) transaction_id < state->base) {
+        return;
+    }
+    fitTransactionWindow(state, (int) transaction_id, (int) transaction_id + 1);
+    bitmap_set(state->window, transaction_id - state->base);
 }
 
-simtime_t getTransactionDeliveryTime(txn_id_t transactionId, node_id_t receiver) {
-    struct Transaction *txn = &transactions[transactionId];
-    return txn->timestamp + getTransmissionDelay(txn->sender, receiver, txn->size, NULL);
+void markTransactionAvailable(struct TransactionState *state, txn_id_t transaction_id) {
+    fitTransactionWindow(state, (int) transaction_id, (int) transaction_id + 1);
+    bitmap_reset(state->window, transaction_id - state->base);
 }
 
 /**
- * @brief Updates the node's local view of transactions
+ * @brief Updates the node's local view of transactions, adding the ones which reached its region to its mempool
  *
  * @param[in,out] state the transactionState
  * @param now The current time of the view
+ * @param region The region of the node
  */
-void deliverNewTransactions(struct TransactionState *state, simtime_t now) {
-    while (bitmap_check(state->transactions_bitmap, state->low) && state->low < TXN_NUMBER) {
+void deliverNewTransactions(struct TransactionState *state, simtime_t now, int region) {
+    const struct TransactionSchedule *schedule = &schedules[currentReplica];
+    while (state->low < (int) schedule->count && isTransactionExecuted(state, state->low)) {
         state->low++;
     }
+    compactTransactionWindow(state);
 
-    int i = state->high;
-    if (i < 0) i = 0;
-    while (i < TXN_NUMBER) {
-        if (transactions[i].timestamp > now) {
+    while (state->arrived < schedule->count) {
+        struct Transaction txn;
+        getTransaction(schedule->arrivals[region][state->arrived], &txn);
+        if (getTransactionArrivalTime(&txn, region) > now) {
             break;
         }
-        i++;
+        pushMempool(state, txn.id, txn.fee);
+        state->arrived++;
     }
-    state->high = i;
 }
 
-bool printed = false;
-
 struct TransactionData *generateTransactionData(struct TransactionState *state, simtime_t now, node_id_t me) {
     if (!state) return NULL;
-    deliverNewTransactions(state, now);
-    if (state->high <= state->low) return NULL; // No available transactions
-
-    struct TransactionData *data = allocTransactionData(state->high - state->low); // Naive implementation for now
-    data->low = state->low;
-    data->high = data->low;
-    for (int i = state->low, j = 0; i < state->high; i++, j++) {
-        if (!bitmap_check(state->transactions_bitmap, i) &&
-            (transactions[i].sender == me || getTransactionDeliveryTime(i, me) < now)) {
-            data->high = i;
-            bitmap_set(data->included_transactions, j);
-            // No need to set state->transactions_bitmap as it is set when including the Block
-        }
-    }
-    if (data->high != data->low)
-        data->high++; // high is first unseen
+    deliverNewTransactions(state, now, getRegion(me));
+
+    // Pick the transactions with the highest fees, dropping the used ones and the duplicates found along the way
+    txn_id_t selected[BLOCK_MAX_BYTES / TXN_MIN_SIZE + 1];
+    size_t selected_count = 0;
+    size_t selected_size = 0;
+    txn_id_t low = UINT_MAX, high = 0;
+    while (state->mempool_size) {
+        struct MempoolEntry entry = popMempool(state);
+        if (isTransactionExecuted(state, entry.id) ||
+            (selected_count && selected[selected_count - 1] == entry.id)) {
+            continue;
+        }
+
+        struct Transaction txn;
+        getTransaction(entry.id, &txn);
+        if (selected_size + txn.size > BLOCK_MAX_BYTES || selected_count == sizeof(selected) / sizeof(*selected)) {
+            pushMempool(state, entry.id, entry.fee);
+            break;
+        }
+        selected[selected_count++] = entry.id;
+        selected_size += txn.size;
+        low = entry.id < low ? entry.id : low;
+        high = entry.id > high ? entry.id : high;
+    }
+    if (!selected_count) return NULL; // No available transactions
+
+    // The selected transactions are marked as used when including the Block, and go back to the mempool if it is reverted
+    struct TransactionData *data = allocTransactionData(high - low + 1);
+    data->low = (int) low;
+    data->high = (int) high + 1; // high is first unseen
+    data->count = selected_count;
+    data->size = selected_size;
+    for (size_t i = 0; i < selected_count; i++) {
+        bitmap_set(data->included_transactions, selected[i] - low);
+    }
     return data;
 }
 
-void applyBlockTransactions(struct TransactionState *state, struct TransactionData *data) {
+unsigned getTransactionIds(const struct TransactionData *data, txn_id_t *ids) {
+    unsigned count = 0;
+    for (int i = data->low; i < data->high; i++) {
+        if (bitmap_check(data->included_transactions, i - data->low)) {
+            ids[count++] = i;
+        }
+    }
+    return count;
+}
+
+void fillTransactionData(struct TransactionData *data, const txn_id_t *ids, unsigned count, size_t size) {
+    if (!count) {
+        memset(data, 0, sizeof(struct TransactionData));
+        return;
+    }
+    data->low = (int) ids[0];
+    data->high = (int) ids[count - 1] + 1; // high is first unseen
+    data->count = count;
+    data->size = size;
+    bitmap_initialize(data->included_transactions, data->high - data->low);
+    for (unsigned i = 0; i < count; i++) {
+        bitmap_set(data->included_transactions, ids[i] - data->low);
+    }
+}
+
+unsigned countUnknownTransactions(const struct TransactionState *state, const txn_id_t *ids, unsigned count,
+                                  simtime_t now, int region) {
+    unsigned unknown = 0;
+    for (unsigned i = 0; i < count; i++) {
+        if (isTransactionExecuted(state, (int) ids[i])) {
+            continue;
+        }
+        struct Transaction txn;
+        getTransaction(ids[i], &txn);
+        if (getTransactionArrivalTime(&txn, region) > now) {
+            unknown++;
+        }
+    }
+    return unknown;
+}
+
+void applyBlockTransactions(struct TransactionState *state, const struct TransactionData *data) {
     for (int i = data->low; i < data->high; i++) {
         if (bitmap_check(data->included_transactions, i - data->low)) {
-            markTransactionExecuted(state->transactions_bitmap, i);
+            markTransactionExecuted(state, i);
         }
     }
-    state->high = state->high > data->high ? state->high : data->high;
 }
 
-void revertAppliedBlockTransactions(struct TransactionState *state, struct TransactionData *data) {
+void revertAppliedBlockTransactions(struct TransactionState *state, const struct TransactionData *data) {
     for (int i = data->low; i < data->high; i++) {
         if (bitmap_check(data->included_transactions, i - data->low)) {
-            markTransactionAvailable(state->transactions_bitmap, i);
+            markTransactionAvailable(state, i);
+            struct Transaction txn;
+            getTransaction(i, &txn);
+            pushMempool(state, txn.id, txn.fee);
         }
     }
     state->low = state->low < data->low ? state->low : data->low;
@@ -13,8 +13,33 @@ struct Transaction {
     // double gasUsed;  // The cost, in gas, of executing the transaction. Received currency is gasUsed * gasPrice
 };
 
-extern atomic_bool txns_initialized;
-extern struct Transaction transactions[TXN_NUMBER]; // FIXME INITIALIZE!!
+enum txn_arrival_type {
+    TXN_ARRIVAL_RAMP,    ///< Transactions are created at a constant rate
+    TXN_ARRIVAL_POISSON, ///< Transactions are created by a Poisson process
+    TXN_ARRIVAL_TRACE,   ///< Transactions are read from a trace file
+};
+
+// Holds the configuration for the transactions arrival process
+struct txn_arrival_config {
+    enum txn_arrival_type type;
+    double rate;           ///< Transactions per second of the Poisson process
+    const char *traceFile; ///< Path of the trace file. Each line holds the timestamp, sender, size and fee of a transaction
+};
+
+extern struct txn_arrival_config txnArrivalConfig;
+extern uint64_t transactions_seed; ///< The seed the transaction attributes are derived from
+
+/// The transactions of a replica, along with the order in which they reach each region
+struct TransactionSchedule {
+    size_t count;                     ///< Number of transactions created before the end of the simulation
+    simtime_t *timestamps;            ///< Creation time of each transaction
+    txn_id_t *arrivals[REGIONS_NUM];  ///< IDs of the transactions, sorted by their arrival time at each region
+};
+
+/// The initial number of transactions tracked by the window of a TransactionState
+#define TXN_WINDOW_MIN_BITS 1024
+/// The number of entries of a page of the mempool of a TransactionState, which keeps the pages below 64 KB
+#define TXN_MEMPOOL_PAGE_ENTRIES 2048
 
 #define TXN_DATA_MIN_TXNS 16
 #define TXN_DATA_MIN_BITMAP_SIZE bitmap_required_size(TXN_DATA_MIN_TXNS)
@@ -22,15 +47,28 @@ extern struct Transaction transactions[TXN_NUMBER]; // FIXME INITIALIZE!!
 struct TransactionData {
     int low;
     int high;
+    unsigned count; ///< Number of included transactions
+    size_t size;    ///< Total size of the included transactions, in Bytes
     block_bitmap included_transactions[TXN_DATA_MIN_BITMAP_SIZE];
     block_bitmap included_transactions_ext[];
 };
 
+/// An entry of the mempool of a node
+struct MempoolEntry {
+    double fee;
+    txn_id_t id;
+};
+
 /// Struct holding the relevant information for transaction management
 struct TransactionState {
-    block_bitmap *transactions_bitmap;  ///< Bitmap tracking transaction execution. 1 Means available, 0 means used
-    int low;                            ///< index of the first transaction still available
-    int high;                           ///< index of the latest seen transaction
+    block_bitmap *window;  ///< Bitmap tracking the execution of the transactions in [base, base + window_bits). 1 Means used, 0 means available
+    int base;              ///< index of the first transaction tracked by the window. Every transaction before it is used
+    int window_bits;       ///< number of transactions tracked by the window, a multiple of B_BITS_PER_BLOCK
+    int low;               ///< index of the first transaction still available
+    size_t arrived;        ///< number of transactions of the region arrival schedule already in the mempool
+    struct MempoolEntry **mempool; ///< Max-heap of the transactions known to the node, by fee, split in pages. Used transactions are dropped lazily
+    size_t mempool_size;     ///< number of entries in the mempool
+    size_t mempool_pages;    ///< number of allocated mempool pages
 };
 
 /**
@@ -50,10 +88,28 @@ size_t sizeofTransactionData(const struct TransactionData *data);
 size_t sizeofAdditionalTransactionDataBuffer(size_t transactions_count);
 
 /**
- * @brief Generates all transactions, for the entire simulation
- * TODO
+ * @brief Sets up the transactions source for a simulation
+ *
+ * The arrival process of txnArrivalConfig is run for each replica, and the order in which its transactions reach each
+ * region is precomputed. Unless they come from a trace, the other transaction attributes are computed on demand from
+ * their id and @a seed.
+ *
+ * @param seed The seed the transaction attributes are derived from. Each replica offsets it by its id
  */
-void generateTransactions(struct rng_t *rng);
+void initTransactions(uint64_t seed);
+
+/**
+ * @brief Releases the resources allocated by initTransactions()
+ */
+void deinitTransactions();
+
+/**
+ * @brief Computes the attributes of a transaction
+ *
+ * @param transaction_id the id of the transaction
+ * @param[out] transaction the transaction to fill in
+ */
+void getTransaction(txn_id_t transaction_id, struct Transaction *transaction);
 /**
  * @brief Generates a transaction
  * TODO
@@ -74,17 +130,17 @@ simtime_t validateTransaction(struct Transaction *transaction, bool *is_valid);
  * @brief Applies the effect of @a transactionData on @a transactionState
  *
  * @param[in] transactionState pointer to the TransactionState to apply the transactions to
- * @param[in/out] transactionData pointer to the block's transactionData
+ * @param[in] transactionData pointer to the block's transactionData
  */
-void applyBlockTransactions(struct TransactionState *transactionState, struct TransactionData *transactionData);
+void applyBlockTransactions(struct TransactionState *transactionState, const struct TransactionData *transactionData);
 
 /**
  * @brief Reverts the effects of applying @a transactionData from @a transactionState
  *
  * @param[in] transactionState pointer to the TransactionState to revert from
- * @param[in/out] transactionData pointer to the block's transactionData to revert
+ * @param[in] transactionData pointer to the block's transactionData to revert
  */
-void revertAppliedBlockTransactions(struct TransactionState *transactionState, struct TransactionData *transactionData);
+void revertAppliedBlockTransactions(struct TransactionState *transactionState, const struct TransactionData *transactionData);
 
 /**
  * @brief Computes how long transaction execution will take
@@ -98,12 +154,50 @@ simtime_t executeTransaction(struct Transaction *transaction);
 /**
  * @brief Selects transactions to include in a block and creates TransactionData object
  *
+ * The available transactions with the highest fees are selected, up to BLOCK_MAX_BYTES.
+ *
  * @param[in,out] state the transaction management state
  * @param now the current time
  * @param me the id of the node generating transactionData
  */
 struct TransactionData *generateTransactionData(struct TransactionState *state, simtime_t now, node_id_t me);
 
+/**
+ * @brief Lists the ids of the transactions included in @a data
+ *
+ * @param[in] data the TransactionData to read
+ * @param[out] ids the array to fill in, sorted by id. Must hold data->count entries
+ *
+ * @return The number of ids written
+ */
+unsigned getTransactionIds(const struct TransactionData *data, txn_id_t *ids);
+
+/**
+ * @brief Fills in a TransactionData from the ids of the included transactions
+ *
+ * @param[out] data the TransactionData to fill in. Must be large enough to hold the [ids[0], ids[count - 1]] range
+ * @param[in] ids the ids of the included transactions, sorted by id
+ * @param count the number of ids
+ * @param size the total size of the included transactions, in Bytes
+ */
+void fillTransactionData(struct TransactionData *data, const txn_id_t *ids, unsigned count, size_t size);
+
+/**
+ * @brief Counts the transactions a node has not seen yet
+ *
+ * A transaction is known to the node if it has been used, or if it has already reached the region of the node.
+ *
+ * @param[in] state the transaction management state of the node
+ * @param[in] ids the ids of the transactions to check
+ * @param count the number of ids
+ * @param now the current time
+ * @param region the region of the node
+ *
+ * @return The number of transactions missing from the local view of the node
+ */
+unsigned countUnknownTransactions(const struct TransactionState *state, const txn_id_t *ids, unsigned count,
+                                  simtime_t now, int region);
+
 /**
  * @brief Computes the transaction reward
  *
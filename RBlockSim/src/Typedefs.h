@@ -7,3 +7,4 @@ typedef uint32_t node_id_t;
 typedef uint32_t block_id_t;
 typedef uint32_t block_seq_id_t; ///< Miner-level sequential ID for Blocks, unique in each miner
 typedef unsigned txn_id_t;
+typedef uint32_t replica_id_t; ///< ID of an independent replica of the network, in ensemble runs
@@ -14,6 +14,21 @@
  */
 double NormalExpanded(struct rng_t *ctx, double mean, double std_dev);
 
+/**
+ * The random streams of a replica, all derived from its seed with the XXTEA construction of ROOT-Sim_rng
+ * (initialize_counter_stream() for the stateful streams, CounterRandomU64() for the counter-based ones)
+ * */
+enum rng_stream_type {
+    RNG_STREAM_NODE,         ///< Indexed by node, the stream of the node events
+    RNG_STREAM_EVENT,        ///< Indexed by event type and node, the stateless streams of the node events, one per event time
+    RNG_STREAM_ATTACKERS,    ///< The selection of the attackers
+    RNG_STREAM_TRANSACTIONS, ///< Indexed by attribute, the counter-based streams of the generated transactions
+    RNG_STREAM_STAKES        ///< The counter-based stream of the stakes and of the slot leaders (proof of stake)
+};
+
+/// The id of the random stream of type `type` with index `index`, which must be lower than 2^56
+#define RNG_STREAM(type, index) (((uint64_t) (type) << 56) | (uint64_t) (index))
+
 /**
  * @brief Debug wrapper for bitmap_check. Checks a bit in a bitmap
  *
@@ -1,33 +1,36 @@
 #include "../src/Block.h"
+#include "../src/BlockStore.h"
+#include "../src/Attacks.h"
 #include <ROOT-Sim/random.h>
 #include <assert.h>
 #include <string.h>
 
 #define isOrphan(ChainNode_ptr) ((ChainNode_ptr)->flags & CHAIN_NODE_FLAG_ORPHAN)
 
-extern struct ChainNode genesis_block;
+extern const struct ChainNode genesis_block;
 
-extern void printChainNode(struct ChainNode *node);
+extern void printChainNode(const struct ChainNode *node);
 
-extern void sprintChainNode(struct ChainNode *node, char *outbuf);
+extern void sprintChainNode(const struct ChainNode *node, char *outbuf);
 
-extern void printChainLevel(struct ChainLevel *level);
+extern void printChainLevel(const struct ChainLevel *level);
 
-extern void sprintChainLevel(struct ChainLevel *level, char *outbuf);
+extern void sprintChainLevel(const struct ChainLevel *level, char *outbuf);
 
-extern void printChain(struct Blockchain *chain);
+extern void printChain(const struct Blockchain *chain);
 
-extern void sprintChain(struct Blockchain *chain, char *outbuf);
+extern void sprintChain(const struct Blockchain *chain, char *outbuf);
 
 extern simtime_t getNextGenDelay(struct rng_t *rng, double hashPowerPortion);
 
 extern void initChainLevel(struct ChainLevel *chainLevel);
 
 extern void
-applyChainNode(struct Blockchain *blockchain, struct TransactionState *transactionState, struct ChainNode *node);
+applyChainNode(struct Blockchain *blockchain, struct TransactionState *transactionState, struct ChainNode *node,
+               node_id_t me, struct StatsState *statsState);
 
 extern void revertAppliedChainNode(struct Blockchain *blockchain, struct TransactionState *transactionState,
-                                   struct ChainNode *node);
+                                   struct ChainNode *node, node_id_t me, struct StatsState *statsState);
 
 extern void initBlockchain(struct Blockchain *chain);
 
@@ -53,25 +56,25 @@ unorphanBlocks(struct Blockchain *chain, struct ChainNode *parent, size_t parent
 
 extern void
 switchChains(struct Blockchain *chain, struct TransactionState *transactionState, struct ChainNode *new_chain_node,
-             size_t new_chain_index);
+             size_t new_chain_index, node_id_t me, struct StatsState *statsState);
 
 extern void
 maybeSwitchChains(struct Blockchain *chain, struct TransactionState *transactionState, struct ChainNode *new_chain_node,
-                  size_t new_chain_index);
+                  size_t new_chain_index, node_id_t me, struct StatsState *statsState);
 
 extern struct ChainNode *addBlock(simtime_t now, struct Blockchain *chain, struct TransactionState *transactionState,
-                                  const struct Block *block);
+                                  const struct Block *block, node_id_t me, struct StatsState *statsState);
 
 extern struct Block *
-generateBlock(node_id_t me, simtime_t now, struct BlockchainState *state, struct TransactionState *transactionState);
+generateBlock(node_id_t me, simtime_t now, struct BlockchainState *state, struct TransactionState *transactionState,
+              struct StatsState *statsState);
 
 extern simtime_t receiveBlock(simtime_t now, struct BlockchainState *state, struct TransactionState *transactionState,
-                              const struct Block *block, bool *updatedMainChain, bool *foundParent);
+                              const struct Block *block, node_id_t me, struct StatsState *statsState,
+                              bool *updatedMainChain, bool *foundParent);
 
 extern void deinitBlockchainState(struct BlockchainState *state);
 
-extern void deinitChainNode(struct ChainNode *node);
-
 extern void deinitChainLevel(struct ChainLevel *level);
 
 extern void deinitBlockChain(struct Blockchain *chain);
@@ -84,7 +87,7 @@ struct rng_t *init_rng() {
     return rng;
 }
 
-bool chainNodeEquals(struct ChainNode *a, struct ChainNode *b) {
+bool chainNodeEquals(const struct ChainNode *a, const struct ChainNode *b) {
     return a->flags == b->flags && a->score == b->score && a->height == b->height && a->miner == b->miner &&
            a->transactionData == b->transactionData && a->timestamp == b->timestamp &&
            a->parent_index == b->parent_index;
@@ -101,7 +104,7 @@ addBlockWrapper(struct Blockchain *chain, struct TransactionState *transactionSt
     block->prevBlockMiner = prev_block_miner;
     block->miner = miner;
     block->height = height;
-    struct ChainNode *ptr = addBlock(block->timestamp + 10, chain, transactionState, block);
+    struct ChainNode *ptr = addBlock(block->timestamp + 10, chain, transactionState, block, 0, NULL);
     struct ChainNode *chainNode = malloc(sizeof(struct ChainNode));
     memcpy(chainNode, ptr, sizeof(struct ChainNode));
     *index = getChainLevel(chain, height)->size - 1;
@@ -173,7 +176,7 @@ void testGenerateBlock() {
     struct BlockchainState *state = malloc(sizeof(struct BlockchainState));
     initBlockchainState(state, rng);
 
-    struct Block *block = generateBlock(0, 1, state, NULL);
+    struct Block *block = generateBlock(0, 1, state, NULL, NULL);
     assert(block->transactionData.low == 0);
     assert(block->transactionData.high == 0);
     assert(block->timestamp == 1);
@@ -184,7 +187,7 @@ void testGenerateBlock() {
     assert(n1->score == 1);
     assert(n1->ancestorsMined == 1);
 
-    struct Block *block2 = generateBlock(0, 2, state, NULL);
+    struct Block *block2 = generateBlock(0, 2, state, NULL, NULL);
     assert(block2->transactionData.low == 0);
     assert(block2->transactionData.high == 0);
     assert(block2->timestamp == 2);
@@ -200,7 +203,7 @@ void testGenerateBlock() {
     assert(n3->height == 3);
     assert(!memcmp(getMainChain(&state->chain), n3, sizeof(struct ChainNode))); // New main chain
 
-    struct Block *block4 = generateBlock(0, 9, state, NULL);
+    struct Block *block4 = generateBlock(0, 9, state, NULL, NULL);
     assert(block4->transactionData.low == 0);
     assert(block4->transactionData.high == 0);
     assert(block4->timestamp == 9);
@@ -216,7 +219,7 @@ void testGenerateBlock() {
     assert(n4b->height == 4);
     assert(memcmp(getMainChain(&state->chain), n4b, sizeof(struct ChainNode)) != 0); // NOT new main chain
 
-    struct Block *block5 = generateBlock(0, 20, state, NULL);
+    struct Block *block5 = generateBlock(0, 20, state, NULL, NULL);
     assert(block5->transactionData.low == 0);
     assert(block5->transactionData.high == 0);
     assert(block5->timestamp == 20);
@@ -245,7 +248,6 @@ void testGenerateBlock() {
     free(state);
     free(n3);
     free(n4b);
-    free(n5.transactionData);
     printf("SUCCESS\n");
 }
 
@@ -460,7 +462,7 @@ void testApplyChainNode() {
     struct BlockchainState *state = malloc(sizeof(struct BlockchainState));
     initBlockchainState(state, rng);
 
-    struct Block *block = generateBlock(0, 20, state, NULL);
+    struct Block *block = generateBlock(0, 20, state, NULL, NULL);
     assert(block->transactionData.low == 0);
     assert(block->transactionData.high == 0);
     assert(block->timestamp == 20);
@@ -470,13 +472,12 @@ void testApplyChainNode() {
     struct ChainNode node;
     populateChainNode(block, &node);
 
-    applyChainNode(&state->chain, NULL, &node);
+    applyChainNode(&state->chain, NULL, &node, 0, NULL);
     assert(state->chain.height == block->height);
 
     free(rng);
     free(block);
     deinitBlockchainState(state);
-    free(node.transactionData);
     free(state);
     printf("SUCCESS\n");
 }
@@ -492,7 +493,7 @@ void testGetChainNode() {
     assert(!memcmp(getChainNode(chain, 0, 0), &genesis_block, s));
     assert(!memcmp(getChainNode(chain, 0, 0), &chain->old_levels[0].nodes[0], s));
 
-    struct Block *block = generateBlock(0, 20, state, NULL);
+    struct Block *block = generateBlock(0, 20, state, NULL, NULL);
     assert(block->transactionData.low == 0);
     assert(block->transactionData.high == 0);
     assert(block->timestamp == 20);
@@ -563,7 +564,6 @@ void testGetChainNode() {
     free(node_d);
     free(rng);
     free(block);
-    free(node_e.transactionData);
     deinitBlockchainState(state);
     free(state);
     printf("SUCCESS\n");
@@ -576,7 +576,7 @@ void testRevertAppliedChainNode() {
     struct BlockchainState *state = malloc(sizeof(struct BlockchainState));
     initBlockchainState(state, rng);
 
-    struct Block *block = generateBlock(0, 20, state, NULL);
+    struct Block *block = generateBlock(0, 20, state, NULL, NULL);
     assert(block->transactionData.low == 0);
     assert(block->transactionData.high == 0);
     assert(block->timestamp == 20);
@@ -587,16 +587,15 @@ void testRevertAppliedChainNode() {
     populateChainNode(block, &node);
     node.parent_index = 0;
 
-    revertAppliedChainNode(&state->chain, NULL, &node);
+    revertAppliedChainNode(&state->chain, NULL, &node, 0, NULL);
     assert(state->chain.height == genesis_block.height);
     assert(chainNodeEquals(getMainChain(&state->chain), &genesis_block));
 
-    applyChainNode(&state->chain, NULL, &node);
+    applyChainNode(&state->chain, NULL, &node, 0, NULL);
     assert(state->chain.height == block->height);
 
     free(rng);
     free(block);
-    free(node.transactionData);
     deinitBlockchainState(state);
     free(state);
     printf("SUCCESS\n");
@@ -684,39 +683,39 @@ void testSwitchChains() {
 
     // Switching to the same chain and same block should have no effect
     assert(getMainChain(chain) == getChainNode(chain, 10, 0));
-    switchChains(chain, transactionState, getMainChain(chain), 0);
+    switchChains(chain, transactionState, getMainChain(chain), 0, 0, NULL);
     assert(getMainChain(chain) == getChainNode(chain, 10, 0));
 
     // Switch to another chain
-    switchChains(chain, transactionState, getChainNode(chain, 10, 1), 1);
+    switchChains(chain, transactionState, getChainNode(chain, 10, 1), 1, 0, NULL);
     assert(getMainChain(chain) == getChainNode(chain, 10, 1));
 
     // Same chain, back by one
-    switchChains(chain, transactionState, getChainNode(chain, 9, 1), 1);
+    switchChains(chain, transactionState, getChainNode(chain, 9, 1), 1, 0, NULL);
     assert(getMainChain(chain) == getChainNode(chain, 9, 1));
 
     // Same chain, back by 3
-    switchChains(chain, transactionState, getChainNode(chain, 6, 1), 1);
+    switchChains(chain, transactionState, getChainNode(chain, 6, 1), 1, 0, NULL);
     assert(getMainChain(chain) == getChainNode(chain, 6, 1));
 
     // Forward again
-    switchChains(chain, transactionState, getChainNode(chain, 10, 1), 1);
+    switchChains(chain, transactionState, getChainNode(chain, 10, 1), 1, 0, NULL);
     assert(getMainChain(chain) == getChainNode(chain, 10, 1));
 
     // Other chain, back by 4
-    switchChains(chain, transactionState, getChainNode(chain, 6, 0), 0);
+    switchChains(chain, transactionState, getChainNode(chain, 6, 0), 0, 0, NULL);
     assert(getMainChain(chain) == getChainNode(chain, 6, 0));
 
     // Back to last on chain 0
-    switchChains(chain, transactionState, getChainNode(chain, 10, 0), 0);
+    switchChains(chain, transactionState, getChainNode(chain, 10, 0), 0, 0, NULL);
     assert(getMainChain(chain) == getChainNode(chain, 10, 0));
 
     // Back to complete start
-    switchChains(chain, transactionState, getChainNode(chain, 0, 0), 0);
+    switchChains(chain, transactionState, getChainNode(chain, 0, 0), 0, 0, NULL);
     assert(getMainChain(chain) == getChainNode(chain, 0, 0));
 
     // Again last on chain 0
-    switchChains(chain, transactionState, getChainNode(chain, 10, 0), 0);
+    switchChains(chain, transactionState, getChainNode(chain, 10, 0), 0, 0, NULL);
     assert(getMainChain(chain) == getChainNode(chain, 10, 0));
 
     deinitTransactionState(transactionState);
@@ -727,6 +726,63 @@ void testSwitchChains() {
     //printf("SUCCESS\n");
 }
 
+void testGhostForkChoice() {
+    printf("Testing GHOST fork choice... ");
+
+    struct rng_t *rng = init_rng();
+    struct BlockchainState *state = malloc(sizeof(struct BlockchainState));
+    initBlockchainState(state, rng);
+    struct Blockchain *chain = &state->chain;
+    forkChoice = FORK_CHOICE_GHOST;
+
+    // A chain of 4 blocks mined by node 1
+    size_t index;
+    for (size_t i = 1; i < 5; i++) {
+        free(addBlockWrapper(chain, NULL, (double) i, i == 1 ? genesis_block.miner : 1, 1, i, &index));
+    }
+    assert(getMainChain(chain) == getChainNode(chain, 4, 0));
+
+    // A fork of height 2, whose subtree grows to the same weight of the longer chain, then to a heavier one
+    free(addBlockWrapper(chain, NULL, 10, genesis_block.miner, 2, 1, &index));
+    assert(index == 1);
+    for (node_id_t miner = 2; miner < 5; miner++) {
+        free(addBlockWrapper(chain, NULL, 10 + miner, 2, miner, 2, &index));
+        assert(getMainChain(chain) == getChainNode(chain, 4, 0));
+    }
+    assert(getChainNode(chain, 1, 1)->weight == getChainNode(chain, 1, 0)->weight);
+    free(addBlockWrapper(chain, NULL, 15, 2, 5, 2, &index));
+
+    // The heavier subtree wins over the longer chain. Its children weigh the same, the earliest received one is the head
+    assert(chain->height == 2);
+    assert(getMainChain(chain) == getChainNode(chain, 2, 1));
+
+    // Reverting the blocks of the longer chain leaves the weights of the subtrees untouched
+    assert(getChainNode(chain, 0, 0)->weight == 10);
+    assert(getChainNode(chain, 1, 1)->weight == 5);
+    for (size_t i = 1; i < 5; i++) {
+        assert(getChainNode(chain, i, 0)->weight == 5 - i);
+    }
+    for (size_t i = 1; i < 5; i++) {
+        assert(getChainNode(chain, 2, i)->weight == 1);
+    }
+
+    // The longer chain grows heavier again, and is switched back to
+    free(addBlockWrapper(chain, NULL, 20, 1, 1, 5, &index));
+    assert(getMainChain(chain) == getChainNode(chain, 2, 1));
+    free(addBlockWrapper(chain, NULL, 21, 1, 1, 6, &index));
+    assert(chain->height == 6);
+    assert(getMainChain(chain) == getChainNode(chain, 6, 0));
+    assert(getChainNode(chain, 1, 0)->weight == 6);
+    assert(getChainNode(chain, 1, 1)->weight == 5);
+    assert(getChainNode(chain, 0, 0)->weight == 12);
+
+    forkChoice = FORK_CHOICE_LONGEST;
+    deinitBlockchainState(state);
+    free(state);
+    free(rng);
+    printf("SUCCESS\n");
+}
+
 void testReceiveBlock() {
     printf("Testing receiveBlock... ");
 
@@ -739,8 +795,6 @@ void testReceiveBlock() {
     struct TransactionState transactionState;
     initTransactionState(&transactionState);
 
-    assert(TXN_NUMBER > 0);
-
     // Generate a block
     // Generic block
     struct Block *block = calloc(1, sizeof(struct Block));
@@ -751,6 +805,7 @@ void testReceiveBlock() {
     block->height = 1;
     block->transactionData.low = 0;
     block->transactionData.high = TXN_DATA_MIN_TXNS;
+    block->transactionData.count = TXN_DATA_MIN_TXNS / 2;
     bitmap_initialize(block->transactionData.included_transactions, TXN_DATA_MIN_TXNS);
     for (int i = 0; i < TXN_DATA_MIN_TXNS; i += 2) {
         bitmap_set(block->transactionData.included_transactions, i);
@@ -759,18 +814,20 @@ void testReceiveBlock() {
     // ReceiveBlock
     bool updated_main_chain = false;
     bool found_parent = false;
-    receiveBlock(block->timestamp + 1, state, &transactionState, block, &updated_main_chain, &found_parent);
+    receiveBlock(block->timestamp + 1, state, &transactionState, block, 0, NULL, &updated_main_chain, &found_parent);
+    assert(updated_main_chain);
+    assert(found_parent);
 
     // Validate that
     // 1. The block was applied properly
     assert(!memcmp(getMainChain(chain), &chain->old_levels[1].nodes[0], sizeof(struct ChainNode)));
     assert(transactionState.low == 0);
-    assert(transactionState.high == block->transactionData.high);
+    assert(transactionState.base == 0);
     for (int i = 0; i < TXN_DATA_MIN_TXNS; i += 2) {
-        assert(bitmap_check(transactionState.transactions_bitmap, i));
+        assert(bitmap_check(transactionState.window, i));
     }
     for (int i = 1; i < TXN_DATA_MIN_TXNS; i += 2) {
-        assert(!bitmap_check(transactionState.transactions_bitmap, i));
+        assert(!bitmap_check(transactionState.window, i));
     }
 
     // 2. The ChainNode is correctly generated from the Block.
@@ -793,6 +850,9 @@ void testReceiveBlock() {
 
 void block_main() {
     printf("TESTING BLOCK\n");
+    totalHashPower = calloc(replicas, sizeof(*totalHashPower));
+    initBlockStore();
+    initAttackers(0);
     testGetNextGenDelay();
     testInitChainLevel();
     testInitBlockchain();
@@ -801,8 +861,13 @@ void block_main() {
     testApplyChainNode();
     testRevertAppliedChainNode();
     testSwitchChains();
+    testGhostForkChoice();
     testAddBlock();
     testGenerateBlock();
     testReceiveBlock();
+    deinitAttackers();
+    deinitBlockStore();
+    free(totalHashPower);
+    totalHashPower = NULL;
     printf("FINISHED TESTING BLOCK, SUCCESS!\n");
 }
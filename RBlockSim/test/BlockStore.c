@@ -0,0 +1,94 @@
+#include "../src/BlockStore.h"
+#include <assert.h>
+#include <string.h>
+
+/**
+ * @brief Builds the transactions of a test block, told apart from the others of the same height by @a tag
+ */
+static struct TransactionData *testTransactionData(uint8_t tag) {
+    struct TransactionData *data = calloc(1, sizeof(struct TransactionData));
+    data->low = 0;
+    data->high = 8;
+    data->count = 1;
+    data->size = TXN_MIN_SIZE;
+    data->included_transactions[0] = tag;
+    return data;
+}
+
+/**
+ * @brief Releases the heights below @a height for every node but @a kept
+ */
+static void releaseAllBut(node_id_t kept, size_t height) {
+    for (node_id_t n = 0; n < N_NODES; n++) {
+        if (n != kept) {
+            releaseTransactionData(n, height);
+        }
+    }
+}
+
+void testStoreSharedTransactionData() {
+    printf("Testing storeTransactionData (shared)... ");
+    fflush(stdout);
+
+    struct TransactionData *data = testTransactionData(1);
+    struct TransactionData *other = testTransactionData(2);
+
+    const struct TransactionData *stored = storeTransactionData(3, 1, data);
+    assert(stored != data);
+    assert(!memcmp(stored, data, sizeofTransactionData(data)));
+    assert(countStoredTransactionData() == 1);
+    // Nodes storing the same block get the same copy
+    assert(storeTransactionData(3, 1, data) == stored);
+    // A different block with the same key gets its own copy
+    assert(storeTransactionData(3, 1, other) != stored);
+    assert(storeTransactionData(4, 1, data) != stored);
+    assert(countStoredTransactionData() == 3);
+
+    // The entries survive as long as a node still holds their height
+    releaseAllBut(7, 2);
+    assert(countStoredTransactionData() == 3);
+    assert(storeTransactionData(3, 1, data) == stored);
+    // Releasing a height again has no effect
+    releaseAllBut(7, 2);
+    releaseTransactionData(7, 1);
+    assert(countStoredTransactionData() == 3);
+
+    releaseTransactionData(7, 2);
+    assert(countStoredTransactionData() == 0);
+
+    free(data);
+    free(other);
+    printf("SUCCESS\n");
+}
+
+void testStoreBounded() {
+    printf("Testing storeTransactionData (bounded)... ");
+    fflush(stdout);
+
+    struct TransactionData *data = testTransactionData(1);
+    size_t horizon = 2;
+    // The heights are released in steps, as the chains of the nodes move forward. The store never holds more than the
+    // entries above the horizon, even after going round its window several times
+    for (size_t height = 2; height < 4 * BLOCK_STORE_WINDOW; height++) {
+        storeTransactionData(height % N_NODES, height, data);
+        if (height - horizon >= 2 * DEPTH_TO_KEEP) {
+            horizon += DEPTH_TO_KEEP;
+            releaseAllBut(N_NODES, horizon);
+        }
+        assert(countStoredTransactionData() == height + 1 - horizon);
+    }
+    releaseAllBut(N_NODES, 4 * BLOCK_STORE_WINDOW);
+    assert(countStoredTransactionData() == 0);
+
+    free(data);
+    printf("SUCCESS\n");
+}
+
+void blockstore_main() {
+    printf("TESTING BLOCK STORE\n");
+    initBlockStore();
+    testStoreSharedTransactionData();
+    testStoreBounded();
+    deinitBlockStore();
+    printf("FINISHED TESTING BLOCK STORE, SUCCESS!\n");
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void blockstore_main();
@@ -1,10 +1,13 @@
 #include <stdio.h>
 #include "Block.h"
+#include "BlockStore.h"
 #include "Transaction.h"
 
 int main() {
     printf("TESTING\n\n");
     block_main();
     printf("\n\n");
+    blockstore_main();
+    printf("\n\n");
     transaction_main();
 }
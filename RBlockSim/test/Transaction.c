@@ -1,33 +1,101 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
 #include <ROOT-Sim/random.h>
 #include <assert.h>
 #include <string.h>
 #include "../src/Transaction.h"
 
-extern struct rng_t *init_rng();
+extern struct TransactionSchedule *schedules;
 
 extern struct TransactionData *allocTransactionData(size_t transactions_count);
 
-extern void markTransactionExecuted(block_bitmap *transactions_bitmap, txn_id_t transaction_id);
+extern void markTransactionExecuted(struct TransactionState *state, txn_id_t transaction_id);
 
-extern void markTransactionAvailable(block_bitmap *transactions_bitmap, txn_id_t transaction_id);
+extern void markTransactionAvailable(struct TransactionState *state, txn_id_t transaction_id);
 
-extern simtime_t getTransactionDeliveryTime(txn_id_t transactionId, node_id_t receiver);
-
-extern void deliverNewTransactions(struct TransactionState *state, simtime_t now);
+extern void deliverNewTransactions(struct TransactionState *state, simtime_t now, int region);
 
 extern void initNetwork();
 
+extern int getRegion(node_id_t node);
+
+/**
+ * @brief Sets up the transactions source of the tests from a trace holding @a count transactions
+ *
+ * Transaction i is created at time i by node 0 and has fee i, unless overridden by @a txns.
+ *
+ * @param count the number of transactions of the trace
+ * @param txns the transactions to write in place of the default ones, NULL to use the default ones only
+ * @param txns_count the number of transactions in @a txns, with ids in [0, count)
+ */
+static void initTestTransactions(size_t count, const struct Transaction *txns, size_t txns_count) {
+    char path[] = "/tmp/rblocksim_test_trace_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd != -1);
+    FILE *f = fdopen(fd, "w");
+    assert(f);
+    for (size_t i = 0; i < count; i++) {
+        struct Transaction txn = {.timestamp = (double) i, .sender = 0, .size = TXN_MIN_SIZE, .fee = (double) i};
+        for (size_t j = 0; j < txns_count; j++) {
+            if (txns[j].id == i) {
+                txn = txns[j];
+            }
+        }
+        fprintf(f, "%.17g %u %zu %.17g\n", txn.timestamp, txn.sender, txn.size, txn.fee);
+    }
+    fclose(f);
+
+    initNetwork();
+    txnArrivalConfig.type = TXN_ARRIVAL_TRACE;
+    txnArrivalConfig.traceFile = path;
+    initTransactions(0);
+    unlink(path);
+    txnArrivalConfig.type = TXN_ARRIVAL_RAMP;
+    txnArrivalConfig.traceFile = NULL;
+    assert(schedules[0].count == count);
+}
+
+/**
+ * @brief Checks whether a transaction is marked as used in the window of a TransactionState
+ */
+static bool isExecuted(const struct TransactionState *state, int transaction_id) {
+    if (transaction_id < state->base) {
+        return true;
+    }
+    if (transaction_id >= state->base + state->window_bits) {
+        return false;
+    }
+    return bitmap_check(state->window, transaction_id - state->base);
+}
+
+/**
+ * @brief Checks whether a transaction is in the mempool of a TransactionState
+ */
+static bool inMempool(const struct TransactionState *state, txn_id_t transaction_id) {
+    for (size_t i = 0; i < state->mempool_size; i++) {
+        if (state->mempool[i / TXN_MEMPOOL_PAGE_ENTRIES][i % TXN_MEMPOOL_PAGE_ENTRIES].id == transaction_id) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void testInitTransactionState() {
     printf("Testing testInitTransactionState... ");
     fflush(stdout);
 
     struct TransactionState s;
     initTransactionState(&s);
-    assert(s.transactions_bitmap);
-    assert(!s.transactions_bitmap[0]);
+    assert(s.window);
+    assert(s.window_bits == TXN_WINDOW_MIN_BITS);
+    for (int i = 0; i < s.window_bits; i++) {
+        assert(!bitmap_check(s.window, i));
+    }
+    assert(!s.base);
     assert(!s.low);
-    assert(!s.high);
+    assert(!s.arrived);
+    assert(!s.mempool_size);
 
     deinitTransactionState(&s);
     printf("SUCCESS\n");
@@ -37,41 +105,100 @@ void testGenerateTransactions() {
     printf("Testing testGenerateTransactions... ");
     fflush(stdout);
 
-    struct rng_t *rng = init_rng();
-    memset(&transactions, 0, sizeof(struct Transaction) * TXN_NUMBER);
-    generateTransactions(rng);
-    for (size_t i = 0; i < TXN_NUMBER; i++) {
-        struct Transaction *txn = &transactions[i];
-        assert(txn->id == i);
-        assert(txn->timestamp >= 0.0);
-        assert(txn->fee >= 0.0);
+    simtime_t termination_time = conf.termination_time;
+    conf.termination_time = 100;
+    initNetwork();
+    initTransactions(0);
+
+    const struct TransactionSchedule *schedule = &schedules[0];
+    assert(schedule->count > 0);
+    for (size_t i = 0; i < schedule->count; i++) {
+        struct Transaction txn;
+        getTransaction(i, &txn);
+        assert(txn.id == i);
+        assert(txn.timestamp >= 0.0 && txn.timestamp <= conf.termination_time);
+        assert(!i || txn.timestamp >= schedule->timestamps[i - 1]);
+        assert(txn.size >= TXN_MIN_SIZE && txn.size <= TXN_MAX_SIZE);
+        assert(txn.fee >= 0.0);
+    }
+
+    // Each region receives every transaction once, in order of arrival
+    for (int region = 0; region < REGIONS_NUM; region++) {
+        simtime_t last = 0;
+        size_t id_sum = 0;
+        for (size_t i = 0; i < schedule->count; i++) {
+            struct Transaction txn;
+            getTransaction(schedule->arrivals[region][i], &txn);
+            simtime_t arrival = txn.timestamp + LATENCIES[getRegion(txn.sender)][region];
+            assert(arrival >= last);
+            last = arrival;
+            id_sum += txn.id;
+        }
+        assert(id_sum == schedule->count * (schedule->count - 1) / 2);
     }
-    free(rng);
 
+    deinitTransactions();
+    conf.termination_time = termination_time;
+    printf("SUCCESS\n");
+}
+
+void testPoissonArrivals() {
+    printf("Testing Poisson arrivals... ");
+    fflush(stdout);
+
+    // The arrival process runs until the end of the simulation, however many transactions it creates
+    simtime_t termination_time = conf.termination_time;
+    conf.termination_time = 100;
+    txnArrivalConfig.type = TXN_ARRIVAL_POISSON;
+    txnArrivalConfig.rate = 200;
+    initNetwork();
+    initTransactions(0);
+
+    const struct TransactionSchedule *schedule = &schedules[0];
+    assert(schedule->count > 19000 && schedule->count < 21000);
+    for (size_t i = 1; i < schedule->count; i++) {
+        assert(schedule->timestamps[i] >= schedule->timestamps[i - 1]);
+    }
+    assert(schedule->timestamps[schedule->count - 1] <= conf.termination_time);
+    assert(schedule->timestamps[schedule->count - 1] > conf.termination_time - 1);
+
+    deinitTransactions();
+    txnArrivalConfig.type = TXN_ARRIVAL_RAMP;
+    conf.termination_time = termination_time;
     printf("SUCCESS\n");
 }
 
 void testMarkTransactionExecuted() {
     printf("Testing testMarkTransactionExecuted... ");
     fflush(stdout);
-    size_t max = 50;
-    block_bitmap *bitmap = malloc(bitmap_required_size(max));
-    bitmap_initialize(bitmap, max);
-    for (size_t i = 0; i < max; i++) {
-        markTransactionExecuted(bitmap, i);
 
-        size_t j = 0;
+    struct TransactionState state;
+    initTransactionState(&state);
+    int max = 50;
+    for (int i = 0; i < max; i++) {
+        markTransactionExecuted(&state, i);
+
+        int j = 0;
         while (j <= i) {
-            assert(bitmap_check(bitmap, j));
+            assert(isExecuted(&state, j));
             j++;
         }
-        while (j < max) {
-            assert(!bitmap_check(bitmap, j));
+        while (j < state.window_bits) {
+            assert(!isExecuted(&state, j));
             j++;
         }
     }
 
-    free(bitmap);
+    // A transaction past the window grows it forward, keeping the tracked ones
+    int far = 3 * TXN_WINDOW_MIN_BITS + 5;
+    markTransactionExecuted(&state, far);
+    assert(state.base == 0);
+    assert(state.window_bits == 4 * TXN_WINDOW_MIN_BITS);
+    for (int j = 0; j < state.window_bits; j++) {
+        assert(isExecuted(&state, j) == (j < max || j == far));
+    }
+
+    deinitTransactionState(&state);
     printf("SUCCESS\n");
 }
 
@@ -79,35 +206,109 @@ void testMarkTransactionAvailable() {
     printf("Testing testMarkTransactionAvailable... ");
     fflush(stdout);
 
-    size_t max = 50;
-    block_bitmap *bitmap = malloc(bitmap_required_size(max));
-    memset(bitmap, 0xFF, sizeof(block_bitmap) * bitmap_required_size(max));
-    for (size_t i = max - 1; i < max; i--) {
-        markTransactionAvailable(bitmap, i);
+    struct TransactionState state;
+    initTransactionState(&state);
+    int max = 50;
+    for (int i = 0; i < max; i++) {
+        markTransactionExecuted(&state, i);
+    }
+    for (int i = max - 1; i >= 0; i--) {
+        markTransactionAvailable(&state, i);
 
-        size_t j = 0;
+        int j = 0;
         while (j < i) {
-            assert(bitmap_check(bitmap, j));
+            assert(isExecuted(&state, j));
             j++;
         }
         while (j < max) {
-            assert(!bitmap_check(bitmap, j));
+            assert(!isExecuted(&state, j));
             j++;
         }
     }
 
-    free(bitmap);
+    deinitTransactionState(&state);
     printf("SUCCESS\n");
 }
 
-void testGetTransactionDeliveryTime() {
-    printf("Testing testGetTransactionDeliveryTime... ");
+void testFitTransactionWindow() {
+    printf("Testing fitTransactionWindow... ");
     fflush(stdout);
 
-    initNetwork();
+    // The transactions before the window base are all used
+    struct TransactionState state;
+    initTransactionState(&state);
+    state.base = state.low = 2 * TXN_WINDOW_MIN_BITS;
+    markTransactionExecuted(&state, state.base + 3);
+
+    // Used transactions before the base are already tracked as such
+    markTransactionExecuted(&state, 10);
+    assert(state.base == 2 * TXN_WINDOW_MIN_BITS);
+    assert(state.window_bits == TXN_WINDOW_MIN_BITS);
 
-    assert(transactions[0].timestamp <= getTransactionDeliveryTime(0, 0));
+    // A reverted transaction before the base grows the window backwards, to the start of its bitmap block
+    int old_base = state.base;
+    int reverted = old_base - 2 * (int) B_BITS_PER_BLOCK + 7;
+    markTransactionAvailable(&state, reverted);
+    assert(state.base == reverted - 7);
+    // The newly tracked prefix is used, but for the reverted transaction
+    for (int i = state.base; i < old_base; i++) {
+        assert(isExecuted(&state, i) == (i != reverted));
+    }
+    // The previously tracked transactions are kept
+    for (int i = old_base; i < old_base + TXN_WINDOW_MIN_BITS; i++) {
+        assert(isExecuted(&state, i) == (i == old_base + 3));
+    }
+    assert(state.base + state.window_bits == old_base + TXN_WINDOW_MIN_BITS);
 
+    deinitTransactionState(&state);
+    printf("SUCCESS\n");
+}
+
+void testCompactTransactionWindow() {
+    printf("Testing compactTransactionWindow... ");
+    fflush(stdout);
+
+    initTestTransactions(4 * TXN_WINDOW_MIN_BITS, NULL, 0);
+    struct TransactionState state;
+    initTransactionState(&state);
+
+    // Less than half of the window behind low: no compaction
+    int half = TXN_WINDOW_MIN_BITS / 2;
+    for (int i = 0; i < half - 1; i++) {
+        markTransactionExecuted(&state, i);
+    }
+    deliverNewTransactions(&state, -1.0, 0);
+    assert(state.low == half - 1);
+    assert(state.base == 0);
+
+    // Half of the window behind low: the window slides to the block of low, keeping the used transactions past low
+    for (int i = half - 1; i < half + 40; i++) {
+        markTransactionExecuted(&state, i);
+    }
+    int kept = half + 45;
+    markTransactionExecuted(&state, kept);
+    deliverNewTransactions(&state, -1.0, 0);
+    assert(state.low == half + 40);
+    assert(state.base == state.low - (int) B_MOD_OF_BPB(state.low));
+    assert(state.window_bits == TXN_WINDOW_MIN_BITS);
+    for (int i = 0; i < state.base + state.window_bits; i++) {
+        assert(isExecuted(&state, i) == (i < state.low || i == kept));
+    }
+
+    // The whole window behind low: it is cleared rather than moved
+    int end = state.base + state.window_bits;
+    for (int i = state.low; i < end; i++) {
+        markTransactionExecuted(&state, i);
+    }
+    deliverNewTransactions(&state, -1.0, 0);
+    assert(state.low == end);
+    assert(state.base == end);
+    for (int i = 0; i < state.window_bits; i++) {
+        assert(!bitmap_check(state.window, i));
+    }
+
+    deinitTransactionState(&state);
+    deinitTransactions();
     printf("SUCCESS\n");
 }
 
@@ -116,96 +317,57 @@ void testDeliverNewTransactions() {
     fflush(stdout);
 
     int testct = 10;
-    // Populate array of transactions in specific way
-    assert(TXN_NUMBER > testct);
-    for (size_t i = 0; i < TXN_NUMBER; i++) {
-        transactions[i].timestamp = (double) i;
-    }
+    initTestTransactions(testct, NULL, 0);
+    simtime_t latency = LATENCIES[0][0];
 
-    // Initialize transactionState
     struct TransactionState state;
     initTransactionState(&state);
-    assert(state.low == 0);
-    assert(state.high == 0);
 
     // Edge case: no transactions received
-    deliverNewTransactions(&state, -.1);
+    deliverNewTransactions(&state, -.1, 0);
     assert(state.low == 0);
-    assert(state.high == 0);
-    for (int i = 0; i < testct; i++) {
-        assert(!bitmap_check(state.transactions_bitmap, i));
-    }
-
-    // Deliver transactions passing a value of now such that I know which transactions will be delivered
-    int latest = 3;
+    assert(state.arrived == 0);
+    assert(state.mempool_size == 0);
 
     // Deliver transactions up to txn 3
-    deliverNewTransactions(&state, .1 + latest);
-
-    assert(state.low == 0);
-    assert(state.high == latest + 1);
-    for (int i = 0; i < latest; i++) {
-        assert(!bitmap_check(state.transactions_bitmap, i));
+    int latest = 3;
+    deliverNewTransactions(&state, latency + latest, 0);
+    assert(state.arrived == (size_t) latest + 1);
+    assert(state.mempool_size == (size_t) latest + 1);
+    for (int i = 0; i <= latest; i++) {
+        assert(inMempool(&state, i));
     }
 
     // No change in TransactionState
-    deliverNewTransactions(&state, .1 + latest);
-    assert(state.low == 0);
-    assert(state.high == latest + 1);
-    for (int i = 0; i < latest; i++) {
-        assert(!bitmap_check(state.transactions_bitmap, i));
-    }
+    deliverNewTransactions(&state, latency + latest, 0);
+    assert(state.arrived == (size_t) latest + 1);
+    assert(state.mempool_size == (size_t) latest + 1);
 
-    // Deliver up to txn 4
-    deliverNewTransactions(&state, .1 + ++latest);
+    // Mark txn 2 as executed. deliverNewTransactions should NOT update low
+    markTransactionExecuted(&state, 2);
+    deliverNewTransactions(&state, latency + latest, 0);
     assert(state.low == 0);
-    assert(state.high == latest + 1);
-    for (int i = 0; i < latest; i++) {
-        assert(!bitmap_check(state.transactions_bitmap, i));
-    }
 
-    // Mark txn 2 as executed. deliverNewTransactions should NOT update low and high
-    markTransactionExecuted(state.transactions_bitmap, 2);
-    deliverNewTransactions(&state, .1 + latest);
-    assert(state.low == 0);
-    assert(state.high == latest + 1);
-    for (int i = 0; i < 2; i++) {
-        assert(!bitmap_check(state.transactions_bitmap, i));
-    }
-    assert(bitmap_check(state.transactions_bitmap, 2));
-    for (int i = 3; i < latest; i++) {
-        assert(!bitmap_check(state.transactions_bitmap, i));
-    }
-
-    // Mark txn 0 as executed. deliverNewTransactions should update low to move over txn 0
-    markTransactionExecuted(state.transactions_bitmap, 0);
-    deliverNewTransactions(&state, .1 + latest);
-    assert(state.low == 1);
-    assert(state.high == latest + 1);
-    assert(bitmap_check(state.transactions_bitmap, 0));
-    assert(!bitmap_check(state.transactions_bitmap, 1));
-    assert(bitmap_check(state.transactions_bitmap, 2));
-    for (int i = 3; i < latest; i++) {
-        assert(!bitmap_check(state.transactions_bitmap, i));
-    }
-
-    // Mark txn 1 as executed. deliverNewTransactions should update low to txn 3, as all before it are executed
-    markTransactionExecuted(state.transactions_bitmap, 1);
-    deliverNewTransactions(&state, .1 + latest);
+    // Mark txn 0 and 1 as executed. deliverNewTransactions should update low to txn 3, as all before it are executed
+    markTransactionExecuted(&state, 0);
+    markTransactionExecuted(&state, 1);
+    deliverNewTransactions(&state, latency + latest, 0);
     assert(state.low == 3);
-    assert(state.high == latest + 1);
-    for (int i = 0; i < 3; i++) {
-        assert(bitmap_check(state.transactions_bitmap, i));
-    }
-    for (int i = 3; i < latest; i++) {
-        assert(!bitmap_check(state.transactions_bitmap, i));
-    }
+
+    // Other regions receive the transactions later
+    struct TransactionState other;
+    initTransactionState(&other);
+    deliverNewTransactions(&other, latency + latest, REGIONS_NUM - 1);
+    assert(other.arrived == (size_t) latest);
+    deinitTransactionState(&other);
 
     // Edge case: last transaction
-    deliverNewTransactions(&state, .1 + TXN_NUMBER);
-    assert(state.high == TXN_NUMBER);
+    deliverNewTransactions(&state, latency + testct, 0);
+    assert(state.arrived == (size_t) testct);
+    assert(state.mempool_size == (size_t) testct);
 
     deinitTransactionState(&state);
+    deinitTransactions();
     printf("SUCCESS\n");
 }
 
@@ -216,80 +378,61 @@ void testGenerateTransactionData() {
     assert(!generateTransactionData(NULL, 0, 0));
     assert(!generateTransactionData(NULL, 3, 0));
 
-    // Generate transactions
     int testct = 10;
-    // Populate array of transactions in specific way
-    assert(TXN_NUMBER > testct);
-    for (size_t i = 0; i < TXN_NUMBER; i++) {
-        transactions[i].timestamp = (double) i;
-        transactions[i].sender = 0;
-    }
+    initTestTransactions(testct, NULL, 0);
+    simtime_t latency = LATENCIES[0][0];
 
-    // Initialize transactionState
     struct TransactionState state;
     initTransactionState(&state);
-    assert(state.low == 0);
-    assert(state.high == 0);
-    assert(!generateTransactionData(NULL, -1.0, 0));
+    assert(!generateTransactionData(&state, -1.0, 0));
 
-    // Generate TransactionsData
-    struct TransactionData *txData = generateTransactionData(&state, 3.0, 0);
+    struct TransactionData *txData = generateTransactionData(&state, 3.0 + latency, 0);
     assert(txData);
     assert(txData->low == 0);
     assert(txData->high == 4);
+    assert(txData->count == 4);
+    assert(txData->size == 4 * TXN_MIN_SIZE);
     for (int i = 0; i <= 3; i++) {
         assert(bitmap_check(txData->included_transactions, i));
-        assert(!bitmap_check(state.transactions_bitmap, i));
+        // Transactions are only used once the block is applied
+        assert(!isExecuted(&state, i));
     }
-    assert(!bitmap_check(txData->included_transactions, 4));
     free(txData);
 
-
-    // Reset transaction state
+    // A node in another region has not received transaction 3 yet
     deinitTransactionState(&state);
     initTransactionState(&state);
-    // Node 1 has not generated transaction with ID 3, as such it will have some delay. It should not use it.
-    txData = generateTransactionData(&state, 3.0, 1);
+    assert(getRegion(N_NODES - 1) != 0);
+    txData = generateTransactionData(&state, 3.0 + latency, N_NODES - 1);
     assert(txData);
     assert(txData->low == 0);
     assert(txData->high == 3);
     free(txData);
-
-    // Set transactions so that they are seen out of order
-    transactions[2].timestamp = 2.0;
-    transactions[2].sender = 1;
-    transactions[3].timestamp = 2.001;
-    transactions[3].sender = 0;
-    // Reset transaction state
     deinitTransactionState(&state);
+    deinitTransactions();
+
+    // Transactions with the highest fees are selected first, up to the block size
+    struct Transaction large[] = {
+            {.id = 0, .timestamp = 0, .size = BLOCK_MAX_BYTES / 2, .fee = 1},
+            {.id = 1, .timestamp = 0, .size = BLOCK_MAX_BYTES / 2, .fee = 3},
+            {.id = 2, .timestamp = 0, .size = BLOCK_MAX_BYTES / 2, .fee = 2},
+    };
+    initTestTransactions(3, large, 3);
     initTransactionState(&state);
-    // Node 0 has not generated transaction with ID 2, as such it will have some delay. It should use txn 3 but not txn 2
-    txData = generateTransactionData(&state, 2.002, 0);
+    txData = generateTransactionData(&state, 1.0, 0);
     assert(txData);
-    assert(txData->low == 0);
-    assert(txData->high == 4);
+    assert(txData->low == 1);
+    assert(txData->high == 3);
+    assert(txData->count == 2);
     assert(bitmap_check(txData->included_transactions, 0));
     assert(bitmap_check(txData->included_transactions, 1));
-    assert(!bitmap_check(txData->included_transactions, 2));
-    assert(bitmap_check(txData->included_transactions, 3));
-    for (int i = 0; i <= 3; i++) {
-        assert(!bitmap_check(state.transactions_bitmap, i));
-    }
-    free(txData);
-
-    // Final test: transaction is last of all transactions
-    txData = generateTransactionData(&state, TXN_NUMBER + 10, 0);
-    assert(bitmap_check(txData->included_transactions, TXN_NUMBER - 1));
-    assert(!bitmap_check(txData->included_transactions, TXN_NUMBER)); // Technically out of bounds, but the bitmap will likely have some trailing unused bits
-    assert(!txData->low);
-    assert(txData->high == TXN_NUMBER);
-    for (int i = 0; i < TXN_NUMBER; i++) {
-        assert(!bitmap_check(state.transactions_bitmap, i));
-        assert(bitmap_check(txData->included_transactions, i));
-    }
+    // The transaction left out is still in the mempool
+    assert(state.mempool_size == 1);
+    assert(inMempool(&state, 0));
     free(txData);
 
     deinitTransactionState(&state);
+    deinitTransactions();
     printf("SUCCESS\n");
 }
 
@@ -300,127 +443,70 @@ void testApplyBlockTransactions() {
     struct TransactionState state;
     struct TransactionData *data;
     const int tcount = 10;
-    assert(TXN_NUMBER > tcount);
 
     // TEST 1: contiguous
-    // Initialize a TransactionState
     initTransactionState(&state);
-    assert(state.low == 0);
-    assert(state.high == 0);
-
-    // Generate an artificially populated TransactionData
     data = allocTransactionData(tcount);
     data->low = 0;
     data->high = tcount;
     for (int i = 0; i < tcount; i++) {
         bitmap_set(data->included_transactions, i);
     }
-
-    // Apply the TransactionData to the state
     applyBlockTransactions(&state, data);
-
-    // Verify the application was successful
-    for (size_t i = 0; i < tcount; i++) {
-        assert(bitmap_check(state.transactions_bitmap, i));
-    }
-
-    for (size_t i = tcount; i < TXN_NUMBER; i++) {
-        assert(!bitmap_check(state.transactions_bitmap, i));
+    for (int i = 0; i < state.window_bits; i++) {
+        assert(isExecuted(&state, i) == (i < tcount));
     }
-
     deinitTransactionState(&state);
     free(data);
 
-
-    // TEST 2: non-contiguous transactions
+    // TEST 2: non-contiguous transactions, past the window
     initTransactionState(&state);
-    assert(state.low == 0);
-    assert(state.high == 0);
-
+    int offset = 2 * TXN_WINDOW_MIN_BITS;
     data = allocTransactionData(tcount);
-    data->low = 0;
-    data->high = tcount;
+    data->low = offset;
+    data->high = offset + tcount;
     for (int i = 0; i < tcount; i += 2) {
         bitmap_set(data->included_transactions, i);
     }
-
     applyBlockTransactions(&state, data);
-
-    for (size_t i = 0; i < tcount; i += 2) {
-        assert(bitmap_check(state.transactions_bitmap, i));
-    }
-
-    for (size_t i = 1; i < tcount; i += 2) {
-        assert(!bitmap_check(state.transactions_bitmap, i));
-    }
-
-    for (size_t i = tcount; i < TXN_NUMBER; i++) {
-        assert(!bitmap_check(state.transactions_bitmap, i));
+    assert(state.base + state.window_bits >= offset + tcount);
+    for (int i = 0; i < state.base + state.window_bits; i++) {
+        assert(isExecuted(&state, i) == (i >= offset && i < offset + tcount && !((i - offset) % 2)));
     }
-
     deinitTransactionState(&state);
     free(data);
 
-
     // TEST 3: no transactions selected
     initTransactionState(&state);
-    assert(state.low == 0);
-    assert(state.high == 0);
-
     data = allocTransactionData(tcount);
     data->low = 0;
     data->high = tcount;
-
     applyBlockTransactions(&state, data);
-
-    for (size_t i = 0; i < TXN_NUMBER; i++) {
-        assert(!bitmap_check(state.transactions_bitmap, i));
+    for (int i = 0; i < state.window_bits; i++) {
+        assert(!isExecuted(&state, i));
     }
-
     deinitTransactionState(&state);
     free(data);
 
-    // TEST 4: Apply one, then another, then revert first
+    // TEST 4: Apply one, then another
     initTransactionState(&state);
-    assert(state.low == 0);
-    assert(state.high == 0);
-
     data = allocTransactionData(tcount);
     data->low = 0;
     data->high = tcount;
     for (int i = 0; i < tcount; i += 2) {
         bitmap_set(data->included_transactions, i);
     }
-
     applyBlockTransactions(&state, data);
 
-    for (size_t i = 0; i < tcount; i += 2) {
-        assert(bitmap_check(state.transactions_bitmap, i));
-    }
-
-    for (size_t i = 1; i < tcount; i += 2) {
-        assert(!bitmap_check(state.transactions_bitmap, i));
-    }
-
-    for (size_t i = tcount; i < TXN_NUMBER; i++) {
-        assert(!bitmap_check(state.transactions_bitmap, i));
-    }
-
     struct TransactionData *data2 = allocTransactionData(tcount);
     data2->low = 0;
     data2->high = tcount;
     for (int i = 1; i < tcount; i += 2) {
         bitmap_set(data2->included_transactions, i);
     }
-
     applyBlockTransactions(&state, data2);
-
-    for (size_t i = 0; i < tcount; i++) {
-        assert(bitmap_check(state.transactions_bitmap, i));
-    }
-
-    for (size_t i = tcount; i < TXN_NUMBER; i++) {
-        assert(!bitmap_check(state.transactions_bitmap, i));
+    for (int i = 0; i < state.window_bits; i++) {
+        assert(isExecuted(&state, i) == (i < tcount));
     }
 
     deinitTransactionState(&state);
@@ -437,169 +523,119 @@ void testRevertAppliedBlockTransactions() {
     struct TransactionState state;
     struct TransactionData *data;
     const int tcount = 10;
-    assert(TXN_NUMBER > tcount);
+    initTestTransactions(2 * tcount, NULL, 0);
 
-    // TEST 1: contiguous
-    // Initialize a TransactionState
+    // TEST 1: contiguous. The reverted transactions go back to the mempool, and low goes back to the first of them
     initTransactionState(&state);
-    assert(state.low == 0);
-    assert(state.high == 0);
-
-    // Generate an artificially populated TransactionData
     data = allocTransactionData(tcount);
     data->low = 0;
     data->high = tcount;
     for (int i = 0; i < tcount; i++) {
         bitmap_set(data->included_transactions, i);
     }
-
-    // Apply the TransactionData to the state
     applyBlockTransactions(&state, data);
+    deliverNewTransactions(&state, -1.0, 0);
+    assert(state.low == tcount);
+    assert(state.mempool_size == 0);
 
-    // Verify the application was successful
-    for (size_t i = 0; i < tcount; i++) {
-        assert(bitmap_check(state.transactions_bitmap, i));
-    }
-
-    for (size_t i = tcount; i < TXN_NUMBER; i++) {
-        assert(!bitmap_check(state.transactions_bitmap, i));
-    }
-
-    // Revert the application
     revertAppliedBlockTransactions(&state, data);
-
-    // Verify the effects are reverted
-    for (size_t i = 0; i < TXN_NUMBER; i++) {
-        assert(!bitmap_check(state.transactions_bitmap, i));
+    assert(state.low == 0);
+    assert(state.mempool_size == (size_t) tcount);
+    for (int i = 0; i < 2 * tcount; i++) {
+        assert(!isExecuted(&state, i));
+        assert(inMempool(&state, i) == (i < tcount));
     }
-
     deinitTransactionState(&state);
-    free(data);
 
-
-    // TEST 2: non-contiguous transactions
+    // TEST 2: the reverted transactions are past low, which is kept
     initTransactionState(&state);
-    assert(state.low == 0);
-    assert(state.high == 0);
-
-    data = allocTransactionData(tcount);
-    data->low = 0;
-    data->high = tcount;
-    for (int i = 0; i < tcount; i += 2) {
-        bitmap_set(data->included_transactions, i);
-    }
-
+    data->low = tcount;
+    data->high = 2 * tcount;
     applyBlockTransactions(&state, data);
-
-    for (size_t i = 0; i < tcount; i += 2) {
-        assert(bitmap_check(state.transactions_bitmap, i));
-    }
-
-    for (size_t i = 1; i < tcount; i += 2) {
-        assert(!bitmap_check(state.transactions_bitmap, i));
-    }
-
-    for (size_t i = tcount; i < TXN_NUMBER; i++) {
-        assert(!bitmap_check(state.transactions_bitmap, i));
-    }
-
     revertAppliedBlockTransactions(&state, data);
-
-    for (size_t i = 0; i < TXN_NUMBER; i++) {
-        assert(!bitmap_check(state.transactions_bitmap, i));
+    assert(state.low == 0);
+    for (int i = 0; i < 2 * tcount; i++) {
+        assert(!isExecuted(&state, i));
+        assert(inMempool(&state, i) == (i >= tcount));
     }
-
     deinitTransactionState(&state);
     free(data);
 
-
     // TEST 3: no transactions selected
     initTransactionState(&state);
-    assert(state.low == 0);
-    assert(state.high == 0);
-
     data = allocTransactionData(tcount);
     data->low = 0;
     data->high = tcount;
-
     applyBlockTransactions(&state, data);
-
-    for (size_t i = 0; i < TXN_NUMBER; i++) {
-        assert(!bitmap_check(state.transactions_bitmap, i));
-    }
-
     revertAppliedBlockTransactions(&state, data);
-
-    // Verify the effects are reverted
-    for (size_t i = 0; i < TXN_NUMBER; i++) {
-        assert(!bitmap_check(state.transactions_bitmap, i));
+    for (int i = 0; i < state.window_bits; i++) {
+        assert(!isExecuted(&state, i));
     }
-
+    assert(state.mempool_size == 0);
     deinitTransactionState(&state);
     free(data);
 
-    // TEST 4: Apply one, then another, then revert first
+    // TEST 4: Apply one, then another, then revert the first
     initTransactionState(&state);
-    assert(state.low == 0);
-    assert(state.high == 0);
-
     data = allocTransactionData(tcount);
     data->low = 0;
     data->high = tcount;
     for (int i = 0; i < tcount; i += 2) {
         bitmap_set(data->included_transactions, i);
     }
-
     applyBlockTransactions(&state, data);
 
-    for (size_t i = 0; i < tcount; i += 2) {
-        assert(bitmap_check(state.transactions_bitmap, i));
-    }
-
-    for (size_t i = 1; i < tcount; i += 2) {
-        assert(!bitmap_check(state.transactions_bitmap, i));
-    }
-
-    for (size_t i = tcount; i < TXN_NUMBER; i++) {
-        assert(!bitmap_check(state.transactions_bitmap, i));
-    }
-
     struct TransactionData *data2 = allocTransactionData(tcount);
     data2->low = 0;
     data2->high = tcount;
     for (int i = 1; i < tcount; i += 2) {
         bitmap_set(data2->included_transactions, i);
     }
-
     applyBlockTransactions(&state, data2);
-
-    for (size_t i = 0; i < tcount; i++) {
-        assert(bitmap_check(state.transactions_bitmap, i));
-    }
-
-    for (size_t i = tcount; i < TXN_NUMBER; i++) {
-        assert(!bitmap_check(state.transactions_bitmap, i));
-    }
+    deliverNewTransactions(&state, -1.0, 0);
+    assert(state.low == tcount);
 
     revertAppliedBlockTransactions(&state, data);
-
-    // Verify the effects are reverted
-    for (size_t i = 0; i < tcount; i += 2) {
-        assert(!bitmap_check(state.transactions_bitmap, i));
-    }
-
-    for (size_t i = 1; i < tcount; i += 2) {
-        assert(bitmap_check(state.transactions_bitmap, i));
+    assert(state.low == 0);
+    for (int i = 0; i < state.window_bits; i++) {
+        assert(isExecuted(&state, i) == (i < tcount && i % 2));
+        assert(inMempool(&state, i) == (i < tcount && !(i % 2)));
     }
 
-    for (size_t i = tcount; i < TXN_NUMBER; i++) {
-        assert(!bitmap_check(state.transactions_bitmap, i));
-    }
+    // The next block picks the reverted transactions up again
+    struct TransactionData *txData = generateTransactionData(&state, -1.0, 0);
+    assert(txData);
+    assert(txData->low == 0);
+    assert(txData->count == (unsigned) tcount / 2);
+    free(txData);
 
     deinitTransactionState(&state);
     free(data);
     free(data2);
+    deinitTransactions();
+
+    printf("SUCCESS\n");
+}
+
+void testCountUnknownTransactions() {
+    printf("Testing countUnknownTransactions... ");
+    fflush(stdout);
 
+    int testct = 10;
+    initTestTransactions(testct, NULL, 0);
+    simtime_t latency = LATENCIES[0][0];
+
+    struct TransactionState state;
+    initTransactionState(&state);
+    txn_id_t ids[] = {1, 4, 6, 8};
+    assert(countUnknownTransactions(&state, ids, 4, -1.0, 0) == 4);
+    assert(countUnknownTransactions(&state, ids, 4, 5 + latency, 0) == 2);
+    // Used transactions are known even if they did not reach the region yet
+    markTransactionExecuted(&state, 8);
+    assert(countUnknownTransactions(&state, ids, 4, 5 + latency, 0) == 1);
+
+    deinitTransactionState(&state);
+    deinitTransactions();
     printf("SUCCESS\n");
 }
 
@@ -725,13 +761,16 @@ void transaction_main() {
     printf("TESTING TRANSACTION\n");
     testInitTransactionState();
     testGenerateTransactions();
+    testPoissonArrivals();
     testMarkTransactionExecuted();
     testMarkTransactionAvailable();
-    testGetTransactionDeliveryTime();
+    testFitTransactionWindow();
+    testCompactTransactionWindow();
     testDeliverNewTransactions();
     testGenerateTransactionData();
     testApplyBlockTransactions();
     testRevertAppliedBlockTransactions();
+    testCountUnknownTransactions();
     testAllocTransactionData();
     testSizeofTransactionData();
     printf("FINISHED TESTING TRANSACTION, SUCCESS!\n");
@@ -0,0 +1,191 @@
+/**
+ * @file bench/bench.c
+ *
+ * @brief Micro-benchmarks harness
+ *
+ * SPDX-FileCopyrightText: 2008-2023 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#include "bench.h"
+
+#include <arch/thread.h>
+#include <core/sync.h>
+#include <log/log.h>
+#include <mm/model_allocator.h>
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/// The arguments of a thread started by bench_threads_run()
+struct bench_thread {
+	/// The identifier of the thread
+	thr_id_t thr;
+	/// The resource identifier assigned to the thread
+	rid_t rid;
+	/// The function run by the thread
+	void (*fnc)(void *);
+	/// The argument passed to @a fnc
+	void *arg;
+};
+
+unsigned bench_threads_max;
+/// The count of measured repetitions of each benchmark case
+static unsigned bench_reps;
+/// The file where the results are written
+static FILE *bench_out;
+/// Set if no result has been written yet
+static bool bench_first;
+/// The mocked LP of the current thread, used by the benchmarks which need a model memory allocator
+static __thread struct lp_ctx bench_lp;
+
+/**
+ * @brief Initialize the harness and write the header of the results
+ * @param out the file where the results are written
+ * @param reps the count of measured repetitions of each benchmark case
+ * @param threads_max the maximum count of threads used by the multi-threaded benchmarks
+ */
+void bench_init(FILE *out, unsigned reps, unsigned threads_max)
+{
+	bench_out = out;
+	bench_reps = reps;
+	bench_threads_max = threads_max;
+	bench_first = true;
+	fprintf(bench_out, "{\n\t\"repetitions\": %u,\n\t\"threads_max\": %u,\n\t\"results\": [", reps, threads_max);
+}
+
+/**
+ * @brief Write the footer of the results
+ */
+void bench_fini(void)
+{
+	fprintf(bench_out, "\n\t]\n}\n");
+	fflush(bench_out);
+}
+
+/**
+ * @brief Read a monotonic clock
+ * @return the current value of the clock in nanoseconds
+ */
+uint64_t bench_clock_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000U + (uint64_t)ts.tv_nsec;
+}
+
+static int bench_sample_cmp(const void *a, const void *b)
+{
+	double x = *(const double *)a;
+	double y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+/**
+ * @brief Run a benchmark case and write its results
+ * @param name the name of the benchmark
+ * @param variant the name of the variant of the benchmark
+ * @param param the name of the parameter of the case
+ * @param value the value of the parameter of the case
+ * @param rep the function running a repetition of the case
+ * @param arg the argument passed to @a rep
+ */
+void bench_run(const char *name, const char *variant, const char *param, uint64_t value, bench_rep_fnc rep,
+    void *arg)
+{
+	uint64_t ns;
+	uint64_t ops = rep(arg, &ns);
+
+	double samples[bench_reps];
+	for(unsigned i = 0; i < bench_reps; ++i) {
+		ops = rep(arg, &ns);
+		samples[i] = (double)ns / (double)ops;
+	}
+	qsort(samples, bench_reps, sizeof(*samples), bench_sample_cmp);
+
+	unsigned m = bench_reps / 2;
+	double median = bench_reps & 1U ? samples[m] : (samples[m - 1] + samples[m]) / 2;
+
+	fprintf(bench_out,
+	    "%s\n\t\t{\"benchmark\": \"%s\", \"variant\": \"%s\", \"param\": \"%s\", \"value\": %" PRIu64
+	    ", \"ops\": %" PRIu64 ", \"ns_per_op\": {\"min\": %.3f, \"median\": %.3f, \"max\": %.3f}, "
+	    "\"ops_per_sec\": %.0f}",
+	    bench_first ? "" : ",", name, variant, param, value, ops, samples[0], median, samples[bench_reps - 1],
+	    1e9 / median);
+	fflush(bench_out);
+	bench_first = false;
+
+	logger(LOG_INFO, "%s %s %s=%" PRIu64 ": %.3f ns/op", name, variant, param, value, median);
+}
+
+/**
+ * @brief Compute the next count of threads to benchmark
+ * @param n_threads the last count of threads benchmarked
+ * @return the double of @a n_threads, capped to bench_threads_max, or a value greater than bench_threads_max once it
+ *         has been benchmarked
+ */
+unsigned bench_threads_next(unsigned n_threads)
+{
+	if(n_threads < bench_threads_max && n_threads * 2 > bench_threads_max)
+		return bench_threads_max;
+	return n_threads * 2;
+}
+
+static thrd_ret_t THREAD_CALL_CONV bench_thread_run(void *arg)
+{
+	struct bench_thread *t = arg;
+	rid = t->rid;
+	t->fnc(t->arg);
+	return THREAD_RET_SUCCESS;
+}
+
+/**
+ * @brief Run a function on multiple threads and wait for their completion
+ * @param n_threads the count of threads to start
+ * @param fnc the function run by each thread
+ * @param arg the argument passed to @a fnc
+ *
+ * Each thread has its own resource identifier, from 0 to @a n_threads - 1, and can synchronize with the others through
+ * sync_thread_barrier().
+ */
+void bench_threads_run(unsigned n_threads, void (*fnc)(void *), void *arg)
+{
+	global_config.n_threads = n_threads;
+	sync_thread_barrier_reset();
+
+	struct bench_thread thrs[n_threads];
+	for(rid_t i = 0; i < n_threads; ++i) {
+		thrs[i].rid = i;
+		thrs[i].fnc = fnc;
+		thrs[i].arg = arg;
+		if(thread_start(&thrs[i].thr, bench_thread_run, &thrs[i])) {
+			logger(LOG_FATAL, "Unable to create threads!");
+			abort();
+		}
+	}
+
+	for(rid_t i = 0; i < n_threads; ++i)
+		thread_wait(thrs[i].thr, NULL);
+}
+
+/**
+ * @brief Initialize the mocked LP of the current thread, with an empty model memory
+ * @return a pointer to the mocked LP, which is also set as the current LP
+ */
+struct lp_ctx *bench_lp_init(void)
+{
+	memset(&bench_lp, 0, sizeof(bench_lp));
+	current_lp = &bench_lp;
+	model_allocator_lp_init(&bench_lp.mm_state);
+	return &bench_lp;
+}
+
+/**
+ * @brief Finalize the mocked LP of the current thread
+ */
+void bench_lp_fini(void)
+{
+	model_allocator_lp_fini(&bench_lp.mm_state);
+	current_lp = NULL;
+}
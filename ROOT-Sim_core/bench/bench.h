@@ -0,0 +1,70 @@
+/**
+ * @file bench/bench.h
+ *
+ * @brief Micro-benchmarks harness
+ *
+ * Each benchmark case is run once to warm up and then a configurable number of times. The time per operation of each
+ * repetition is collected and the minimum, median and maximum ones are reported as JSON.
+ *
+ * SPDX-FileCopyrightText: 2008-2023 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#pragma once
+
+#include <lp/lp.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * @brief A single repetition of a benchmark case
+ * @param arg the argument passed to bench_run()
+ * @param ns_p a pointer to the location where the nanoseconds taken by the measured operations are stored
+ * @return the count of operations measured
+ */
+typedef uint64_t (*bench_rep_fnc)(void *arg, uint64_t *ns_p);
+
+/// The maximum count of threads used by the multi-threaded benchmarks
+extern unsigned bench_threads_max;
+
+extern void bench_init(FILE *out, unsigned reps, unsigned threads_max);
+extern void bench_fini(void);
+extern uint64_t bench_clock_ns(void);
+extern void bench_run(const char *name, const char *variant, const char *param, uint64_t value, bench_rep_fnc rep,
+    void *arg);
+extern unsigned bench_threads_next(unsigned n_threads);
+extern void bench_threads_run(unsigned n_threads, void (*fnc)(void *), void *arg);
+extern struct lp_ctx *bench_lp_init(void);
+extern void bench_lp_fini(void);
+
+extern void bench_msg_queue(void);
+extern void bench_queue(void);
+extern void bench_msg_allocator(void);
+extern void bench_mm(void);
+extern void bench_gvt(void);
+
+/**
+ * @brief Draw a pseudo random number
+ * @param state_p a pointer to the non-zero state of the generator
+ * @return a pseudo random 64 bits number
+ */
+static inline uint64_t bench_rand(uint64_t *state_p)
+{
+	uint64_t x = *state_p;
+	x ^= x << 13U;
+	x ^= x >> 7U;
+	x ^= x << 17U;
+	*state_p = x;
+	return x;
+}
+
+/**
+ * @brief Draw a pseudo random number in [0, 1)
+ * @param state_p a pointer to the non-zero state of the generator
+ * @return a pseudo random number uniformly distributed in [0, 1)
+ */
+static inline double bench_rand_unit(uint64_t *state_p)
+{
+	return (double)(bench_rand(state_p) >> 11U) * 0x1.0p-53;
+}
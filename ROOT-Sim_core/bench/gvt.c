@@ -0,0 +1,75 @@
+/**
+ * @file bench/gvt.c
+ *
+ * @brief Micro-benchmark: GVT reduction
+ *
+ * The threads run the GVT algorithm as the processing loop of the parallel runtime does, without processing any
+ * message. The master thread starts a new reduction as soon as the previous one is over, so that the time per
+ * operation is the latency of a reduction.
+ *
+ * SPDX-FileCopyrightText: 2008-2023 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#include "bench.h"
+
+#include <core/sync.h>
+#include <distributed/mpi.h>
+#include <gvt/gvt.h>
+
+#include <stdatomic.h>
+
+/// The count of GVT reductions of a repetition
+#define GVT_REDUCTIONS 1000U
+
+/// The shared state of a repetition
+struct gvt_rep {
+	/// Set by the master thread once it has completed GVT_REDUCTIONS reductions
+	_Atomic bool stop;
+	/// The nanoseconds taken by the reductions
+	uint64_t ns;
+};
+
+static void gvt_thread(void *arg)
+{
+	struct gvt_rep *r = arg;
+	unsigned reductions = 0;
+	uint64_t t = 0;
+
+	sync_thread_barrier();
+	if(!rid)
+		t = bench_clock_ns();
+
+	while(!atomic_load_explicit(&r->stop, memory_order_relaxed)) {
+		mpi_remote_msg_handle();
+		if(!rid)
+			gvt_start_early();
+
+		if(gvt_phase_run() != 0.0 && !rid && ++reductions == GVT_REDUCTIONS) {
+			r->ns = bench_clock_ns() - t;
+			atomic_store_explicit(&r->stop, true, memory_order_relaxed);
+		}
+	}
+
+	gvt_msg_drain();
+}
+
+static uint64_t gvt_rep(void *arg, uint64_t *ns_p)
+{
+	unsigned n_threads = *(unsigned *)arg;
+	struct gvt_rep r = {.stop = false};
+
+	gvt_global_init();
+	bench_threads_run(n_threads, gvt_thread, &r);
+
+	*ns_p = r.ns;
+	return GVT_REDUCTIONS;
+}
+
+/**
+ * @brief Benchmark the latency of the GVT reductions by count of threads
+ */
+void bench_gvt(void)
+{
+	for(unsigned n = 1; n <= bench_threads_max; n = bench_threads_next(n))
+		bench_run("gvt", "reduction", "threads", n, gvt_rep, &n);
+}
@@ -0,0 +1,104 @@
+/**
+ * @file bench/main.c
+ *
+ * @brief Main program of the micro-benchmarks
+ *
+ * Usage: rsbench [-o FILE] [-r REPETITIONS] [-t THREADS] [BENCHMARK...]
+ *
+ * The results are written as JSON to FILE, or to the standard output. The multi-threaded benchmarks use up to THREADS
+ * threads, by default as many as the available cores. If no BENCHMARK is given, all of them are run.
+ *
+ * SPDX-FileCopyrightText: 2008-2023 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#include "bench.h"
+
+#include <arch/thread.h>
+#include <distributed/mpi.h>
+#include <log/log.h>
+#include <mm/model_allocator.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+/// A set of benchmarks which can be selected from the command line
+struct bench_suite {
+	/// The name of the set
+	const char *name;
+	/// The function running the benchmarks of the set
+	void (*fnc)(void);
+};
+
+static const struct bench_suite suites[] = {
+    {"msg_queue", bench_msg_queue},
+    {"queue", bench_queue},
+    {"msg_allocator", bench_msg_allocator},
+    {"mm", bench_mm},
+    {"gvt", bench_gvt}
+};
+
+#define SUITES_COUNT (sizeof(suites) / sizeof(*suites))
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "Usage: %s [-o FILE] [-r REPETITIONS] [-t THREADS] [BENCHMARK...]\nBenchmarks:", prog);
+	for(unsigned i = 0; i < SUITES_COUNT; ++i)
+		fprintf(stderr, " %s", suites[i].name);
+	fprintf(stderr, "\n");
+}
+
+int main(int argc, char **argv)
+{
+	const char *out_path = NULL;
+	unsigned reps = 7;
+	unsigned threads_max = thread_cores_count();
+	bool selected[SUITES_COUNT] = {false};
+	bool any_selected = false;
+
+	for(int i = 1; i < argc; ++i) {
+		if(!strcmp(argv[i], "-o") && i + 1 < argc) {
+			out_path = argv[++i];
+		} else if(!strcmp(argv[i], "-r") && i + 1 < argc) {
+			reps = strtoul(argv[++i], NULL, 10);
+		} else if(!strcmp(argv[i], "-t") && i + 1 < argc) {
+			threads_max = strtoul(argv[++i], NULL, 10);
+		} else {
+			unsigned j = 0;
+			while(j < SUITES_COUNT && strcmp(argv[i], suites[j].name))
+				++j;
+			if(j == SUITES_COUNT) {
+				usage(argv[0]);
+				return EXIT_FAILURE;
+			}
+			selected[j] = true;
+			any_selected = true;
+		}
+	}
+
+	if(reps == 0 || threads_max == 0 || threads_max > MAX_THREADS) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	FILE *out = stdout;
+	if(out_path != NULL && (out = fopen(out_path, "w")) == NULL) {
+		fprintf(stderr, "Unable to open %s for writing\n", out_path);
+		return EXIT_FAILURE;
+	}
+
+	log_init(stderr);
+	global_config.log_level = LOG_INFO;
+	mpi_global_init(NULL, NULL);
+	model_allocator_global_init();
+
+	bench_init(out, reps, threads_max);
+	for(unsigned i = 0; i < SUITES_COUNT; ++i)
+		if(!any_selected || selected[i])
+			suites[i].fnc();
+	bench_fini();
+
+	if(out != stdout)
+		fclose(out);
+
+	return 0;
+}
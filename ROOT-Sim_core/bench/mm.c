@@ -0,0 +1,132 @@
+/**
+ * @file bench/mm.c
+ *
+ * @brief Micro-benchmark: model memory allocator
+ *
+ * The allocations and the releases of the model memory are measured by block size. The checkpoints are measured by
+ * model state size, for each checkpointing mode: between two operations one chunk every MM_CKPT_DIRTY_STRIDE of the
+ * state is written.
+ *
+ * SPDX-FileCopyrightText: 2008-2023 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#include "bench.h"
+
+#include <mm/mm.h>
+#include <mm/model_allocator.h>
+
+/// The total size in bytes of the blocks allocated by a repetition of the allocator benchmark
+#define MM_ALLOC_TOTAL (1U << 24U)
+/// The size in bytes of the chunks the model state of the checkpoint benchmark is made of
+#define MM_CKPT_CHUNK 1024U
+/// The total size in bytes of the model states checkpointed by a repetition of the checkpoint benchmark
+#define MM_CKPT_TOTAL (1U << 26U)
+/// One chunk every MM_CKPT_DIRTY_STRIDE ones is written between two checkpoint operations
+#define MM_CKPT_DIRTY_STRIDE 8U
+
+/// A case of the checkpoint benchmark
+struct mm_ckpt_case {
+	/// The name of the checkpointing mode
+	const char *mode;
+	/// The value of simulation_configuration.ckpt_cow to use
+	bool cow;
+	/// The value of simulation_configuration.ckpt_compress to use
+	bool compress;
+	/// If set, the restores are measured, otherwise the checkpoints
+	bool restore;
+	/// The size in bytes of the model state
+	uint64_t size;
+};
+
+static uint64_t mm_alloc_rep(void *arg, uint64_t *ns_p)
+{
+	uint64_t size = *(uint64_t *)arg;
+	uint64_t count = max(MM_ALLOC_TOTAL / size, 64U);
+	void **blocks = mm_alloc(count * sizeof(*blocks));
+	bench_lp_init();
+
+	uint64_t t = bench_clock_ns();
+	for(uint64_t i = 0; i < count; ++i)
+		blocks[i] = rs_malloc(size);
+	for(uint64_t i = 0; i < count; ++i)
+		rs_free(blocks[i]);
+	*ns_p = bench_clock_ns() - t;
+
+	bench_lp_fini();
+	mm_free(blocks);
+	return 2 * count;
+}
+
+static void mm_ckpt_dirty(uint64_t **chunks, uint64_t n, uint64_t round)
+{
+	for(uint64_t i = round % MM_CKPT_DIRTY_STRIDE; i < n; i += MM_CKPT_DIRTY_STRIDE)
+		chunks[i][round % (MM_CKPT_CHUNK / sizeof(uint64_t))] = round;
+}
+
+static uint64_t mm_ckpt_rep(void *arg, uint64_t *ns_p)
+{
+	const struct mm_ckpt_case *c = arg;
+	global_config.ckpt_cow = c->cow;
+	global_config.ckpt_compress = c->compress;
+
+	struct mm_state *mm = &bench_lp_init()->mm_state;
+	uint64_t n = c->size / MM_CKPT_CHUNK;
+	uint64_t **chunks = mm_alloc(n * sizeof(*chunks));
+	uint64_t rng = 0x9E3779B97F4A7C15U;
+	for(uint64_t i = 0; i < n; ++i) {
+		chunks[i] = rs_malloc(MM_CKPT_CHUNK);
+		for(unsigned j = 0; j < MM_CKPT_CHUNK / sizeof(uint64_t); ++j)
+			chunks[i][j] = bench_rand(&rng);
+	}
+
+	uint64_t rounds = max(MM_CKPT_TOTAL / c->size, 4U);
+	uint64_t ns = 0;
+	model_allocator_checkpoint_take(mm, 0);
+	for(uint64_t r = 1; r <= rounds; ++r) {
+		mm_ckpt_dirty(chunks, n, r);
+		uint64_t t = bench_clock_ns();
+		model_allocator_checkpoint_take(mm, 1);
+		if(!c->restore)
+			ns += bench_clock_ns() - t;
+
+		mm_ckpt_dirty(chunks, n, r + 1);
+		t = bench_clock_ns();
+		model_allocator_checkpoint_restore(mm, 1);
+		if(c->restore)
+			ns += bench_clock_ns() - t;
+
+		model_allocator_fossil_lp_collect(mm, 1);
+	}
+
+	bench_lp_fini();
+	mm_free(chunks);
+	global_config.ckpt_cow = false;
+	global_config.ckpt_compress = false;
+
+	*ns_p = ns;
+	return rounds;
+}
+
+/**
+ * @brief Benchmark the model memory allocations by block size and the checkpoints by model state size
+ *
+ * An operation of the allocator benchmark is either an allocation or a release.
+ */
+void bench_mm(void)
+{
+	for(uint64_t size = 1U << 6U; size <= 1U << 20U; size <<= 2U)
+		bench_run("rs_malloc", "alloc_free", "size", size, mm_alloc_rep, &size);
+
+	static const struct mm_ckpt_case modes[] = {
+	    {.mode = "copy"}, {.mode = "cow", .cow = true}, {.mode = "delta", .compress = true}};
+
+	for(unsigned i = 0; i < sizeof(modes) / sizeof(*modes); ++i) {
+		for(uint64_t size = 1U << 16U; size <= 1U << 24U; size <<= 4U) {
+			struct mm_ckpt_case c = modes[i];
+			c.size = size;
+			bench_run("checkpoint_take", c.mode, "state_size", size, mm_ckpt_rep, &c);
+			c.restore = true;
+			bench_run("checkpoint_restore", c.mode, "state_size", size, mm_ckpt_rep, &c);
+		}
+	}
+}
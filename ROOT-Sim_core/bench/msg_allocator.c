@@ -0,0 +1,51 @@
+/**
+ * @file bench/msg_allocator.c
+ *
+ * @brief Micro-benchmark: message allocator
+ *
+ * Batches of messages are allocated and then freed, so that the free list of the allocator is exercised as it is by a
+ * LP which sends a burst of messages.
+ *
+ * SPDX-FileCopyrightText: 2008-2023 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#include "bench.h"
+
+#include <mm/msg_allocator.h>
+
+/// The count of messages allocated before freeing them
+#define MSG_ALLOCATOR_BATCH 256U
+/// The count of batches of a repetition
+#define MSG_ALLOCATOR_BATCHES (1U << 12U)
+
+static uint64_t msg_allocator_rep(void *arg, uint64_t *ns_p)
+{
+	unsigned payload_size = *(unsigned *)arg;
+	struct lp_msg *msgs[MSG_ALLOCATOR_BATCH];
+
+	uint64_t t = bench_clock_ns();
+	for(unsigned b = 0; b < MSG_ALLOCATOR_BATCHES; ++b) {
+		for(unsigned i = 0; i < MSG_ALLOCATOR_BATCH; ++i)
+			msgs[i] = msg_allocator_alloc(payload_size);
+		for(unsigned i = 0; i < MSG_ALLOCATOR_BATCH; ++i)
+			msg_allocator_free(msgs[i]);
+	}
+	*ns_p = bench_clock_ns() - t;
+
+	return (uint64_t)MSG_ALLOCATOR_BATCHES * MSG_ALLOCATOR_BATCH;
+}
+
+/**
+ * @brief Benchmark the allocation and the release of messages by payload size
+ *
+ * An operation is the allocation of a message followed, later, by its release.
+ */
+void bench_msg_allocator(void)
+{
+	static const unsigned sizes[] = {0, MSG_PAYLOAD_BASE_SIZE, MSG_PAYLOAD_BASE_SIZE + 1, 256, 1024, 4096};
+
+	msg_allocator_init();
+	for(unsigned i = 0; i < sizeof(sizes) / sizeof(*sizes); ++i)
+		bench_run("msg_allocator", "alloc_free", "payload_size", sizes[i], msg_allocator_rep, (void *)&sizes[i]);
+	msg_allocator_fini();
+}
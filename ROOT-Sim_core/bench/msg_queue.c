@@ -0,0 +1,113 @@
+/**
+ * @file bench/msg_queue.c
+ *
+ * @brief Micro-benchmark: parallel message queue
+ *
+ * Each thread inserts a batch of messages towards random LPs, hence mostly towards the queues of the other threads, and
+ * then extracts all the messages of its own queue.
+ *
+ * SPDX-FileCopyrightText: 2008-2023 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#include "bench.h"
+
+#include <core/sync.h>
+#include <datatypes/msg_queue.h>
+#include <lib/retractable/retractable.h>
+#include <log/log.h>
+#include <mm/mm.h>
+
+#include <stdatomic.h>
+#include <stdlib.h>
+
+/// The count of messages inserted by each thread in a repetition
+#define MSG_QUEUE_BATCH (1U << 16U)
+/// The count of LPs hosted by each thread
+#define MSG_QUEUE_LPS_PER_THREAD 64U
+
+/// The shared state of a repetition
+struct msg_queue_rep {
+	/// The messages to insert, MSG_QUEUE_BATCH for each thread
+	struct lp_msg *msgs;
+	/// The count of messages extracted by all the threads
+	_Atomic uint64_t extracted;
+	/// The nanoseconds taken by the insertions and the extractions
+	uint64_t ns;
+};
+
+static void msg_queue_thread(void *arg)
+{
+	struct msg_queue_rep *r = arg;
+	struct lp_ctx *lp = bench_lp_init();
+	msg_queue_init();
+	// the queue expects each thread to host at least a LP in the retractable queue
+	retractable_lib_lp_init(lp);
+
+	struct lp_msg *msgs = r->msgs + (size_t)rid * MSG_QUEUE_BATCH;
+	uint64_t t = 0;
+
+	sync_thread_barrier();
+	if(!rid)
+		t = bench_clock_ns();
+
+	for(unsigned i = 0; i < MSG_QUEUE_BATCH; ++i)
+		msg_queue_insert(&msgs[i]);
+
+	sync_thread_barrier();
+
+	uint64_t n = 0;
+	while(msg_queue_extract() != NULL)
+		++n;
+
+	atomic_fetch_add_explicit(&r->extracted, n, memory_order_relaxed);
+	sync_thread_barrier();
+	if(!rid)
+		r->ns = bench_clock_ns() - t;
+
+	retractable_lib_lp_fini(lp);
+	msg_queue_fini();
+	bench_lp_fini();
+}
+
+static uint64_t msg_queue_rep(void *arg, uint64_t *ns_p)
+{
+	unsigned n_threads = *(unsigned *)arg;
+	uint64_t count = (uint64_t)n_threads * MSG_QUEUE_BATCH;
+
+	global_config.lps = n_threads * MSG_QUEUE_LPS_PER_THREAD;
+	global_config.n_threads = n_threads;
+	n_lps_node = global_config.lps;
+
+	struct msg_queue_rep r = {.msgs = mm_alloc(count * sizeof(*r.msgs)), .extracted = 0};
+	uint64_t rng = 0x9E3779B97F4A7C15U;
+	for(uint64_t i = 0; i < count; ++i) {
+		struct lp_msg *msg = &r.msgs[i];
+		msg->dest = bench_rand(&rng) % global_config.lps;
+		msg->dest_t = bench_rand_unit(&rng);
+		msg->m_type = 0;
+		msg->pl_size = 0;
+		msg->raw_flags = 0;
+	}
+
+	msg_queue_global_init();
+	bench_threads_run(n_threads, msg_queue_thread, &r);
+	msg_queue_global_fini();
+	mm_free(r.msgs);
+
+	if(atomic_load_explicit(&r.extracted, memory_order_relaxed) != count) {
+		logger(LOG_FATAL, "The message queue lost some messages!");
+		abort();
+	}
+
+	*ns_p = r.ns;
+	return 2 * count;
+}
+
+/**
+ * @brief Benchmark the insertions and the extractions of the message queue by count of threads
+ */
+void bench_msg_queue(void)
+{
+	for(unsigned n = 1; n <= bench_threads_max; n = bench_threads_next(n))
+		bench_run("msg_queue", "insert_extract", "threads", n, msg_queue_rep, &n);
+}
@@ -0,0 +1,369 @@
+/**
+ * @file bench/phold.c
+ *
+ * @brief A configurable PHOLD benchmark
+ *
+ * Usage: rsphold [-P PROFILE] [OPTION VALUE]...
+ *
+ * Each LP keeps a population of live events: processing a live event sends a new live event plus FANOUT - 1 leaf
+ * events, which are processed but send nothing, like the duplicate copies of a gossiped block. Each event is sent to a
+ * random LP with probability REMOTE, otherwise to the sender itself. The timestamp increment of an event is LOOKAHEAD
+ * plus a draw from DIST with mean MEAN. Processing an event also reschedules the retractable event of the LP with
+ * probability RETRACTABLE: when it fires, the retractable event sends FANOUT leaf events, like a node mining a block.
+ *
+ * Options, applied in order, so that the ones following -P override the profile:
+ *   -P PROFILE      phold (default) or rblocksim, which mimics the block gossip of RBlockSim
+ *   -l LPS          the count of LPs
+ *   -w THREADS      the count of threads, zero to use all the available cores
+ *   -e DENSITY      the count of live events per LP
+ *   -p PAYLOAD      the size in bytes of the payload of the events
+ *   -f FANOUT       the count of events sent by each live event
+ *   -r REMOTE       the probability of sending an event to a random LP
+ *   -a LOOKAHEAD    the minimum timestamp increment of the events
+ *   -m MEAN         the mean of the random part of the timestamp increments
+ *   -d DIST         the distribution of the random part of the timestamp increments: exp, uniform or const
+ *   -x RETRACTABLE  the probability of rescheduling the retractable event of the LP
+ *   -t TIME         the termination time
+ *   -s FILE         the ROOT-Sim statistics file, none by default
+ *   -o FILE         the file where the results are written, the standard output by default
+ *   -S              run on the serial runtime
+ *
+ * The parameters and the results are written as JSON, on a line of their own. The processed events include the ones
+ * rolled back and the ones silently re-executed to rebuild a state, so the efficiency is the share of the event handler
+ * executions which ended up committed.
+ *
+ * SPDX-FileCopyrightText: 2008-2023 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#include <ROOT-Sim.h>
+
+#include <math.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+
+/// The maximum size in bytes of the payload of the events
+#define PHOLD_PAYLOAD_MAX (1U << 16U)
+
+/// The event types of the model
+enum phold_event {
+	/// An event which sends the next live event of the population
+	PHOLD_LIVE = 1,
+	/// An event which sends nothing
+	PHOLD_LEAF
+};
+
+/// The distributions of the random part of the timestamp increments
+enum phold_dist {
+	PHOLD_DIST_EXP,
+	PHOLD_DIST_UNIFORM,
+	PHOLD_DIST_CONST
+};
+
+/// The parameters of the benchmark
+struct phold_params {
+	/// The name of the profile the parameters started from
+	const char *profile;
+	/// The count of live events per LP
+	unsigned density;
+	/// The size in bytes of the payload of the events
+	unsigned payload;
+	/// The count of events sent by each live event
+	unsigned fanout;
+	/// The probability of sending an event to a random LP
+	double remote;
+	/// The minimum timestamp increment of the events
+	double lookahead;
+	/// The mean of the random part of the timestamp increments
+	double mean;
+	/// The distribution of the random part of the timestamp increments
+	enum phold_dist dist;
+	/// The probability of rescheduling the retractable event of the LP
+	double retractable;
+};
+
+/// The state of a LP
+struct phold_state {
+	/// The state of the random number generator
+	__uint128_t seed;
+	/// The count of events processed in the trajectory of the LP
+	uint64_t events;
+};
+
+static const char *const dist_names[] = {"exp", "uniform", "const"};
+
+static struct phold_params params;
+/// The path of the file where the results are written, NULL for the standard output
+static const char *out_path;
+static const unsigned char payload[PHOLD_PAYLOAD_MAX];
+
+/// The count of events processed by the current thread and not yet added to #processed_total
+static _Thread_local uint64_t processed;
+/// The count of events processed by all the threads
+static _Atomic uint64_t processed_total;
+/// The count of events in the final trajectories of all the LPs
+static _Atomic uint64_t committed_total;
+
+static void ProcessEvent(lp_id_t me, simtime_t now, unsigned event_type, const void *content, unsigned size,
+    void *s);
+
+static struct simulation_configuration conf = {
+    .lps = 1024,
+    .n_threads = 0,
+    .termination_time = 1000,
+    .gvt_period = 1000,
+    .log_level = LOG_WARN,
+    .ckpt_interval = 0,
+    .core_binding = false,
+    .serial = false,
+    .dispatcher = ProcessEvent,
+    .committed = NULL,
+};
+
+static double Random(struct phold_state *state)
+{
+	const __uint128_t multiplier = (((__uint128_t)0x0fc94e3bf4e9ab32ULL) << 64) + 0x866458cd56f5e605ULL;
+	state->seed *= multiplier;
+	uint64_t ret = state->seed >> 64u;
+	return (double)ret / (double)UINT64_MAX;
+}
+
+static simtime_t Increment(struct phold_state *state)
+{
+	switch(params.dist) {
+		case PHOLD_DIST_UNIFORM:
+			return params.lookahead + 2 * params.mean * Random(state);
+		case PHOLD_DIST_CONST:
+			return params.lookahead + params.mean;
+		default:
+			return params.lookahead + params.mean * (-log(1. - Random(state)));
+	}
+}
+
+static lp_id_t Destination(lp_id_t me, struct phold_state *state)
+{
+	if(Random(state) >= params.remote)
+		return me;
+	lp_id_t dest = (lp_id_t)(Random(state) * conf.lps);
+	return dest < conf.lps ? dest : conf.lps - 1;
+}
+
+static void SendLeaves(lp_id_t me, simtime_t now, unsigned count, struct phold_state *state)
+{
+	for(unsigned i = 0; i < count; ++i)
+		ScheduleNewEvent(Destination(me, state), now + Increment(state), PHOLD_LEAF, payload, params.payload);
+}
+
+static void ProcessEvent(lp_id_t me, simtime_t now, unsigned event_type, const void *content, unsigned size, void *s)
+{
+	(void)content;
+	(void)size;
+	struct phold_state *state = s;
+
+	switch(event_type) {
+		case LP_INIT:
+			state = rs_malloc(sizeof(*state));
+			if(state == NULL)
+				abort();
+			state->seed = ((__uint128_t)me << 1u) | 1u;
+			state->events = 0;
+			SetState(state);
+
+			for(unsigned i = 0; i < params.density; i++)
+				ScheduleNewEvent(me, Increment(state), PHOLD_LIVE, payload, params.payload);
+			if(params.retractable > 0)
+				ScheduleRetractableEvent(Increment(state));
+			return;
+
+		case LP_FINI:
+			atomic_fetch_add_explicit(&committed_total, state->events, memory_order_relaxed);
+			atomic_fetch_add_explicit(&processed_total, processed, memory_order_relaxed);
+			processed = 0;
+			return;
+
+		case PHOLD_LIVE:
+			ScheduleNewEvent(Destination(me, state), now + Increment(state), PHOLD_LIVE, payload, params.payload);
+			SendLeaves(me, now, params.fanout - 1, state);
+			if(params.retractable > 0 && Random(state) < params.retractable)
+				ScheduleRetractableEvent(now + Increment(state));
+			break;
+
+		case PHOLD_LEAF:
+			break;
+
+		case LP_RETRACTABLE:
+			SendLeaves(me, now, params.fanout, state);
+			break;
+
+		default:
+			fprintf(stderr, "Unknown event type\n");
+			abort();
+	}
+
+	++state->events;
+	++processed;
+}
+
+/**
+ * @brief Apply a profile to the parameters
+ * @param name the name of the profile
+ * @return true if the profile exists, false otherwise
+ *
+ * The rblocksim profile approximates the block propagation of RBlockSim with its default configuration: the gossip
+ * fanout of the nodes, the size of a compact block announcing a hundred transactions, the latency of the links between
+ * the regions as lookahead and the mining restarts caused by the received blocks.
+ */
+static bool ApplyProfile(const char *name)
+{
+	if(!strcmp(name, "phold")) {
+		params = (struct phold_params){.profile = "phold", .density = 1, .payload = sizeof(long), .fanout = 1,
+		    .remote = 0.25, .lookahead = 0.0, .mean = 1.0, .dist = PHOLD_DIST_EXP, .retractable = 0.0};
+		conf.lps = 1024;
+		conf.termination_time = 1000;
+	} else if(!strcmp(name, "rblocksim")) {
+		params = (struct phold_params){.profile = "rblocksim", .density = 1, .payload = 448, .fanout = 80,
+		    .remote = 1.0, .lookahead = 0.011, .mean = 0.2, .dist = PHOLD_DIST_EXP, .retractable = 0.01};
+		conf.lps = 1000;
+		conf.termination_time = 10;
+	} else {
+		return false;
+	}
+	return true;
+}
+
+static void Usage(const char *prog)
+{
+	fprintf(stderr,
+	    "Usage: %s [-P phold|rblocksim] [-l LPS] [-w THREADS] [-e DENSITY] [-p PAYLOAD] [-f FANOUT] [-r REMOTE]\n"
+	    "       [-a LOOKAHEAD] [-m MEAN] [-d exp|uniform|const] [-x RETRACTABLE] [-t TIME] [-s FILE] [-o FILE] [-S]\n",
+	    prog);
+	exit(EXIT_FAILURE);
+}
+
+static void ParseArgs(int argc, char **argv)
+{
+	ApplyProfile("phold");
+
+	for(int i = 1; i < argc; ++i) {
+		if(argv[i][0] != '-' || argv[i][1] == '\0' || argv[i][2] != '\0')
+			Usage(argv[0]);
+
+		char opt = argv[i][1];
+		if(opt == 'S') {
+			conf.serial = true;
+			continue;
+		}
+
+		if(i + 1 >= argc)
+			Usage(argv[0]);
+		const char *v = argv[++i];
+
+		switch(opt) {
+			case 'P':
+				if(!ApplyProfile(v))
+					Usage(argv[0]);
+				break;
+			case 'l':
+				conf.lps = strtoul(v, NULL, 10);
+				break;
+			case 'w':
+				conf.n_threads = strtoul(v, NULL, 10);
+				break;
+			case 'e':
+				params.density = strtoul(v, NULL, 10);
+				break;
+			case 'p':
+				params.payload = strtoul(v, NULL, 10);
+				break;
+			case 'f':
+				params.fanout = strtoul(v, NULL, 10);
+				break;
+			case 'r':
+				params.remote = strtod(v, NULL);
+				break;
+			case 'a':
+				params.lookahead = strtod(v, NULL);
+				break;
+			case 'm':
+				params.mean = strtod(v, NULL);
+				break;
+			case 'd': {
+				unsigned d = 0;
+				while(d < sizeof(dist_names) / sizeof(*dist_names) && strcmp(v, dist_names[d]))
+					++d;
+				if(d == sizeof(dist_names) / sizeof(*dist_names))
+					Usage(argv[0]);
+				params.dist = d;
+				break;
+			}
+			case 'x':
+				params.retractable = strtod(v, NULL);
+				break;
+			case 't':
+				conf.termination_time = strtod(v, NULL);
+				break;
+			case 's':
+				conf.stats_file = v;
+				break;
+			case 'o':
+				out_path = v;
+				break;
+			default:
+				Usage(argv[0]);
+		}
+	}
+
+	if(conf.lps == 0 || params.fanout == 0 || params.payload > PHOLD_PAYLOAD_MAX ||
+	    params.lookahead + params.mean <= 0) {
+		fprintf(stderr, "Invalid parameters\n");
+		exit(EXIT_FAILURE);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	ParseArgs(argc, argv);
+	conf.logfile = stderr;
+
+	if(RootsimInit(&conf))
+		return EXIT_FAILURE;
+
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	int ret = RootsimRun();
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	if(ret)
+		return EXIT_FAILURE;
+
+	double wall = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) * 1e-9;
+	uint64_t proc = atomic_load_explicit(&processed_total, memory_order_relaxed);
+	uint64_t comm = atomic_load_explicit(&committed_total, memory_order_relaxed);
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+
+	// the core prints the progress of the simulation on the standard output, without a trailing newline
+	FILE *out = stdout;
+	if(out_path == NULL) {
+		printf("\n");
+	} else if((out = fopen(out_path, "w")) == NULL) {
+		fprintf(stderr, "Unable to open %s for writing\n", out_path);
+		return EXIT_FAILURE;
+	}
+
+	fprintf(out, "{\"profile\": \"%s\", \"lps\": %u, \"threads\": %u, \"serial\": %s, \"density\": %u, \"payload\": %u, "
+	    "\"fanout\": %u, \"remote\": %g, \"lookahead\": %g, \"mean\": %g, \"dist\": \"%s\", \"retractable\": %g, "
+	    "\"termination_time\": %g, \"wall_time_s\": %.6f, \"processed_events\": %llu, \"committed_events\": %llu, "
+	    "\"events_per_sec\": %.0f, \"efficiency\": %.4f, \"peak_rss_kib\": %ld}\n",
+	    params.profile, (unsigned)conf.lps, conf.n_threads, conf.serial ? "true" : "false", params.density,
+	    params.payload, params.fanout, params.remote, params.lookahead, params.mean, dist_names[params.dist],
+	    params.retractable, conf.termination_time, wall, (unsigned long long)proc, (unsigned long long)comm,
+	    comm / wall, proc ? (double)comm / (double)proc : 0.0, usage.ru_maxrss);
+
+	if(out != stdout)
+		fclose(out);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,89 @@
+/**
+ * @file bench/queue.c
+ *
+ * @brief Micro-benchmark: priority queues
+ *
+ * The binary heap used by the message queues is compared with the indexed 4-ary heap used by the retractable queue.
+ * Each repetition performs hold operations on a queue of fixed size: the minimum element is extracted and reinserted
+ * with a later timestamp, as happens to the events of a steady state simulation.
+ *
+ * SPDX-FileCopyrightText: 2008-2023 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#include "bench.h"
+
+#include <datatypes/heap.h>
+#include <datatypes/retractable_heap.h>
+
+/// The count of hold operations of a repetition
+#define QUEUE_HOLD_OPS (1U << 20U)
+
+/// An element of the benchmarked queues, laid out as the ones of the message queue
+struct queue_elem {
+	/// The timestamp of the element
+	simtime_t t;
+	/// The payload of the element
+	void *m;
+};
+
+#define queue_elem_is_before(a, b) ((a).t < (b).t)
+#define queue_elem_update(elem, i) ((void)(i))
+
+static uint64_t queue_heap_rep(void *arg, uint64_t *ns_p)
+{
+	uint64_t size = *(uint64_t *)arg;
+	uint64_t rng = 0x9E3779B97F4A7C15U;
+	heap_declare(struct queue_elem) q;
+	heap_init(q);
+
+	for(uint64_t i = 0; i < size; ++i) {
+		struct queue_elem e = {.t = bench_rand_unit(&rng), .m = NULL};
+		heap_insert(q, queue_elem_is_before, e);
+	}
+
+	uint64_t t = bench_clock_ns();
+	for(unsigned i = 0; i < QUEUE_HOLD_OPS; ++i) {
+		struct queue_elem e = heap_extract(q, queue_elem_is_before);
+		e.t += bench_rand_unit(&rng);
+		heap_insert(q, queue_elem_is_before, e);
+	}
+	*ns_p = bench_clock_ns() - t;
+
+	heap_fini(q);
+	return QUEUE_HOLD_OPS;
+}
+
+static uint64_t queue_rheap_rep(void *arg, uint64_t *ns_p)
+{
+	uint64_t size = *(uint64_t *)arg;
+	uint64_t rng = 0x9E3779B97F4A7C15U;
+	rheap_declare(struct queue_elem) q;
+	rheap_init(q);
+
+	for(uint64_t i = 0; i < size; ++i) {
+		struct queue_elem e = {.t = bench_rand_unit(&rng), .m = NULL};
+		rheap_insert(q, queue_elem_is_before, queue_elem_update, e);
+	}
+
+	uint64_t t = bench_clock_ns();
+	for(unsigned i = 0; i < QUEUE_HOLD_OPS; ++i) {
+		struct queue_elem e = rheap_extract(q, queue_elem_is_before, queue_elem_update);
+		e.t += bench_rand_unit(&rng);
+		rheap_insert(q, queue_elem_is_before, queue_elem_update, e);
+	}
+	*ns_p = bench_clock_ns() - t;
+
+	rheap_fini(q);
+	return QUEUE_HOLD_OPS;
+}
+
+/**
+ * @brief Benchmark the hold operations of the priority queues by queue size
+ */
+void bench_queue(void)
+{
+	for(uint64_t size = 1U << 10U; size <= 1U << 20U; size <<= 5U) {
+		bench_run("queue", "binary_heap", "size", size, queue_heap_rep, &size);
+		bench_run("queue", "4ary_indexed_heap", "size", size, queue_rheap_rep, &size);
+	}
+}
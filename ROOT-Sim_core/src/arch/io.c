@@ -25,10 +25,41 @@
  * @return a temporary file, an opaque object to be used in this module
  */
 
+/**
+ * @fn io_endpoint_open(const char *path)
+ * @brief Opens a write-only endpoint which never blocks the caller
+ * @param path the path of the endpoint: a Unix domain datagram socket if prefixed by #IO_ENDPOINT_UNIX_PREFIX, a file
+ *             opened in append mode otherwise
+ * @return a descriptor of the endpoint, -1 if unsuccessful
+ */
+
+/**
+ * @fn io_endpoint_write(int endpoint, const void *data, size_t data_size)
+ * @brief Writes a record to an endpoint
+ * @param endpoint the descriptor of the endpoint obtained with io_endpoint_open()
+ * @param data a pointer to the memory buffer containing the record
+ * @param data_size the size of the memory buffer pointed by @p data
+ *
+ * The record is written with a single system call, so that concurrent writers don't interleave their records. If the
+ * endpoint is not ready to receive it, the record is silently dropped.
+ */
+
+/**
+ * @fn io_endpoint_close(int endpoint)
+ * @brief Closes an endpoint
+ * @param endpoint the descriptor of the endpoint obtained with io_endpoint_open()
+ */
+
+#include <string.h>
 #include <time.h>
 
 #ifdef __POSIX
 
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
 void io_local_time_get(char res[IO_TIME_BUFFER_LEN])
 {
 	time_t t = time(NULL);
@@ -41,12 +72,49 @@ FILE *io_file_tmp_get(void)
 	return tmpfile();
 }
 
+int io_endpoint_open(const char *path)
+{
+	size_t prefix_len = strlen(IO_ENDPOINT_UNIX_PREFIX);
+	if(strncmp(path, IO_ENDPOINT_UNIX_PREFIX, prefix_len))
+		/* Flawfinder: ignore */
+		return open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+
+	struct sockaddr_un addr = {.sun_family = AF_UNIX};
+	path += prefix_len;
+	if(strlen(path) >= sizeof(addr.sun_path))
+		return -1;
+	strcpy(addr.sun_path, path);
+
+	int ret = socket(AF_UNIX, SOCK_DGRAM, 0);
+	if(ret == -1)
+		return -1;
+
+	if(fcntl(ret, F_SETFL, O_NONBLOCK) == -1 || connect(ret, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+		close(ret);
+		return -1;
+	}
+	return ret;
+}
+
+void io_endpoint_write(int endpoint, const void *data, size_t data_size)
+{
+	// on failure the record is dropped: a slow or missing reader must not stall the simulation
+	ssize_t ret = write(endpoint, data, data_size);
+	(void)ret;
+}
+
+void io_endpoint_close(int endpoint)
+{
+	close(endpoint);
+}
+
 #endif
 
 #ifdef __WINDOWS
 
 #include <fcntl.h>
 #include <io.h>
+#include <sys/stat.h>
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
 
@@ -84,4 +152,22 @@ FILE *io_file_tmp_get(void)
 	return _fdopen(fd, "rb+");
 }
 
+int io_endpoint_open(const char *path)
+{
+	if(!strncmp(path, IO_ENDPOINT_UNIX_PREFIX, strlen(IO_ENDPOINT_UNIX_PREFIX)))
+		return -1; // Unix domain datagram sockets aren't supported on this platform
+
+	return _open(path, _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, _S_IREAD | _S_IWRITE);
+}
+
+void io_endpoint_write(int endpoint, const void *data, size_t data_size)
+{
+	_write(endpoint, data, (unsigned)data_size);
+}
+
+void io_endpoint_close(int endpoint)
+{
+	_close(endpoint);
+}
+
 #endif
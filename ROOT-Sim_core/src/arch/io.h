@@ -18,5 +18,11 @@
 /// The bytes required to store a time string obtained with io_local_time_get()
 #define IO_TIME_BUFFER_LEN 26
 
+/// The prefix which identifies a Unix domain socket path in io_endpoint_open()
+#define IO_ENDPOINT_UNIX_PREFIX "unix:"
+
 extern void io_local_time_get(char res[IO_TIME_BUFFER_LEN]);
 extern FILE *io_file_tmp_get(void);
+extern int io_endpoint_open(const char *path);
+extern void io_endpoint_write(int endpoint, const void *data, size_t data_size);
+extern void io_endpoint_close(int endpoint);
@@ -29,6 +29,63 @@
  * @return the size in bytes of the maximal resident set, 0 if unsuccessful
  */
 
+/**
+ * @fn mem_page_size(void)
+ * @brief Get the size of a memory page
+ * @return the size in bytes of a memory page
+ */
+
+/**
+ * @fn mem_pages_map(size_t size)
+ * @brief Map a zero-filled, readable and writable range of memory pages
+ * @param size the size in bytes of the range, a multiple of the page size
+ * @return a pointer to the first page of the range, NULL if unsuccessful
+ */
+
+/**
+ * @fn mem_pages_reserve(size_t size)
+ * @brief Reserve a range of addresses, without backing it with memory
+ * @param size the size in bytes of the range, a multiple of the page size
+ * @return a pointer to the first page of the range, NULL if unsuccessful
+ *
+ * The pages of the range must be committed with mem_pages_commit() before being accessed.
+ */
+
+/**
+ * @fn mem_pages_commit(void *ptr, size_t size)
+ * @brief Back with zero-filled, readable and writable memory a part of a range reserved with mem_pages_reserve()
+ * @param ptr a pointer to the first byte to commit
+ * @param size the size in bytes of the part to commit
+ * @return 0 if successful, -1 otherwise
+ */
+
+/**
+ * @fn mem_pages_unmap(void *ptr, size_t size)
+ * @brief Unmap a range of memory pages mapped with mem_pages_map() or mem_pages_reserve()
+ * @param ptr a pointer to the first page of the range
+ * @param size the size in bytes of the range
+ */
+
+/**
+ * @fn mem_pages_protect(void *ptr, size_t size, bool writable)
+ * @brief Change the access protection of a range of memory pages
+ * @param ptr a pointer to the first page of the range
+ * @param size the size in bytes of the range, a multiple of the page size
+ * @param writable if true the pages are made readable and writable, else they are made read-only
+ * @return 0 if successful, -1 otherwise
+ */
+
+/**
+ * @fn mem_write_fault_handler_set(bool (*handler)(void *addr))
+ * @brief Install a handler for the faults caused by the writes to read-only pages
+ * @param handler the handler, called with the faulting address from the faulting thread. It returns true if it fixed
+ *                the protection of the page, so that the write can be retried, false otherwise
+ * @return 0 if successful, -1 otherwise
+ *
+ * Faults not fixed by the handler are forwarded to the previously installed handler, if any. The handler is installed
+ * once, subsequent calls are ignored.
+ */
+
 #ifdef __POSIX
 
 #include <sys/resource.h>
@@ -61,11 +118,15 @@ size_t mem_stat_rss_current_get(void)
 #include <stdlib.h>
 #include <unistd.h>
 
-static int proc_stat_fd;
+static int proc_stat_fd = -1;
 static long linux_page_size;
 
 int mem_stat_setup(void)
 {
+	// Already set up by a previous simulation
+	if(proc_stat_fd != -1)
+		return 0;
+
 	/* Flawfinder: ignore */
 	proc_stat_fd = open("/proc/self/statm", O_RDONLY);
 	if(proc_stat_fd == -1)
@@ -119,6 +180,94 @@ size_t mem_stat_rss_max_get(void)
 #endif
 }
 
+
+#include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static bool (*write_fault_handler)(void *addr);
+static struct sigaction prev_segv_action;
+static struct sigaction prev_bus_action;
+
+size_t mem_page_size(void)
+{
+	static size_t page_size;
+	if(!page_size)
+		page_size = (size_t)sysconf(_SC_PAGESIZE);
+	return page_size;
+}
+
+void *mem_pages_map(size_t size)
+{
+	void *ret = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	return ret == MAP_FAILED ? NULL : ret;
+}
+
+void *mem_pages_reserve(size_t size)
+{
+	// the pages are populated on first touch: with no swap space reserved, the range costs address space only
+#ifdef MAP_NORESERVE
+	int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE;
+#else
+	int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#endif
+	void *ret = mmap(NULL, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+	return ret == MAP_FAILED ? NULL : ret;
+}
+
+int mem_pages_commit(void *ptr, size_t size)
+{
+	(void)ptr;
+	(void)size;
+	return 0;
+}
+
+void mem_pages_unmap(void *ptr, size_t size)
+{
+	munmap(ptr, size);
+}
+
+int mem_pages_protect(void *ptr, size_t size, bool writable)
+{
+	return mprotect(ptr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ);
+}
+
+static void write_fault_signal_handler(int sig, siginfo_t *info, void *ctx)
+{
+	if(write_fault_handler(info->si_addr))
+		return;
+
+	// not ours: forward the fault to the previous handler
+	struct sigaction *prev = sig == SIGSEGV ? &prev_segv_action : &prev_bus_action;
+	if(prev->sa_flags & SA_SIGINFO) {
+		prev->sa_sigaction(sig, info, ctx);
+	} else if(prev->sa_handler == SIG_DFL || prev->sa_handler == SIG_IGN) {
+		// the faulting instruction is retried and the default action takes place
+		sigaction(sig, prev, NULL);
+	} else {
+		prev->sa_handler(sig);
+	}
+}
+
+int mem_write_fault_handler_set(bool (*handler)(void *addr))
+{
+	if(write_fault_handler != NULL)
+		return 0;
+
+	write_fault_handler = handler;
+
+	struct sigaction act = {0};
+	act.sa_sigaction = write_fault_signal_handler;
+	act.sa_flags = SA_SIGINFO | SA_NODEFER;
+	sigemptyset(&act.sa_mask);
+	// some platforms raise SIGBUS instead of SIGSEGV on protection faults
+	if(sigaction(SIGSEGV, &act, &prev_segv_action) || sigaction(SIGBUS, &act, &prev_bus_action)) {
+		write_fault_handler = NULL;
+		return -1;
+	}
+	return 0;
+}
+
 #endif
 
 #ifdef __WINDOWS
@@ -145,4 +294,68 @@ size_t mem_stat_rss_max_get(void)
 	return (size_t)info.PeakWorkingSetSize;
 }
 
+static bool (*write_fault_handler)(void *addr);
+
+size_t mem_page_size(void)
+{
+	static size_t page_size;
+	if(!page_size) {
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		page_size = (size_t)info.dwPageSize;
+	}
+	return page_size;
+}
+
+void *mem_pages_map(size_t size)
+{
+	return VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+}
+
+void *mem_pages_reserve(size_t size)
+{
+	return VirtualAlloc(NULL, size, MEM_RESERVE, PAGE_NOACCESS);
+}
+
+int mem_pages_commit(void *ptr, size_t size)
+{
+	return VirtualAlloc(ptr, size, MEM_COMMIT, PAGE_READWRITE) == NULL ? -1 : 0;
+}
+
+void mem_pages_unmap(void *ptr, size_t size)
+{
+	(void)size;
+	VirtualFree(ptr, 0, MEM_RELEASE);
+}
+
+int mem_pages_protect(void *ptr, size_t size, bool writable)
+{
+	DWORD old;
+	return VirtualProtect(ptr, size, writable ? PAGE_READWRITE : PAGE_READONLY, &old) ? 0 : -1;
+}
+
+static LONG CALLBACK write_fault_exception_handler(PEXCEPTION_POINTERS info)
+{
+	PEXCEPTION_RECORD rec = info->ExceptionRecord;
+	// ExceptionInformation[0] is 1 for write accesses, ExceptionInformation[1] is the faulting address
+	if(rec->ExceptionCode == EXCEPTION_ACCESS_VIOLATION && rec->ExceptionInformation[0] == 1 &&
+	    write_fault_handler((void *)rec->ExceptionInformation[1]))
+		return EXCEPTION_CONTINUE_EXECUTION;
+
+	return EXCEPTION_CONTINUE_SEARCH;
+}
+
+int mem_write_fault_handler_set(bool (*handler)(void *addr))
+{
+	if(write_fault_handler != NULL)
+		return 0;
+
+	write_fault_handler = handler;
+	if(AddVectoredExceptionHandler(1, write_fault_exception_handler) == NULL) {
+		write_fault_handler = NULL;
+		return -1;
+	}
+	return 0;
+}
+
 #endif
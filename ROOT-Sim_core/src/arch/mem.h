@@ -13,6 +13,7 @@
 
 #include <arch/platform.h>
 
+#include <stdbool.h>
 #include <stddef.h>
 
 #ifdef __WINDOWS
@@ -31,3 +32,11 @@
 extern int mem_stat_setup(void);
 extern size_t mem_stat_rss_max_get(void);
 extern size_t mem_stat_rss_current_get(void);
+
+extern size_t mem_page_size(void);
+extern void *mem_pages_map(size_t size);
+extern void *mem_pages_reserve(size_t size);
+extern int mem_pages_commit(void *ptr, size_t size);
+extern void mem_pages_unmap(void *ptr, size_t size);
+extern int mem_pages_protect(void *ptr, size_t size, bool writable);
+extern int mem_write_fault_handler_set(bool (*handler)(void *addr));
@@ -59,6 +59,9 @@ void control_msg_fini(void)
 		free(library_handlers);
 		library_handlers = NULL;
 	}
+	library_handlers_capacity = 0;
+	library_handlers_size = 0;
+	next_control_msg_id = FIRST_LIBRARY_CONTROL_MSG_ID;
 }
 
 int control_msg_register_handler(control_msg_handler_t handler)
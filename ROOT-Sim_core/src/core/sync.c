@@ -12,6 +12,20 @@
 
 #include <core/core.h>
 
+/// The counters of the thread barrier, alternately used by consecutive barrier phases
+static atomic_uint cs[2]; // FIXME: this makes this barrier stateful with respect to the threads used
+
+/**
+ * @brief Resets the thread barrier, so that a fresh set of threads can synchronize on it
+ *
+ * This must be called while no thread is waiting on the barrier.
+ */
+void sync_thread_barrier_reset(void)
+{
+	atomic_store_explicit(&cs[0], 0U, memory_order_relaxed);
+	atomic_store_explicit(&cs[1], 0U, memory_order_relaxed);
+}
+
 /**
  * @brief Synchronizes threads on a barrier
  * @return true if this thread has been elected as leader, false otherwise
@@ -22,7 +36,6 @@ bool sync_thread_barrier(void)
 	unsigned r;
 
 	static __thread unsigned phase;
-	static atomic_uint cs[2]; // FIXME: this makes this barrier stateful with respect to the threads used
 	atomic_uint *c = cs + (phase & 1U);
 
 	if(phase & 2U) {
@@ -123,6 +123,22 @@ struct lp_msg *msg_queue_extract(void)
 	return likely(heap_count(mqp)) ? heap_extract(mqp, q_elem_is_before).m : NULL;
 }
 
+/**
+ * @brief Peeks the timestamp of the next message in the queue
+ * @returns the timestamp of the message which msg_queue_extract() would return, SIMTIME_MAX if there isn't one
+ */
+simtime_t msg_queue_time_peek(void)
+{
+	msg_queue_insert_queued();
+
+	simtime_t qt = likely(heap_count(mqp)) ? heap_min(mqp).t : SIMTIME_MAX;
+#ifdef ROOTSIM_RETRACTABLE
+	simtime_t rt = retractable_min_t();
+	qt = rt <= qt ? rt : qt;
+#endif
+	return qt;
+}
+
 /**
  * @brief Inserts a message in the queue
  * @param msg the message to insert in the queue
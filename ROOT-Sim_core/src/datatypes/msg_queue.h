@@ -18,4 +18,5 @@ extern void msg_queue_global_fini(void);
 extern void msg_queue_init(void);
 extern void msg_queue_fini(void);
 extern struct lp_msg *msg_queue_extract(void);
+extern simtime_t msg_queue_time_peek(void);
 extern void msg_queue_insert(struct lp_msg *msg);
@@ -62,9 +62,17 @@ static void comm_error_handler(MPI_Comm *comm, int *err_code_p, ...)
  * @brief Initializes the MPI environment
  * @param argc_p a pointer to the OS supplied argc
  * @param argv_p a pointer to the OS supplied argv
+ *
+ * MPI can't be initialized again once finalized, so the environment is set up by the first simulation only and torn
+ * down at process exit: this way the model can run several simulations back to back.
  */
 void mpi_global_init(int *argc_p, char ***argv_p)
 {
+	int initialized;
+	MPI_Initialized(&initialized);
+	if(initialized)
+		return;
+
 	int thread_lvl = MPI_THREAD_SINGLE;
 	MPI_Init_thread(argc_p, argv_p, MPI_THREAD_MULTIPLE, &thread_lvl);
 
@@ -86,6 +94,8 @@ void mpi_global_init(int *argc_p, char ***argv_p)
 	nid = helper;
 	MPI_Comm_size(MPI_COMM_WORLD, &helper);
 	n_nodes = helper;
+
+	atexit(mpi_global_fini);
 }
 
 /**
@@ -93,6 +103,11 @@ void mpi_global_init(int *argc_p, char ***argv_p)
  */
 void mpi_global_fini(void)
 {
+	int finalized;
+	MPI_Finalized(&finalized);
+	if(finalized)
+		return;
+
 	MPI_Errhandler err_handler;
 	MPI_Comm_get_errhandler(MPI_COMM_WORLD, &err_handler);
 	MPI_Errhandler_free(&err_handler);
@@ -9,6 +9,7 @@
 
 #include <gvt/fossil.h>
 
+#include <log/records.h>
 #include <mm/msg_allocator.h>
 
 __thread unsigned fossil_epoch_current;
@@ -55,6 +56,7 @@ void fossil_lp_collect(struct lp_ctx *lp)
 			msg_allocator_free(unmark_msg(msg));
 	}
 	array_truncate_first(proc_p->p_msgs, past_i);
+	records_lp_fossil(lp, past_i);
 
 	lp->fossil_epoch = fossil_epoch_current;
 }
@@ -66,6 +66,8 @@ enum node_phase {
 static __thread enum thread_phase thread_phase = thread_phase_idle;
 /// The timer used to plan the execution of the next GVT algorithm
 static timer_uint gvt_timer;
+/// If set, the next GVT algorithm is started without waiting for the GVT period to elapse
+static _Atomic bool gvt_early;
 /// Helper array for the reduction of the node-local GVT
 static simtime_t reducing_p[MAX_THREADS];
 /// This keeps the minimum timestamp of messages extracted by the current thread
@@ -80,6 +82,9 @@ static _Atomic rid_t c_b = 0;
 /// The count of nodes still involved in a GVT computation
 /** If this is 0 that means that a new GVT computation can be safely started */
 static _Atomic nid_t gvt_nodes;
+/// A counter used to synchronize threads during the distributed min GVT reduction
+/** The GVT reductions which flush a simulation end before this is decreased, see gvt_msg_drain() */
+static _Atomic rid_t c_d;
 /// The "color" of the current GVT phase
 /** Colors are red if false, yellow if true ;) */
 __thread _Bool gvt_phase;
@@ -96,6 +101,21 @@ __thread uint32_t remote_msg_received[2];
 void gvt_global_init(void)
 {
 	gvt_timer = timer_new();
+	atomic_store_explicit(&gvt_early, false, memory_order_relaxed);
+	// The previous simulation may have left these set, since the threads quit right after its last GVT reduction
+	atomic_store_explicit(&gvt_nodes, 0U, memory_order_relaxed);
+	atomic_store_explicit(&c_d, 0U, memory_order_relaxed);
+}
+
+/**
+ * @brief Requests the next GVT algorithm to start as soon as possible
+ *
+ * Only the master thread of the master node starts GVT reductions, so this has effect on the node-local requests of
+ * the master node only.
+ */
+void gvt_start_early(void)
+{
+	atomic_store_explicit(&gvt_early, true, memory_order_relaxed);
 }
 
 /**
@@ -184,7 +204,6 @@ static bool gvt_node_phase_run(void)
 	static _Atomic(int32_t) total_msg_received;
 	static uint32_t remote_msg_to_receive;
 	static _Atomic(rid_t) c_c;
-	static _Atomic(rid_t) c_d;
 
 	switch(node_phase) {
 		case node_phase_redux_first:
@@ -284,9 +303,11 @@ simtime_t gvt_phase_run(void)
 
 	if(unlikely(!rid && !nid)) {
 		timer_uint t = timer_new();
-		if(unlikely(global_config.gvt_period < t - gvt_timer &&
+		if(unlikely((global_config.gvt_period < t - gvt_timer ||
+				atomic_load_explicit(&gvt_early, memory_order_relaxed)) &&
 			    !atomic_load_explicit(&gvt_nodes, memory_order_relaxed))) {
 			gvt_timer = t;
+			atomic_store_explicit(&gvt_early, false, memory_order_relaxed);
 			atomic_fetch_add_explicit(&gvt_nodes, n_nodes, memory_order_relaxed);
 			mpi_control_msg_broadcast(MSG_CTRL_GVT_START);
 		}
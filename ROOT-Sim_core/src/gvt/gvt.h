@@ -20,6 +20,7 @@ extern __thread uint32_t remote_msg_seq[2][MAX_NODES];
 extern __thread uint32_t remote_msg_received[2];
 
 extern void gvt_start_processing(void);
+extern void gvt_start_early(void);
 extern void gvt_on_done_ctrl_msg(void);
 extern void gvt_msg_drain(void);
 
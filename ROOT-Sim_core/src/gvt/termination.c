@@ -32,9 +32,18 @@ void termination_global_init(void)
 
 /**
  * @brief Initialize the termination detection module LP-wide
+ *
+ * Without a termination detection function, the LP never declares its intention to terminate, so that the simulation
+ * ends when the GVT reaches the termination time.
  */
 void termination_lp_init(struct lp_ctx *lp)
 {
+	if(global_config.committed == NULL) {
+		++lps_to_end;
+		lp->termination_t = 0;
+		return;
+	}
+
 	bool term = global_config.committed(lp - lps, lp->state_pointer);
 	lps_to_end += !term;
 	lp->termination_t = term * SIMTIME_MAX;
@@ -46,7 +55,7 @@ void termination_lp_init(struct lp_ctx *lp)
  */
 void termination_on_msg_process(struct lp_ctx *lp, simtime_t msg_time)
 {
-	if(lp->termination_t)
+	if(lp->termination_t || global_config.committed == NULL)
 		return;
 
 	bool term = global_config.committed(lp - lps, lp->state_pointer);
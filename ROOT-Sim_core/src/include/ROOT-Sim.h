@@ -68,6 +68,21 @@ typedef void (*ProcessEvent_t)(lp_id_t me, simtime_t now, unsigned event_type, c
  */
 typedef bool (*CanEnd_t)(lp_id_t me, const void *snapshot);
 
+/**
+ * @brief GVT notification callback function
+ * @param me The logical process ID of the called LP
+ * @param gvt The freshly computed global virtual time
+ * @param state The current state of the logical process
+ *
+ * This function is called on each logical process whenever a new GVT is computed. The events with a timestamp earlier
+ * than @p gvt are committed and will never be rolled back, so the resources only needed to roll them back (e.g.,
+ * memory shared by many logical processes) can be released here. The current state may be speculative: the model can
+ * tell which changes are committed by keeping in the state the simulation time at which they were made.
+ *
+ * @warning The state is not checkpointed after this call, so it should not be modified.
+ */
+typedef void (*OnGvt_t)(lp_id_t me, simtime_t gvt, const void *state);
+
 enum rootsim_event {LP_RETRACTABLE = 65533, LP_INIT, LP_FINI};
 
 /**
@@ -90,6 +105,19 @@ extern void ScheduleRetractableEvent(simtime_t timestamp);
 
 extern void SetState(void *new_state);
 
+/**
+ * @brief API to emit a record which is written to the records file once committed
+ *
+ * The record is buffered by the simulation kernel outside of the LP state. It is discarded if the emitting event is
+ * rolled back, otherwise it is written to the records file as soon as the GVT goes past @p now. This is a cheap way
+ * to produce detailed simulation traces without growing the checkpointed state.
+ *
+ * @param now The current simulation time
+ * @param record_type Numerical record type, stored alongside the record
+ * @param record The record content, which is simulation_configuration.record_size bytes long
+ */
+extern void CommitRecord(simtime_t now, unsigned record_type, const void *record);
+
 extern void *rs_malloc(size_t req_size);
 extern void *rs_calloc(size_t nmemb, size_t size);
 extern void rs_free(void *ptr);
@@ -111,7 +139,8 @@ struct simulation_configuration {
 	lp_id_t lps;
 	/// The number of threads to be used in the simulation. If zero, it defaults to the amount of available cores
 	unsigned n_threads;
-	/// The target termination logical time. Setting this value to zero means that LVT-based termination is disabled
+	/// The target termination logical time. Events scheduled past it are discarded. Setting this value to zero means
+	/// that LVT-based termination is disabled
 	simtime_t termination_time;
 	/// The gvt period expressed in microseconds
 	unsigned gvt_period;
@@ -121,16 +150,38 @@ struct simulation_configuration {
 	FILE *logfile;
 	/// Path to the statistics file. If NULL, no statistics are produced.
 	const char *stats_file;
+	/// If set, per-LP and per-message type profiling counters are added to the statistics file
+	bool stats_profile;
+	/// Path to the live telemetry endpoint: a Unix domain datagram socket if prefixed by "unix:", otherwise a file
+	/// to append to. If NULL, no telemetry is produced.
+	const char *telemetry_endpoint;
+	/// Path prefix of the files where committed records are written. If NULL, the records are discarded.
+	const char *records_file;
+	/// The size in bytes of the records emitted with CommitRecord()
+	unsigned record_size;
 	/// The checkpointing interval
 	unsigned ckpt_interval;
+	/// If set, the model memory is checkpointed by write-protecting its pages and copying each page on the first
+	/// write after a checkpoint, instead of copying it in full. Each copy costs a write fault, and whole pages are
+	/// copied: this pays off only for LPs with large states of which few pages are written between two checkpoints.
+	/// For states which fit in a few pages, it copies more than a full copy and is several times slower
+	bool ckpt_cow;
+	/// If set, full copy checkpoints are delta encoded against the following ones, trading time for memory. With a
+	/// memory budget, this is done only while the resident set is above its soft limit
+	bool ckpt_compress;
+	/// The resident memory budget of a node in MiB. Setting this value to zero disables the memory governor
+	unsigned mem_budget;
 	/// If set, worker threads are bound to physical cores
 	bool core_binding;
 	/// If set, the simulation will run on the serial runtime
 	bool serial;
 	/// Function pointer to the dispatching function
 	ProcessEvent_t dispatcher;
-	/// Function pointer to the termination detection function
+	/// Function pointer to the termination detection function. If NULL, the simulation ends when the GVT reaches the
+	/// termination time or when no event is left
 	CanEnd_t committed;
+	/// Function pointer to the GVT notification function. If NULL, the model is not notified of the GVT
+	OnGvt_t on_gvt;
 };
 
 extern int RootsimInit(const struct simulation_configuration *conf);
@@ -70,6 +70,23 @@ static void print_config(void)
 			fprintf(stderr, "Checkpoint interval: auto\n");
 	}
 
+	if(!global_config.serial)
+		fprintf(stderr, "Checkpointing: %s\n",
+		    global_config.ckpt_cow ? "copy-on-write" : global_config.ckpt_compress ? "delta encoded" : "full copy");
+
+	if(global_config.telemetry_endpoint != NULL)
+		fprintf(stderr, "Telemetry endpoint: %s\n", global_config.telemetry_endpoint);
+
+	if(global_config.records_file != NULL)
+		fprintf(stderr, "Records files: %s.*\n", global_config.records_file);
+
+	if(!global_config.serial) {
+		if(global_config.mem_budget)
+			fprintf(stderr, "Memory budget: %u MiB\n", global_config.mem_budget);
+		else
+			fprintf(stderr, "Memory budget: not set\n");
+	}
+
 	fprintf(stderr, "\x1b[39m");
 
 	fprintf(stderr, "\n");
@@ -80,7 +97,8 @@ static void print_config(void)
  * @brief Initialize the core library
  *
  * This function must be invoked so as to initialize the core. The structure passed to this function is
- * copied into a library variable, that is used by the core to support the simulation run.
+ * copied into a library variable, that is used by the core to support the simulation run. Once a simulation has
+ * completed, the core can be initialized again to run another simulation in the same process.
  *
  * @param conf A pointer to a struct simulation_configuration used to configure the core library.
  * @return zero if the configuration is successful, non-zero otherwise.
@@ -94,7 +112,7 @@ int RootsimInit(const struct simulation_configuration *conf)
 		return -1;
 	}
 
-	if(unlikely(global_config.dispatcher == NULL || global_config.committed == NULL)) {
+	if(unlikely(global_config.dispatcher == NULL)) {
 		fprintf(stderr, "Function pointers not correctly set\n");
 		return -1;
 	}
@@ -136,7 +154,7 @@ int RootsimInit(const struct simulation_configuration *conf)
  * @brief Start the simulation
  *
  * This function starts the simulation. It must be called *after* having initialized the ROOT-Sim core
- * by calling RootsimInit(), otherwise the invocation will fail.
+ * by calling RootsimInit(), otherwise the invocation will fail. Each call to RootsimInit() allows a single run.
  *
  * @return zero on successful simulation completion, non-zero otherwise.
  */
@@ -147,12 +165,11 @@ int RootsimRun(void)
 	if(!configuration_done)
 		return -1;
 
-	if(global_config.serial) {
+	if(global_config.serial)
 		ret = serial_simulation();
-	} else {
+	else
 		ret = parallel_simulation();
-		mpi_global_fini();
-	}
 
+	configuration_done = false;
 	return ret;
 }
@@ -6,13 +6,38 @@
 #define rq_elem_is_before(a, b) ((a).t < (b).t)
 #define rq_elem_update(rq, i) ((rq).lp->retractable_pos = (i))
 
+/// An entry of the retractable queue
 struct rq_elem {
+	/// A lower bound of the retractable time of the LP, which is exact for the queue head after rq_head_fix()
 	simtime_t t;
+	/// The LP which owns this entry
 	struct lp_ctx *lp;
 };
 
 static __thread rheap_declare(struct rq_elem) r_queue;
 
+/**
+ * @brief Bring the queue head up to date with the retractable times of the LPs
+ * @return the head of the queue
+ *
+ * Postponed retractable events are not moved in the queue when they are rescheduled: their entry keeps the older, lower
+ * time, which is a valid lower bound. An entry is sifted down only when it surfaces at the head of the queue, so that
+ * multiple postponements of the same LP cost a single sift, and entries which never surface cost nothing.
+ */
+static inline struct rq_elem rq_head_fix(void)
+{
+	struct rq_elem rq = rheap_min(r_queue);
+	simtime_t t = *rq.lp->retractable_ctx;
+	while(unlikely(t != rq.t)) {
+		rq.t = t;
+		rheap_min(r_queue).t = t;
+		rheap_priority_lowered(r_queue, rq_elem_is_before, rq_elem_update, rq, 0);
+		rq = rheap_min(r_queue);
+		t = *rq.lp->retractable_ctx;
+	}
+	return rq;
+}
+
 void retractable_lib_init(void)
 {
 	rheap_init(r_queue);
@@ -31,28 +56,28 @@ void retractable_lib_fini(void)
 	rheap_fini(r_queue);
 }
 
+/**
+ * @brief Update the retractable queue after the retractable time of a LP may have changed
+ * @param lp the LP whose retractable time may have changed
+ *
+ * Anticipated retractable events are moved towards the queue head right away, while postponed ones are lazily handled
+ * by rq_head_fix().
+ */
 void retractable_reschedule(const struct lp_ctx *lp)
 {
 	array_count_t pos = lp->retractable_pos;
-	struct rq_elem rq = array_get_at(r_queue, pos);
 	simtime_t t = *lp->retractable_ctx;
-	if(t == rq.t)
+	if(likely(t >= array_get_at(r_queue, pos).t))
 		return;
 
-	bool lowered = t > rq.t;
 	array_get_at(r_queue, pos).t = t;
-	rq.t = t;
-
-	if(lowered) {
-		rheap_priority_lowered(r_queue, rq_elem_is_before, rq_elem_update, rq, pos);
-	} else {
-		rheap_priority_increased(r_queue, rq_elem_is_before, rq_elem_update, rq, pos);
-	}
+	struct rq_elem rq = {.t = t, .lp = (struct lp_ctx *)lp};
+	rheap_priority_increased(r_queue, rq_elem_is_before, rq_elem_update, rq, pos);
 }
 
 void ScheduleRetractableEvent(simtime_t timestamp)
 {
-	*current_lp->retractable_ctx = timestamp;
+	*current_lp->retractable_ctx = timestamp > global_config.termination_time ? SIMTIME_MAX : timestamp;
 }
 
 void retractable_post_silent(const struct lp_ctx *lp, simtime_t now)
@@ -61,16 +86,38 @@ void retractable_post_silent(const struct lp_ctx *lp, simtime_t now)
 		*lp->retractable_ctx = SIMTIME_MAX;
 }
 
+void retractable_lib_lp_fini(struct lp_ctx *this_lp)
+{
+	rs_free(this_lp->retractable_ctx);
+}
+
 struct lp_msg *retractable_extract(void)
 {
-	struct rq_elem rq = rheap_min(r_queue);
-	*rq.lp->retractable_ctx = SIMTIME_MAX;
-	struct lp_msg *ret = msg_allocator_pack(rq.lp - lps, rq.t, LP_RETRACTABLE, NULL, 0);
+	struct lp_msg *ret = msg_allocator_pack(0, 0.0, LP_RETRACTABLE, NULL, 0);
 	ret->raw_flags = 0;
-	return ret;
+	return retractable_extract_in_place(ret);
+}
+
+struct lp_msg *retractable_extract_in_place(struct lp_msg *msg)
+{
+	struct rq_elem rq = rq_head_fix();
+	*rq.lp->retractable_ctx = SIMTIME_MAX;
+	msg->dest = rq.lp - lps;
+	msg->dest_t = rq.t;
+	return msg;
 }
 
 bool retractable_is_before(simtime_t normal_t)
 {
-	return rheap_min(r_queue).t <= normal_t && likely(rheap_min(r_queue).t != SIMTIME_MAX);
+	// the head entry is a lower bound: when it comes after normal_t there's no need to fix it
+	if(rheap_min(r_queue).t > normal_t)
+		return false;
+
+	simtime_t t = rq_head_fix().t;
+	return t <= normal_t && likely(t != SIMTIME_MAX);
+}
+
+simtime_t retractable_min_t(void)
+{
+	return rq_head_fix().t;
 }
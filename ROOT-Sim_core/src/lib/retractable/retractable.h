@@ -7,8 +7,11 @@
 
 extern void retractable_lib_init(void);
 extern void retractable_lib_lp_init(struct lp_ctx *lp_ctx);
+extern void retractable_lib_lp_fini(struct lp_ctx *lp_ctx);
 extern void retractable_lib_fini(void);
 extern void retractable_reschedule(const struct lp_ctx *lp_ctx);
 extern struct lp_msg *retractable_extract(void);
+extern struct lp_msg *retractable_extract_in_place(struct lp_msg *msg);
 extern void retractable_post_silent(const struct lp_ctx *lp, simtime_t now);
 extern bool retractable_is_before(simtime_t normal_t);
+extern simtime_t retractable_min_t(void);
@@ -0,0 +1,97 @@
+#!/usr/bin/env python3
+# SPDX-FileCopyrightText: 2008-2023 HPDCS Group <rootsim@googlegroups.com>
+# SPDX-License-Identifier: GPL-3.0-only
+"""Module for loading the committed records written by ROOT-Sim.
+
+If you configured ROOT-Sim to collect the records emitted with CommitRecord(), each thread writes a columnar
+binary file named "<records_file>.<node id>.<thread id>", which can be loaded using the `RSRecords` class.
+
+Usage:
+    records = RSRecords(glob.glob('path/to/records_file.*'))
+
+The columns are exposed as memoryviews over the file contents, so that loading is zero-copy. They can be wrapped
+without copies by numpy as well, e.g. `numpy.frombuffer(records.chunks[0]["t"], dtype=numpy.float64)`.
+"""
+
+import struct
+import sys
+
+_MAGIC = 0x43525352
+_VERSION = 1
+
+
+##
+# @brief The class used to load ROOT-Sim committed records files
+class RSRecords:
+    """
+    The `RSRecords` class loads ROOT-Sim committed records files.
+
+    Attributes:
+        record_size (int): The size in bytes of each record content.
+        chunks (List[Dict[str, memoryview]]): The chunks of records, each one a dictionary mapping the column names
+            "t", "lp", "data" and "type" to the column contents. The "data" column holds the raw record contents.
+    """
+
+    def _file_load(self, path):
+        with open(path, "rb") as f:
+            data = memoryview(f.read())
+
+        magic, version, _, _, record_size, _ = struct.unpack_from("=6I", data)
+        if magic != _MAGIC or version != _VERSION:
+            raise RuntimeError(f"{path} is not a ROOT-Sim records file in a supported format")
+        if self.record_size is not None and self.record_size != record_size:
+            raise RuntimeError(f"{path} has records of a different size")
+        self.record_size = record_size
+
+        idx = 24
+        while idx < len(data):
+            count = struct.unpack_from("=Q", data, idx)[0]
+            idx += 8
+            chunk = {}
+            for name, size in (("t", 8), ("lp", 8), ("data", record_size), ("type", 4)):
+                chunk[name] = data[idx:idx + count * size]
+                idx += count * size
+            chunk["t"] = chunk["t"].cast("d")
+            chunk["lp"] = chunk["lp"].cast("Q")
+            chunk["type"] = chunk["type"].cast("I")
+            self.chunks.append(chunk)
+            idx += -idx & 7
+
+    def __init__(self, paths):
+        self.record_size = None
+        self.chunks = []
+        for path in sorted(paths):
+            self._file_load(path)
+
+    ##
+    # @brief Iterate over the records
+    # @param fmt An optional struct format string used to unpack the records contents
+    # @return An iterator over (t, lp, type, content) tuples
+    def records(self, fmt=None):
+        """
+        Iterate over the records, in no particular order across LPs.
+
+        Parameters:
+            fmt (str): An optional struct format string used to unpack the records contents; if None the raw
+                contents are returned.
+
+        Returns:
+            Iterator[Tuple[float, int, int, Any]]: The (t, lp, type, content) tuples of the records.
+        """
+        for chunk in self.chunks:
+            data = chunk["data"]
+            for i in range(len(chunk["t"])):
+                content = data[i * self.record_size:(i + 1) * self.record_size]
+                if fmt is not None:
+                    content = struct.unpack(fmt, content)
+                yield chunk["t"][i], chunk["lp"][i], chunk["type"][i], content
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2:
+        print("Please, supply the path to the ROOT-Sim records files.", file=sys.stderr)
+        exit(-1)
+
+    recs = RSRecords(sys.argv[1:])
+    for rec in recs.records():
+        print(rec[0], rec[1], rec[2], rec[3].hex())
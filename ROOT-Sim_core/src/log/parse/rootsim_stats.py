@@ -54,17 +54,39 @@ class RSStats:
         ret = struct.unpack((">" if self.big_endian else "<") + ptrn, data_parse)
         return ret
 
-    def _metric_names_load(self):
-        metric_names = []
+    def _names_load(self):
+        names = []
         n_stats = self._pattern_unpack("q")[0]
         for _ in range(n_stats):
             raw_name_len = self._pattern_unpack("B")[0]
             raw_name = self._pattern_unpack(f"{raw_name_len}s")[0]
-            metric_name = raw_name.decode("utf-8").rstrip('\0')
-            metric_names.append(metric_name)
+            names.append(raw_name.decode("utf-8").rstrip('\0'))
+        return names
+
+    def _metric_names_load(self):
+        metric_names = self._names_load()
+        for metric_name in metric_names:
             self._metrics[metric_name] = []
         return metric_names
 
+    def _profile_unpack(self):
+        p_size = self._pattern_unpack("q")[0]
+        p_end = self._data_idx + p_size
+        rec_fmt = str(len(self._profile_metrics) + 1) + "Q"
+        ret = []
+        while self._data_idx < p_end:
+            l_cnt, m_cnt = self._pattern_unpack("2Q")
+            lps_recs = {}
+            for _ in range(l_cnt):
+                rec = self._pattern_unpack(rec_fmt)
+                lps_recs[rec[0]] = rec[1:]
+            msgs_recs = {}
+            for _ in range(m_cnt):
+                rec = self._pattern_unpack(rec_fmt)
+                msgs_recs[rec[0]] = rec[1:]
+            ret.append((lps_recs, msgs_recs))
+        return ret
+
     def _threads_unpack(self):
         metrics_len = len(self.metrics)
         n_stats = self._pattern_unpack("q")[0] // (metrics_len * 8)
@@ -89,7 +111,12 @@ class RSStats:
             for _ in range(n_threads):
                 threads_stats.append(self._threads_unpack())
 
+            threads_profiles = []
+            for _ in range(n_threads):
+                threads_profiles.append(self._profile_unpack())
+
             self.all_stats.append((glob_stats, node_stats, threads_stats))
+            self.all_profiles.append(threads_profiles)
 
     def _truncate_to_last_gvt(self):
         min_gvts = len(self.all_stats[0][1])
@@ -107,6 +134,8 @@ class RSStats:
             ret.append((glob_stats, t_node_stats, t_threads_stats))
 
         self.all_stats = ret
+        # profiles are empty if profiling was disabled or a thread failed to collect its records
+        self.all_profiles = [[t_prof[:min_gvts] for t_prof in n_profs] for n_profs in self.all_profiles]
 
     ##
     # @brief Construct a new RSStats object
@@ -125,9 +154,11 @@ class RSStats:
         self.big_endian = magic_number == 61455
         self._metrics = {}
         metric_names = self._metric_names_load()
+        self._profile_metrics = self._names_load()
 
         self.threads_count = []
         self.all_stats = []
+        self.all_profiles = []
         self._nodes_stats_load()
 
         if len(self._data) != self._data_idx:
@@ -300,6 +331,87 @@ class RSStats:
 
         return this_stats
 
+    ##
+    # @brief Get the profiling metric names
+    # @return a list containing the metric names that you can use in #lp_profile_get() and #msg_type_profile_get()
+    @property
+    def profile_metrics(self):
+        """
+        Get the profiling metric names.
+
+        Returns a list of the names of the metrics that can be used in the #lp_profile_get() and
+        #msg_type_profile_get() methods. The values are only available if profiling was enabled in the run.
+
+        Returns
+        -------
+            A list of strings representing the names of the available profiling metrics.
+        """
+        return list(self._profile_metrics)
+
+    def _profile_get(self, metric, rec_idx, aggregate_gvts):
+        if metric not in self._profile_metrics:
+            raise RuntimeError(f"Asked stats for the non-existing profile metric {metric}")
+
+        j = self._profile_metrics.index(metric)
+        ret = [{} for _ in self._gvts]
+        for n_profs in self.all_profiles:
+            for t_prof in n_profs:
+                for i, entry in enumerate(t_prof):
+                    for rec_id, rec in entry[rec_idx].items():
+                        if rec[j]:
+                            ret[i][rec_id] = ret[i].get(rec_id, 0) + rec[j]
+
+        if aggregate_gvts:
+            agg = {}
+            for gvt_stats in ret:
+                for rec_id, val in gvt_stats.items():
+                    agg[rec_id] = agg.get(rec_id, 0) + val
+            ret = agg
+
+        return ret
+
+    ##
+    # @brief Get the LP-specific profiling metric values
+    # @return a dictionary mapping LP ids to values, or a list of such dictionaries, one per GVT
+    def lp_profile_get(self, metric, aggregate_gvts=True):
+        """
+        Get the values of a profiling metric for each LP.
+
+        Parameters
+        ----------
+            metric: The name of the profiling metric, as listed by #profile_metrics.
+            aggregate_gvts: (optional) If True, sum the values over the whole run, otherwise provide the values for
+                each GVT period.
+
+        Returns
+        -------
+            A dictionary mapping the LP ids to the metric values, or a list of such dictionaries, one for each GVT.
+            LPs with a zero value in a period are omitted.
+        """
+        return self._profile_get(metric, 0, aggregate_gvts)
+
+    ##
+    # @brief Get the message type-specific profiling metric values
+    # @return a dictionary mapping message types to values, or a list of such dictionaries, one per GVT
+    def msg_type_profile_get(self, metric, aggregate_gvts=True):
+        """
+        Get the values of a profiling metric for each message type.
+
+        The "rollbacks" metric counts the rollbacks caused by the messages of each type.
+
+        Parameters
+        ----------
+            metric: The name of the profiling metric, as listed by #profile_metrics.
+            aggregate_gvts: (optional) If True, sum the values over the whole run, otherwise provide the values for
+                each GVT period.
+
+        Returns
+        -------
+            A dictionary mapping the message types to the metric values, or a list of such dictionaries, one for each
+            GVT. Message types with a zero value in a period are omitted.
+        """
+        return self._profile_get(metric, 1, aggregate_gvts)
+
 
 def format_size(num, is_binary=True):
     """Format a number of bytes into a human-readable string.
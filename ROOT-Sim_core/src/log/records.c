@@ -0,0 +1,267 @@
+/**
+ * @file log/records.c
+ *
+ * @brief Committed records module
+ *
+ * The records emitted by the model with CommitRecord() are buffered in the emitting LP, outside of the checkpointed
+ * memory. The records emitted by rolled back events are discarded, while the ones older than the GVT are committed,
+ * i.e. moved to the buffer of the thread writer, which periodically appends them to the thread records file. In the
+ * serial runtime records are committed right away.
+ *
+ * Each thread writes the file "<records_file>.<node id>.<thread id>", which starts with the header:
+ *
+ *     uint32_t magic, version, node id, thread id, record size, padding
+ *
+ * followed by a sequence of chunks, each one containing the records in columnar form:
+ *
+ *     uint64_t count
+ *     double t[count]
+ *     uint64_t lp_id[count]
+ *     uint8_t data[count][record size]
+ *     uint32_t type[count]
+ *     uint8_t padding[] (up to a multiple of 8 bytes)
+ *
+ * The records of a single LP appear in the file sorted by logical time. Every field is in the host byte order.
+ *
+ * SPDX-FileCopyrightText: 2008-2023 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#include <log/records.h>
+
+#include <log/file.h>
+#include <lp/lp.h>
+
+#include <string.h>
+
+/// The file to which the current thread appends its committed records
+static __thread FILE *records_f;
+/// The count of committed records waiting to be written to the file
+static __thread uint64_t chunk_cnt;
+/// The logical time column of the committed records
+static __thread simtime_t *chunk_t;
+/// The LP id column of the committed records
+static __thread uint64_t *chunk_lp;
+/// The contents column of the committed records
+static __thread unsigned char *chunk_data;
+/// The type column of the committed records
+static __thread uint32_t *chunk_type;
+
+/**
+ * @brief Initializes the committed records subsystem in the node
+ */
+void records_global_init(void)
+{
+	if(global_config.records_file == NULL)
+		return;
+
+	if(unlikely(!global_config.record_size)) {
+		logger(LOG_ERROR, "The records size has not been set, records won't be collected");
+		global_config.records_file = NULL;
+	}
+}
+
+/**
+ * @brief Initializes the committed records subsystem in the current thread
+ */
+void records_init(void)
+{
+	if(global_config.records_file == NULL)
+		return;
+
+	records_f = file_open("wb", "%s.%d.%u", global_config.records_file, nid, rid);
+	if(unlikely(records_f == NULL)) {
+		logger(LOG_FATAL, "Unable to open the records file %s.%d.%u", global_config.records_file, nid, rid);
+		abort();
+	}
+
+	uint32_t header[] = {RECORDS_MAGIC, RECORDS_VERSION, nid, rid, global_config.record_size, 0};
+	file_write_chunk(records_f, header, sizeof(header));
+
+	chunk_cnt = 0;
+	chunk_t = mm_alloc(RECORDS_CHUNK_ENTRIES * sizeof(*chunk_t));
+	chunk_lp = mm_alloc(RECORDS_CHUNK_ENTRIES * sizeof(*chunk_lp));
+	chunk_data = mm_alloc(RECORDS_CHUNK_ENTRIES * global_config.record_size);
+	chunk_type = mm_alloc(RECORDS_CHUNK_ENTRIES * sizeof(*chunk_type));
+}
+
+/**
+ * @brief Write the committed records of the current thread to its file
+ */
+static void records_chunk_write(void)
+{
+	static const uint64_t zero = 0;
+
+	if(!chunk_cnt)
+		return;
+
+	file_write_chunk(records_f, &chunk_cnt, sizeof(chunk_cnt));
+	file_write_chunk(records_f, chunk_t, chunk_cnt * sizeof(*chunk_t));
+	file_write_chunk(records_f, chunk_lp, chunk_cnt * sizeof(*chunk_lp));
+	file_write_chunk(records_f, chunk_data, chunk_cnt * global_config.record_size);
+	file_write_chunk(records_f, chunk_type, chunk_cnt * sizeof(*chunk_type));
+	size_t pad = -(chunk_cnt * (global_config.record_size + sizeof(*chunk_type))) & (sizeof(zero) - 1);
+	file_write_chunk(records_f, &zero, pad);
+	chunk_cnt = 0;
+}
+
+/**
+ * @brief Finalizes the committed records subsystem in the current thread
+ */
+void records_fini(void)
+{
+	if(records_f == NULL)
+		return;
+
+	records_chunk_write();
+	fclose(records_f);
+	records_f = NULL;
+
+	mm_free(chunk_type);
+	mm_free(chunk_data);
+	mm_free(chunk_lp);
+	mm_free(chunk_t);
+}
+
+/**
+ * @brief Commit a record in the current thread
+ * @param lp_id the id of the LP which emitted the record
+ * @param t the logical time at which the record has been emitted
+ * @param type the model-defined type of the record
+ * @param record a pointer to the record contents, global_config.record_size bytes long
+ */
+void records_write(lp_id_t lp_id, simtime_t t, unsigned type, const void *record)
+{
+	if(unlikely(records_f == NULL))
+		return;
+
+	chunk_t[chunk_cnt] = t;
+	chunk_lp[chunk_cnt] = lp_id;
+	memcpy(chunk_data + chunk_cnt * global_config.record_size, record, global_config.record_size);
+	chunk_type[chunk_cnt] = type;
+
+	if(unlikely(++chunk_cnt == RECORDS_CHUNK_ENTRIES))
+		records_chunk_write();
+}
+
+/**
+ * @brief Commit the oldest records buffered in a LP
+ * @param lp the LP whose records have to be committed
+ * @param n the number of records to commit
+ */
+static void records_lp_commit(struct lp_ctx *lp, array_count_t n)
+{
+	struct records_ctx *rec = &lp->rec;
+	if(!n)
+		return;
+
+	for(array_count_t i = 0; i < n; ++i) {
+		const struct record_meta *m = &array_get_at(rec->meta, i);
+		records_write(lp - lps, m->t, m->type, rec->data + i * global_config.record_size);
+	}
+
+	array_truncate_first(rec->meta, n);
+	memmove(rec->data, rec->data + n * global_config.record_size, array_count(rec->meta) * global_config.record_size);
+}
+
+/**
+ * @brief Commit the records of the thread-local LPs older than the GVT
+ * @param gvt the value of the freshly computed GVT
+ */
+void records_on_gvt(simtime_t gvt)
+{
+	if(global_config.records_file == NULL)
+		return;
+
+	for(uint64_t i = lid_thread_first; i < lid_thread_end; ++i) {
+		struct lp_ctx *lp = &lps[i];
+		array_count_t n = 0;
+		while(n < array_count(lp->rec.meta) && array_get_at(lp->rec.meta, n).t < gvt)
+			++n;
+		records_lp_commit(lp, n);
+	}
+}
+
+/**
+ * @brief Initializes the committed records buffer of a LP
+ * @param lp the LP to initialize
+ */
+void records_lp_init(struct lp_ctx *lp)
+{
+	if(global_config.records_file == NULL)
+		return;
+
+	array_init(lp->rec.meta);
+	lp->rec.data = mm_alloc(array_capacity(lp->rec.meta) * global_config.record_size);
+}
+
+/**
+ * @brief Finalizes the committed records buffer of a LP
+ * @param lp the LP to finalize
+ *
+ * The records still buffered are committed: they have been emitted by the events the final LP state derives from.
+ */
+void records_lp_fini(struct lp_ctx *lp)
+{
+	if(global_config.records_file == NULL)
+		return;
+
+	records_lp_commit(lp, array_count(lp->rec.meta));
+	mm_free(lp->rec.data);
+	array_fini(lp->rec.meta);
+}
+
+/**
+ * @brief Buffer a record emitted by a LP
+ * @param lp the LP which emitted the record
+ * @param t the logical time at which the record has been emitted
+ * @param type the model-defined type of the record
+ * @param record a pointer to the record contents, global_config.record_size bytes long
+ */
+void records_lp_push(struct lp_ctx *lp, simtime_t t, unsigned type, const void *record)
+{
+	struct records_ctx *rec = &lp->rec;
+	array_count_t cap = array_capacity(rec->meta);
+	array_push(rec->meta, ((struct record_meta){.t = t, .p_i = array_count(lp->p.p_msgs), .type = type}));
+	if(unlikely(cap != array_capacity(rec->meta)))
+		rec->data = mm_realloc(rec->data, array_capacity(rec->meta) * global_config.record_size);
+
+	memcpy(rec->data + (array_count(rec->meta) - 1) * global_config.record_size, record, global_config.record_size);
+}
+
+/**
+ * @brief Discard the records emitted by rolled back events
+ * @param lp the LP which is being rolled back
+ * @param past_i the index in the processed messages array of the first rolled back message
+ *
+ * The records of an event are pushed with an index which lies between the index of the first message sent by the
+ * event and the index of the processed message itself, therefore they are all either discarded or retained.
+ */
+void records_lp_rollback(struct lp_ctx *lp, array_count_t past_i)
+{
+	if(global_config.records_file == NULL)
+		return;
+
+	while(!array_is_empty(lp->rec.meta) && array_peek(lp->rec.meta).p_i >= past_i)
+		--array_count(lp->rec.meta);
+}
+
+/**
+ * @brief Update the records of a LP after some processed messages have been fossil collected
+ * @param lp the LP which is being fossil collected
+ * @param past_i the count of fossil collected messages
+ *
+ * The records emitted by fossil collected events are committed, even if they've been left behind by records_on_gvt().
+ */
+void records_lp_fossil(struct lp_ctx *lp, array_count_t past_i)
+{
+	if(global_config.records_file == NULL)
+		return;
+
+	array_count_t n = 0;
+	while(n < array_count(lp->rec.meta) && array_get_at(lp->rec.meta, n).p_i < past_i)
+		++n;
+	records_lp_commit(lp, n);
+
+	for(array_count_t i = 0; i < array_count(lp->rec.meta); ++i)
+		array_get_at(lp->rec.meta, i).p_i -= past_i;
+}
@@ -0,0 +1,53 @@
+/**
+ * @file log/records.h
+ *
+ * @brief Committed records module
+ *
+ * The module which buffers the records emitted by the model with CommitRecord() until they are committed
+ *
+ * SPDX-FileCopyrightText: 2008-2023 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#pragma once
+
+#include <core/core.h>
+#include <datatypes/array.h>
+
+/// The magic number at the beginning of a records file, "RSRC" in little endian hosts
+#define RECORDS_MAGIC 0x43525352U
+/// The version of the records file format
+#define RECORDS_VERSION 1U
+/// The number of records collected by a thread before writing them to its file
+#define RECORDS_CHUNK_ENTRIES 4096U
+
+/// The metadata of a record buffered in a LP
+struct record_meta {
+	/// The logical time at which the record has been emitted
+	simtime_t t;
+	/// The count of processed messages of the LP when the record has been emitted
+	array_count_t p_i;
+	/// The model-defined type of the record
+	unsigned type;
+};
+
+/// The records buffered in a LP while they may still be rolled back
+struct records_ctx {
+	/// The metadata of the buffered records, in emission order
+	dyn_array(struct record_meta) meta;
+	/// The contents of the buffered records, each one global_config.record_size bytes long
+	unsigned char *data;
+};
+
+struct lp_ctx; // forward declaration
+
+extern void records_global_init(void);
+extern void records_init(void);
+extern void records_fini(void);
+extern void records_on_gvt(simtime_t gvt);
+
+extern void records_lp_init(struct lp_ctx *lp);
+extern void records_lp_fini(struct lp_ctx *lp);
+extern void records_lp_push(struct lp_ctx *lp, simtime_t t, unsigned type, const void *record);
+extern void records_lp_rollback(struct lp_ctx *lp, array_count_t past_i);
+extern void records_lp_fossil(struct lp_ctx *lp, array_count_t past_i);
+extern void records_write(lp_id_t lp_id, simtime_t t, unsigned type, const void *record);
@@ -15,6 +15,8 @@
 #include <arch/timer.h>
 #include <distributed/mpi.h>
 #include <log/file.h>
+#include <log/telemetry.h>
+#include <lp/lp.h>
 #include <mm/mm.h>
 
 #include <assert.h>
@@ -50,8 +52,17 @@ struct stats_global {
 	uint64_t timestamps[STATS_GLOBAL_COUNT];
 };
 
+/// A profiling record of a LP or of a message type, as written in the statistics file
+struct stats_profile_record {
+	/// The id of the LP or the message type
+	uint64_t id;
+	/// The profiling counters
+	struct stats_profile p;
+};
+
 static_assert(sizeof(struct stats_thread) == 8 * STATS_COUNT && sizeof(struct stats_node) == 16 &&
-		  sizeof(struct stats_global) == 24 + 8 * (STATS_GLOBAL_COUNT),
+		  sizeof(struct stats_global) == 24 + 8 * (STATS_GLOBAL_COUNT) &&
+		  sizeof(struct stats_profile_record) == 8 + 8 * STATS_PROFILE_COUNT,
     "structs aren't properly packed, parsing may be difficult");
 
 /// The statistics names, used to fill in the preamble of the final statistics binary file
@@ -70,6 +81,15 @@ const char *const stats_names[] = {
     [STATS_REAL_TIME_GVT] = "gvt real time"
 };
 
+/// The profiling statistics names, used to fill in the preamble of the final statistics binary file
+const char *const stats_profile_names[] = {
+    [STATS_PROFILE_MSG_PROCESSED] = "processed messages",
+    [STATS_PROFILE_MSG_PROCESSED_TIME] = "processed messages time",
+    [STATS_PROFILE_ROLLBACK] = "rollbacks",
+    [STATS_PROFILE_MSG_ROLLBACK] = "rolled back messages",
+    [STATS_PROFILE_CKPT_SIZE] = "checkpoints size"
+};
+
 /// The first timestamp ever collected for this simulation run
 static timer_uint sim_start_ts;
 /// The first high resolution timestamp of this simulation run: used to correlate high resolution and wall clock timers
@@ -82,6 +102,12 @@ static FILE *stats_node_tmp;
 static FILE **stats_tmps;
 /// The current values of thread statistics for this logical time period (from the previous GVT to the next one)
 static __thread struct stats_thread stats_cur;
+/// The current profiling values of the LPs for this logical time period, NULL if profiling is disabled
+struct stats_profile *stats_lps_profile;
+/// The current profiling values of the message types processed by this thread for this logical time period
+__thread struct stats_profile stats_msgs_profile[STATS_PROFILE_MSG_TYPES];
+/// An array of pointers to the temporary files used to save the profiling records produced by threads
+static FILE **stats_profile_tmps;
 
 /**
  * @brief Take a lifetime event time value
@@ -100,6 +126,8 @@ void stats_global_init(void)
 	sim_start_ts = timer_new();
 	sim_start_ts_hr = timer_hr_new();
 
+	telemetry_global_init();
+
 	if(global_config.stats_file == NULL)
 		return;
 
@@ -115,6 +143,13 @@ void stats_global_init(void)
 	if(mem_stat_setup() < 0)
 		logger(LOG_ERROR, "Unable to extract memory statistics!");
 	stats_tmps = mm_alloc(global_config.n_threads * sizeof(*stats_tmps));
+
+	if(!global_config.stats_profile)
+		return;
+
+	stats_profile_tmps = mm_alloc(global_config.n_threads * sizeof(*stats_profile_tmps));
+	stats_lps_profile = mm_alloc(global_config.lps * sizeof(*stats_lps_profile));
+	memset(stats_lps_profile, 0, global_config.lps * sizeof(*stats_lps_profile));
 }
 
 /**
@@ -122,6 +157,9 @@ void stats_global_init(void)
  */
 void stats_init(void)
 {
+	// The serial runtime uses the calling thread, which may have run previous simulations
+	memset(&stats_cur, 0, sizeof(stats_cur));
+
 	if(global_config.stats_file == NULL)
 		return;
 
@@ -133,6 +171,13 @@ void stats_init(void)
 	}
 
 	setvbuf(stats_tmps[rid], NULL, _IOFBF, STATS_BUFFER_ENTRIES * sizeof(stats_cur));
+
+	if(stats_lps_profile == NULL)
+		return;
+
+	stats_profile_tmps[rid] = io_file_tmp_get();
+	if(unlikely(stats_profile_tmps[rid] == NULL))
+		logger(LOG_ERROR, "Unable to open a temporary file, profiling statistics won't be collected");
 }
 
 /**
@@ -149,7 +194,7 @@ static void stats_files_receive(FILE *out_f)
 		struct stats_global *sg_p = mpi_blocking_data_rcv(&buf_size, j);
 		if(likely(out_f != NULL))
 			file_write_chunk(out_f, sg_p, buf_size);
-		uint64_t iters = sg_p->threads_count + 1; // +1 for node stats
+		uint64_t iters = 2 * sg_p->threads_count + 1; // +1 for node stats, twice for thread and profiling stats
 		mm_free(sg_p);
 
 		for(uint64_t i = 0; i < iters; ++i) {
@@ -164,6 +209,23 @@ static void stats_files_receive(FILE *out_f)
 	}
 }
 
+/**
+ * @brief Load in memory the profiling records produced by a thread
+ * @param i the id of the thread
+ * @param[out] f_size_p a pointer to the variable to fill with the size in bytes of the returned buffer
+ * @return a buffer with the profiling records of the thread, to be freed with mm_free()
+ *
+ * If profiling is disabled, or the thread could not collect its records, the returned buffer is empty.
+ */
+static void *stats_profile_load(rid_t i, int64_t *f_size_p)
+{
+	if(stats_lps_profile == NULL || stats_profile_tmps[i] == NULL) {
+		*f_size_p = 0;
+		return mm_alloc(1);
+	}
+	return file_memory_load(stats_profile_tmps[i], f_size_p);
+}
+
 /**
  * @brief Send the final statistics data of this node to the master node
  */
@@ -186,6 +248,13 @@ static void stats_files_send(void)
 		mpi_blocking_data_send(f_buf, f_size, 0);
 		mm_free(f_buf);
 	}
+
+	for(rid_t i = 0; i < global_config.n_threads; ++i) {
+		f_buf = stats_profile_load(i, &f_size);
+		f_size = min(INT_MAX, f_size);
+		mpi_blocking_data_send(f_buf, f_size, 0);
+		mm_free(f_buf);
+	}
 }
 
 /**
@@ -207,6 +276,8 @@ static void stats_files_send(void)
  * | 1          | 2    | uint             | --    | Magic number used to detect the endianness of the machine          |
  * | 1          | 8    | int              | s_cnt | Count of available thread metrics                                  |
  * | s_cnt      | *    | Pascal string    | --    | Names of the thread metrics                                        |
+ * | 1          | 8    | int              | p_cnt | Count of available profiling metrics                               |
+ * | p_cnt      | *    | Pascal string    | --    | Names of the profiling metrics                                     |
  * | 1          | 8    | int              | n_cnt | Count of MPI ranks (1 in the case of a single node run)            |
  * | n_cnt      | *    | Node stats       | --    | The statistics produced by the nodes                               |
  *
@@ -226,6 +297,7 @@ static void stats_files_send(void)
  * | 1          | 8    | int              | n_siz | Size of the node GVT stats array                                   |
  * | n_siz / 16 | 16   | Node GVT entry   | --    | The node-wide statistics produced at each GVT by this node         |
  * | t_cnt      | *    | Thread GVT stats | --    | The statistics produced by each thread on this node                |
+ * | t_cnt      | *    | Profile stats    | --    | The profiling statistics produced by each thread on this node      |
  *
  * Node GVT entry:
  * | Count      | Size | Type             | Ref   | Description                                                        |
@@ -244,9 +316,30 @@ static void stats_files_send(void)
  * |:---------- |:---- |:----- |:----- | :---------------------------------------------------------------------------- |
  * | s_cnt      | 8    | uint  | --    | The values of the stats described in the Preamble for this GVT and thread     |
  *
+ * Profile stats:
+ * | Count      | Size | Type             | Ref   | Description                                                        |
+ * |:---------- |:---- |:---------------- |:----- | :----------------------------------------------------------------- |
+ * | 1          | 8    | int              | p_siz | Size in bytes of this thread's profiling records (0 if disabled)   |
+ * | *          | *    | Profile GVT entry | --   | The profiling records produced at each GVT by this thread          |
+ *
+ * Profile GVT entry:
+ * | Count      | Size    | Type           | Ref   | Description                                                     |
+ * |:---------- |:------- |:-------------- |:----- | :-------------------------------------------------------------- |
+ * | 1          | 8       | uint           | l_cnt | Count of LP records                                             |
+ * | 1          | 8       | uint           | m_cnt | Count of message type records                                   |
+ * | l_cnt      | p_cnt*8+8 | Profile record | --  | The records of the LPs active in this GVT period                |
+ * | m_cnt      | p_cnt*8+8 | Profile record | --  | The records of the message types processed in this GVT period   |
+ *
+ * Profile record:
+ * | Count      | Size | Type  | Ref   | Description                                                                   |
+ * |:---------- |:---- |:----- |:----- | :---------------------------------------------------------------------------- |
+ * | 1          | 8    | uint  | --    | The LP id or the message type (the slot id for message types beyond the slots)|
+ * | p_cnt      | 8    | uint  | --    | The values of the profiling metrics described in the Preamble                 |
+ *
  * In a correctly completed simulation n_siz / 16 == t_siz / (s_cnt * 8) for each node and thread (this is the number of
- * committed GVTs). This function only writes the Node stats for the current node (the master node in a MPI run). The
- * function #stats_files_receive() deals with the other nodes.
+ * committed GVTs). If profiling is enabled, each thread also produces a Profile GVT entry per committed GVT. This
+ * function only writes the Node stats for the current node (the master node in a MPI run). The function
+ * #stats_files_receive() deals with the other nodes.
  * TODO add to the file other kind of statistics, for example ROOT-Sim config, machine hardware etc
  */
 static void stats_file_final_write(FILE *out_f)
@@ -262,6 +355,14 @@ static void stats_file_final_write(FILE *out_f)
 		file_write_chunk(out_f, stats_names[i], l);
 	}
 
+	n = STATS_PROFILE_COUNT;
+	file_write_chunk(out_f, &n, sizeof(n));
+	for(int i = 0; i < STATS_PROFILE_COUNT; ++i) {
+		unsigned char l = strnlen(stats_profile_names[i], UCHAR_MAX);
+		file_write_chunk(out_f, &l, 1);
+		file_write_chunk(out_f, stats_profile_names[i], l);
+	}
+
 	n = n_nodes;
 	file_write_chunk(out_f, &n, sizeof(n));
 
@@ -282,6 +383,13 @@ static void stats_file_final_write(FILE *out_f)
 		file_write_chunk(out_f, buf, buf_size);
 		mm_free(buf);
 	}
+
+	for(rid_t i = 0; i < global_config.n_threads; ++i) {
+		buf = stats_profile_load(i, &buf_size);
+		file_write_chunk(out_f, &buf_size, sizeof(buf_size));
+		file_write_chunk(out_f, buf, buf_size);
+		mm_free(buf);
+	}
 }
 
 /**
@@ -292,6 +400,8 @@ static void stats_file_final_write(FILE *out_f)
  */
 void stats_global_fini(void)
 {
+	telemetry_global_fini();
+
 	if(global_config.stats_file == NULL)
 		return;
 
@@ -317,6 +427,17 @@ void stats_global_fini(void)
 
 	mm_free(stats_tmps);
 	fclose(stats_node_tmp);
+
+	if(stats_lps_profile == NULL)
+		return;
+
+	for(rid_t i = 0; i < global_config.n_threads; ++i)
+		if(stats_profile_tmps[i] != NULL)
+			fclose(stats_profile_tmps[i]);
+
+	mm_free(stats_profile_tmps);
+	mm_free(stats_lps_profile);
+	stats_lps_profile = NULL;
 }
 
 /**
@@ -330,6 +451,61 @@ void stats_take(enum stats_thread_type this_stat, uint_fast64_t c)
 	stats_cur.s[this_stat] += c;
 }
 
+/**
+ * @brief Check if a profiling counters container holds some sample
+ * @param prof a pointer to the profiling counters container
+ * @return true if at least one of the profiling counters is non-zero, false otherwise
+ */
+static inline bool stats_profile_is_active(const struct stats_profile *prof)
+{
+	for(unsigned i = 0; i < STATS_PROFILE_COUNT; ++i)
+		if(prof->s[i])
+			return true;
+	return false;
+}
+
+/**
+ * @brief Write a profiling record and reset the related counters
+ * @param out_f the file where to write the record
+ * @param id the id of the LP or message type
+ * @param prof a pointer to the profiling counters container
+ */
+static void stats_profile_record_write(FILE *out_f, uint64_t id, struct stats_profile *prof)
+{
+	struct stats_profile_record rec = {.id = id, .p = *prof};
+	file_write_chunk(out_f, &rec, sizeof(rec));
+	memset(prof, 0, sizeof(*prof));
+}
+
+/**
+ * @brief Dump the profiling records of the current thread for the last logical time period
+ * @param out_f the temporary file of the current thread where to write the records
+ *
+ * Only the LPs and the message types with some activity since the last GVT are dumped, in order to keep the overhead
+ * proportional to the amount of simulation work carried out.
+ */
+static void stats_profile_on_gvt(FILE *out_f)
+{
+	uint64_t cnt[2] = {0, 0};
+	for(uint64_t i = lid_thread_first; i < lid_thread_end; ++i)
+		cnt[0] += stats_profile_is_active(&stats_lps_profile[i]);
+	for(unsigned i = 0; i < STATS_PROFILE_MSG_TYPES; ++i)
+		cnt[1] += stats_profile_is_active(&stats_msgs_profile[i]);
+
+	file_write_chunk(out_f, cnt, sizeof(cnt));
+
+	for(uint64_t i = lid_thread_first; i < lid_thread_end; ++i)
+		if(stats_profile_is_active(&stats_lps_profile[i]))
+			stats_profile_record_write(out_f, i, &stats_lps_profile[i]);
+
+	for(unsigned i = 0; i < STATS_PROFILE_MSG_TYPES; ++i) {
+		if(!stats_profile_is_active(&stats_msgs_profile[i]))
+			continue;
+		uint64_t m_type = i < STATS_PROFILE_MSG_TYPES - 3 ? i : (uint64_t)LP_FINI - (STATS_PROFILE_MSG_TYPES - 1 - i);
+		stats_profile_record_write(out_f, m_type, &stats_msgs_profile[i]);
+	}
+}
+
 /**
  * @brief Perform GVT related activities for the statistics subsystem
  *
@@ -349,6 +525,12 @@ void stats_on_gvt(simtime_t gvt)
 		fflush(stdout);
 	}
 
+	if(global_config.telemetry_endpoint != NULL) {
+		telemetry_on_gvt(gvt);
+		if(global_config.stats_file == NULL)
+			memset(&stats_cur, 0, sizeof(stats_cur));
+	}
+
 	if(global_config.stats_file == NULL)
 		return;
 
@@ -357,6 +539,9 @@ void stats_on_gvt(simtime_t gvt)
 	file_write_chunk(stats_tmps[rid], &stats_cur, sizeof(stats_cur));
 	memset(&stats_cur, 0, sizeof(stats_cur));
 
+	if(unlikely(stats_lps_profile != NULL) && stats_profile_tmps[rid] != NULL)
+		stats_profile_on_gvt(stats_profile_tmps[rid]);
+
 	if(rid != 0)
 		return;
 
@@ -61,6 +61,70 @@ enum stats_thread_type {
 	STATS_COUNT
 };
 
+/// The kind of profiling samples collected for each LP and for each message type during a simulation run
+/** Time samples are collected using high resolution timers */
+enum stats_profile_type {
+	/// The count of processed messages
+	STATS_PROFILE_MSG_PROCESSED,
+	/// The time spent inside the model dispatcher function
+	STATS_PROFILE_MSG_PROCESSED_TIME,
+	/// The count of rollbacks: suffered for LPs, caused by stragglers and anti-messages for message types
+	STATS_PROFILE_ROLLBACK,
+	/// The count of rollbacked messages
+	STATS_PROFILE_MSG_ROLLBACK,
+	/// The size of the taken checkpoints (collected for LPs only)
+	STATS_PROFILE_CKPT_SIZE,
+	/// Used to count the members of this enum
+	STATS_PROFILE_COUNT
+};
+
+/// The number of message types separately profiled
+/** The last three slots are reserved to the LP_RETRACTABLE, LP_INIT and LP_FINI events; the one before them gathers all
+ * the model message types which don't fit in the preceding slots */
+#define STATS_PROFILE_MSG_TYPES 256U
+
+/**
+ * @brief Compute the profiling slot of a message type
+ * @param m_type the message type
+ * @return the index of the slot for @p m_type in #stats_msgs_profile
+ */
+#define stats_profile_msg_index(m_type)                                                                                \
+	((m_type) >= LP_RETRACTABLE ? STATS_PROFILE_MSG_TYPES - 1 - (LP_FINI - (m_type))                               \
+				    : min((m_type), STATS_PROFILE_MSG_TYPES - 4))
+
+/// A container for the profiling counters of a LP or of a message type in a logical time period
+struct stats_profile {
+	/// The array of profiling samples taken in the period
+	uint64_t s[STATS_PROFILE_COUNT];
+};
+
+extern struct stats_profile *stats_lps_profile;
+extern __thread struct stats_profile stats_msgs_profile[STATS_PROFILE_MSG_TYPES];
+
+/**
+ * @brief Sum a sample to a profiling value of a LP, if profiling is enabled
+ * @param lid the id of the profiled LP
+ * @param this_stat the profiling type to add the sample to
+ * @param c the sample to sum
+ */
+#define stats_profile_lp_take(lid, this_stat, c)                                                                       \
+	do {                                                                                                           \
+		if(unlikely(stats_lps_profile != NULL))                                                                \
+			stats_lps_profile[lid].s[this_stat] += (c);                                                    \
+	} while(0)
+
+/**
+ * @brief Sum a sample to a profiling value of a message type, if profiling is enabled
+ * @param m_type the profiled message type
+ * @param this_stat the profiling type to add the sample to
+ * @param c the sample to sum
+ */
+#define stats_profile_msg_take(m_type, this_stat, c)                                                                   \
+	do {                                                                                                           \
+		if(unlikely(stats_lps_profile != NULL))                                                                \
+			stats_msgs_profile[stats_profile_msg_index(m_type)].s[this_stat] += (c);                       \
+	} while(0)
+
 extern void stats_global_time_take(enum stats_global_type this_stat);
 
 extern void stats_global_init(void);
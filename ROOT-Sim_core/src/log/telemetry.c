@@ -0,0 +1,138 @@
+/**
+ * @file log/telemetry.c
+ *
+ * @brief Live telemetry module
+ *
+ * At each GVT, each thread appends a line with its recent activity to the telemetry endpoint, and the master thread of
+ * each node appends a line with the node progress. The lines follow the InfluxDB line protocol:
+ *
+ *     rootsim_node,node=<nid> gvt=<gvt>,gvt_rate=<gvt advancement per second>,rss=<resident set in bytes>u <time>
+ *     rootsim_thread,node=<nid>,thread=<rid> gvt=<gvt>,events=<count>u,events_rate=<events per second>,
+ *         rollbacks=<count>u,rolled_back=<count>u,rollback_ratio=<rolled_back / events>,idle_ratio=<ratio> <time>
+ *
+ * where <time> is the wall clock time in nanoseconds since the epoch. The thread idle ratio is the fraction of the GVT
+ * period not spent in processing, rollback recovery or checkpointing activities. Each line is written with a single
+ * non-blocking system call; if the endpoint can't keep up, lines are dropped rather than slowing down the simulation.
+ *
+ * SPDX-FileCopyrightText: 2008-2023 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#include <log/telemetry.h>
+
+#include <arch/io.h>
+#include <arch/mem.h>
+#include <arch/timer.h>
+#include <log/log.h>
+#include <log/stats.h>
+
+#include <inttypes.h>
+#include <time.h>
+
+/// The descriptor of the telemetry endpoint
+static int telemetry_endpoint;
+/// The wall clock timestamp of the previous GVT
+static __thread timer_uint last_ts;
+/// The high resolution timestamp of the previous GVT
+static __thread timer_uint last_hr_ts;
+/// The value of the previous GVT
+static __thread simtime_t last_gvt;
+
+/**
+ * @brief Initializes the telemetry subsystem in the node
+ */
+void telemetry_global_init(void)
+{
+	// The serial runtime uses the calling thread, which may have run previous simulations
+	last_ts = 0;
+
+	if(global_config.telemetry_endpoint == NULL)
+		return;
+
+	telemetry_endpoint = io_endpoint_open(global_config.telemetry_endpoint);
+	if(unlikely(telemetry_endpoint == -1)) {
+		logger(LOG_ERROR, "Unable to open the telemetry endpoint \"%s\", telemetry is disabled",
+		    global_config.telemetry_endpoint);
+		global_config.telemetry_endpoint = NULL;
+		return;
+	}
+
+	// If statistics are enabled or the memory governor is active, the facilities have already been set up
+	if(global_config.stats_file == NULL && !global_config.mem_budget && mem_stat_setup() < 0)
+		logger(LOG_ERROR, "Unable to extract memory statistics!");
+}
+
+/**
+ * @brief Finalizes the telemetry subsystem in the node
+ */
+void telemetry_global_fini(void)
+{
+	if(global_config.telemetry_endpoint == NULL)
+		return;
+
+	io_endpoint_close(telemetry_endpoint);
+}
+
+/**
+ * @brief Get the current wall clock time
+ * @return the nanoseconds elapsed since the epoch
+ */
+static uint64_t telemetry_time_get(void)
+{
+	struct timespec ts;
+	if(unlikely(!timespec_get(&ts, TIME_UTC)))
+		return 0;
+	return (uint64_t)ts.tv_sec * 1000000000U + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Write the telemetry lines of the current thread for the last GVT period
+ * @param gvt the time value of the current GVT
+ *
+ * This must be called before the thread statistics are reset for the next GVT period.
+ */
+void telemetry_on_gvt(simtime_t gvt)
+{
+	// The GVT of a terminated simulation doesn't fit in a line, and reports no progress anyway
+	if(unlikely(gvt == SIMTIME_MAX))
+		return;
+
+	timer_uint ts = timer_new();
+	timer_uint hr_ts = timer_hr_new();
+	if(unlikely(last_ts == 0)) {
+		last_ts = ts;
+		last_hr_ts = hr_ts;
+		last_gvt = gvt;
+		return;
+	}
+
+	double elapsed = (double)(ts - last_ts) / 1000000.0;
+	double hr_elapsed = (double)(hr_ts - last_hr_ts);
+	last_ts = ts;
+	last_hr_ts = hr_ts;
+	if(unlikely(elapsed <= 0.0))
+		return;
+
+	uint64_t events = stats_retrieve(STATS_MSG_PROCESSED);
+	uint64_t rolled_back = stats_retrieve(STATS_MSG_ROLLBACK);
+	uint64_t busy = stats_retrieve(STATS_MSG_PROCESSED_TIME) + stats_retrieve(STATS_RECOVERY_TIME) +
+	                stats_retrieve(STATS_CKPT_TIME) + stats_retrieve(STATS_MSG_SILENT_TIME);
+	double idle_ratio = hr_elapsed > busy ? 1.0 - busy / hr_elapsed : 0.0;
+	uint64_t now = telemetry_time_get();
+
+	char line[TELEMETRY_LINE_MAX];
+	int l = snprintf(line, sizeof(line),
+	    "rootsim_thread,node=%d,thread=%u gvt=%lf,events=%" PRIu64 "u,events_rate=%lf,rollbacks=%" PRIu64
+	    "u,rolled_back=%" PRIu64 "u,rollback_ratio=%lf,idle_ratio=%lf %" PRIu64 "\n",
+	    nid, rid, gvt, events, events / elapsed, stats_retrieve(STATS_ROLLBACK), rolled_back,
+	    events ? (double)rolled_back / events : 0.0, idle_ratio, now);
+
+	if(!rid) {
+		l = min(l, (int)sizeof(line) - 1);
+		l += snprintf(line + l, sizeof(line) - l,
+		    "rootsim_node,node=%d gvt=%lf,gvt_rate=%lf,rss=%zuu %" PRIu64 "\n", nid, gvt,
+		    (gvt - last_gvt) / elapsed, mem_stat_rss_current_get(), now);
+	}
+	last_gvt = gvt;
+
+	io_endpoint_write(telemetry_endpoint, line, min(l, (int)sizeof(line) - 1));
+}
@@ -0,0 +1,20 @@
+/**
+ * @file log/telemetry.h
+ *
+ * @brief Live telemetry module
+ *
+ * The module which streams the simulation progress to an external monitor at each GVT
+ *
+ * SPDX-FileCopyrightText: 2008-2023 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#pragma once
+
+#include <core/core.h>
+
+/// The maximum length of a telemetry line, longer lines are truncated
+#define TELEMETRY_LINE_MAX 512
+
+extern void telemetry_global_init(void);
+extern void telemetry_global_fini(void);
+extern void telemetry_on_gvt(simtime_t gvt);
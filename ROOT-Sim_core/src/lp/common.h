@@ -18,6 +18,11 @@ static inline void common_msg_process(const struct lp_ctx *lp, const struct lp_m
 {
 	timer_uint t = timer_hr_new();
 	global_config.dispatcher(msg->dest, msg->dest_t, msg->m_type, msg->pl, msg->pl_size, lp->state_pointer);
-	stats_take(STATS_MSG_PROCESSED_TIME, timer_hr_value(t));
+	t = timer_hr_value(t);
+	stats_take(STATS_MSG_PROCESSED_TIME, t);
 	stats_take(STATS_MSG_PROCESSED, 1);
+	stats_profile_lp_take(msg->dest, STATS_PROFILE_MSG_PROCESSED_TIME, t);
+	stats_profile_lp_take(msg->dest, STATS_PROFILE_MSG_PROCESSED, 1);
+	stats_profile_msg_take(msg->m_type, STATS_PROFILE_MSG_PROCESSED_TIME, t);
+	stats_profile_msg_take(msg->m_type, STATS_PROFILE_MSG_PROCESSED, 1);
 }
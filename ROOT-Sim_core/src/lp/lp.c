@@ -99,6 +99,7 @@ void lp_init(void)
 
 		current_lp = lp;
 
+		records_lp_init(lp);
 		retractable_lib_lp_init(lp);
 		auto_ckpt_lp_init(&lp->auto_ckpt);
 		process_lp_init(lp);
@@ -115,12 +116,26 @@ void lp_fini(void)
 		struct lp_ctx *lp = &lps[i];
 
 		process_lp_fini(lp);
+		records_lp_fini(lp);
 		model_allocator_lp_fini(&lp->mm_state);
 	}
 
 	current_lp = NULL;
 }
 
+/**
+ * @brief Notify the LPs hosted in the calling thread of a new GVT
+ * @param gvt The freshly computed GVT
+ */
+void lp_on_gvt(simtime_t gvt)
+{
+	if(global_config.on_gvt == NULL)
+		return;
+
+	for(uint64_t i = lid_thread_first; i < lid_thread_end; ++i)
+		global_config.on_gvt(i, gvt, lps[i].state_pointer);
+}
+
 /**
  * @brief Set the LP simulation state main pointer
  * @param state The state pointer to be passed to ProcessEvent() for the invoker LP
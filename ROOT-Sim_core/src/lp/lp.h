@@ -12,6 +12,7 @@
 
 #include <arch/platform.h>
 #include <core/core.h>
+#include <log/records.h>
 #include <lp/msg.h>
 #include <lp/process.h>
 #include <mm/auto_ckpt.h>
@@ -35,6 +36,8 @@ struct lp_ctx {
 	struct process_ctx p;
 	/// The memory allocator state of this LP
 	struct mm_state mm_state;
+	/// The committed records buffer of this LP
+	struct records_ctx rec;
 };
 
 /**
@@ -63,8 +66,10 @@ extern struct lp_ctx *lps;
 #ifndef NDEBUG
 extern bool lp_initialized;
 #define lp_initialized_set() (lp_initialized = true)
+#define lp_initialized_reset() (lp_initialized = false)
 #else
 #define lp_initialized_set()
+#define lp_initialized_reset()
 #endif
 
 extern void lp_global_init(void);
@@ -72,3 +77,4 @@ extern void lp_global_fini(void);
 
 extern void lp_init(void);
 extern void lp_fini(void);
+extern void lp_on_gvt(simtime_t gvt);
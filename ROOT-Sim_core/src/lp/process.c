@@ -16,6 +16,7 @@
 #include <gvt/fossil.h>
 #include <gvt/gvt.h>
 #include <lib/retractable/retractable.h>
+#include <log/records.h>
 #include <log/stats.h>
 #include <lp/common.h>
 #include <lp/lp.h>
@@ -39,6 +40,10 @@ static __thread struct lp_msg *current_msg;
 void ScheduleNewEvent(lp_id_t receiver, simtime_t timestamp, unsigned event_type, const void *payload,
     unsigned payload_size)
 {
+	// events past the termination time would never be committed: they are not even inserted in the queues
+	if(unlikely(timestamp > global_config.termination_time))
+		return;
+
 	if(unlikely(global_config.serial)) {
 		ScheduleNewEvent_serial(receiver, timestamp, event_type, payload, payload_size);
 		return;
@@ -70,6 +75,22 @@ void ScheduleNewEvent(lp_id_t receiver, simtime_t timestamp, unsigned event_type
 	}
 }
 
+void CommitRecord(simtime_t now, unsigned record_type, const void *record)
+{
+	if(unlikely(global_config.records_file == NULL))
+		return;
+
+	if(unlikely(global_config.serial)) {
+		records_write(current_lp - lps, now, record_type, record);
+		return;
+	}
+
+	if(unlikely(silent_processing))
+		return;
+
+	records_lp_push(current_lp, now, record_type, record);
+}
+
 /**
  * @brief Take a checkpoint of the state of a LP
  * @param lp the LP to checkpoint
@@ -79,9 +100,10 @@ void ScheduleNewEvent(lp_id_t receiver, simtime_t timestamp, unsigned event_type
 static inline void checkpoint_take(struct lp_ctx *lp)
 {
 	timer_uint t = timer_hr_new();
-	model_allocator_checkpoint_take(&lp->mm_state, array_count(lp->p.p_msgs));
-	stats_take(STATS_CKPT_SIZE, lp->mm_state.full_ckpt_size);
+	uint_fast32_t ckpt_size = model_allocator_checkpoint_take(&lp->mm_state, array_count(lp->p.p_msgs));
+	stats_take(STATS_CKPT_SIZE, ckpt_size);
 	stats_take(STATS_CKPT, 1);
+	stats_profile_lp_take(lp - lps, STATS_PROFILE_CKPT_SIZE, ckpt_size);
 	stats_take(STATS_CKPT_TIME, timer_hr_value(t));
 }
 
@@ -190,6 +212,8 @@ static inline void send_anti_messages(struct process_ctx *proc_p, array_count_t
 			msg = array_get_at(proc_p->p_msgs, ++i);
 		}
 
+		stats_profile_lp_take(msg->dest, STATS_PROFILE_MSG_ROLLBACK, 1);
+		stats_profile_msg_take(msg->m_type, STATS_PROFILE_MSG_ROLLBACK, 1);
 		uint32_t f = atomic_fetch_add_explicit(&msg->flags, -MSG_FLAG_PROCESSED, memory_order_relaxed);
 		if(!(f & MSG_FLAG_ANTI)) {
 			if(is_retractable(msg)) {
@@ -212,9 +236,11 @@ static void do_rollback(struct lp_ctx *lp, array_count_t past_i)
 {
 	timer_uint t = timer_hr_new();
 	send_anti_messages(&lp->p, past_i);
+	records_lp_rollback(lp, past_i);
 	array_count_t last_i = model_allocator_checkpoint_restore(&lp->mm_state, past_i);
 	stats_take(STATS_RECOVERY_TIME, timer_hr_value(t));
 	stats_take(STATS_ROLLBACK, 1);
+	stats_profile_lp_take(lp - lps, STATS_PROFILE_ROLLBACK, 1);
 	silent_execution(lp, last_i, past_i);
 }
 
@@ -257,6 +283,37 @@ static inline array_count_t match_anti_msg(const struct process_ctx *proc_p, con
 	return i;
 }
 
+/**
+ * @brief Roll back a LP which ran too far ahead in the simulation time
+ * @param lp the LP to roll back
+ * @param horizon the logical time after which the processed messages are undone
+ *
+ * The undone messages are put back in the message queue and their memory footprint (sent messages and checkpoints) is
+ * reclaimed. This is used by the memory governor as a cancelback-like mechanism.
+ */
+void process_lp_cancelback(struct lp_ctx *lp, simtime_t horizon)
+{
+	if(lp->p.bound <= horizon)
+		return;
+
+	array_count_t i = array_count(lp->p.p_msgs);
+	const struct lp_msg *msg;
+	do {
+		if(!i)
+			return;
+		msg = array_get_at(lp->p.p_msgs, --i);
+	} while(is_msg_sent(msg) || msg->dest_t > horizon);
+
+	if(++i == array_count(lp->p.p_msgs))
+		return;
+
+	current_lp = lp;
+	do_rollback(lp, i);
+	termination_on_lp_rollback(lp, horizon);
+	lp->p.bound = msg->dest_t;
+	retractable_reschedule(lp);
+}
+
 /**
  * @brief Handle the reception of a remote anti-message
  * @param proc_p the message processing data for the LP that has to handle the anti-message
@@ -289,6 +346,7 @@ static inline void handle_remote_anti_msg(struct lp_ctx *lp, struct lp_msg *a_ms
 	}
 
 	msg->raw_flags |= MSG_FLAG_ANTI;
+	stats_profile_msg_take(msg->m_type, STATS_PROFILE_ROLLBACK, 1);
 	do_rollback(lp, i);
 	termination_on_lp_rollback(lp, msg->dest_t);
 	msg_allocator_free(msg);
@@ -333,6 +391,7 @@ static void handle_anti_msg(struct lp_ctx *lp, struct lp_msg *msg, uint32_t last
 		return;
 	} else if(last_flags == (MSG_FLAG_ANTI | MSG_FLAG_PROCESSED)) {
 		array_count_t past_i = match_anti_msg(&lp->p, msg);
+		stats_profile_msg_take(msg->m_type, STATS_PROFILE_ROLLBACK, 1);
 		do_rollback(lp, past_i);
 		termination_on_lp_rollback(lp, msg->dest_t);
 		auto_ckpt_register_bad(&lp->auto_ckpt);
@@ -348,6 +407,7 @@ static void handle_anti_msg(struct lp_ctx *lp, struct lp_msg *msg, uint32_t last
 static void handle_straggler_msg(struct lp_ctx *lp, struct lp_msg *msg)
 {
 	array_count_t past_i = match_straggler_msg(&lp->p, msg);
+	stats_profile_msg_take(msg->m_type, STATS_PROFILE_ROLLBACK, 1);
 	do_rollback(lp, past_i);
 	termination_on_lp_rollback(lp, msg->dest_t);
 	auto_ckpt_register_bad(&lp->auto_ckpt);
@@ -372,7 +432,7 @@ void process_msg(void)
 	current_lp = lp;
 
 	if(unlikely(fossil_is_needed(lp))) {
-		auto_ckpt_recompute(&lp->auto_ckpt, lp->mm_state.full_ckpt_size);
+		auto_ckpt_recompute(&lp->auto_ckpt, lp->mm_state.ckpt_size);
 		fossil_lp_collect(lp);
 		lp->p.bound = unlikely(array_is_empty(lp->p.p_msgs)) ? -1.0 : lp->p.bound;
 	}
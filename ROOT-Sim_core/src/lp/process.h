@@ -35,4 +35,5 @@ struct lp_ctx; // forward declaration
 
 extern void process_lp_init(struct lp_ctx *lp);
 extern void process_lp_fini(struct lp_ctx *lp);
+extern void process_lp_cancelback(struct lp_ctx *lp, simtime_t horizon);
 extern void process_msg(void);
@@ -0,0 +1,148 @@
+/**
+ * @file mm/buddy/cow.c
+ *
+ * @brief Copy-on-write state saving of page ranges
+ *
+ * SPDX-FileCopyrightText: 2008-2023 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#include <mm/buddy/cow.h>
+
+#include <arch/mem.h>
+#include <core/intrinsics.h>
+#include <mm/mm.h>
+
+/**
+ * @brief Initialize a copy-on-write range of pages
+ * @param self the range to initialize
+ * @param base a pointer to the first page
+ * @param size the size in bytes of the range, a multiple of the page size
+ *
+ * The pages are writable: they are protected at the next checkpoint.
+ */
+void cow_init(struct cow_pages *self, void *base, size_t size)
+{
+	self->base = base;
+	self->size = size;
+	self->dirty = true;
+	array_init(self->undos);
+}
+
+/**
+ * @brief Release the saved pages of a copy-on-write range, leaving the pages mapped
+ * @param self the range to finalize
+ */
+void cow_fini(struct cow_pages *self)
+{
+	array_count_t i = array_count(self->undos);
+	while(i--)
+		mm_free(array_get_at(self->undos, i).copy);
+
+	array_fini(self->undos);
+}
+
+/**
+ * @brief Grow a copy-on-write range
+ * @param self the range to grow
+ * @param size the new size in bytes of the range, a multiple of the page size
+ *
+ * The added pages are writable: they are protected at the next checkpoint.
+ */
+void cow_resize(struct cow_pages *self, size_t size)
+{
+	if(size > self->size) {
+		self->size = size;
+		self->dirty = true;
+	}
+}
+
+/**
+ * @brief Check if an address belongs to a copy-on-write range
+ * @param self the range
+ * @param ptr the address
+ * @return true if @a ptr belongs to the range, false otherwise
+ */
+bool cow_contains(const struct cow_pages *self, const void *ptr)
+{
+	return (uintptr_t)ptr - (uintptr_t)self->base < self->size;
+}
+
+/**
+ * @brief Save and make writable the page written by a faulting access
+ * @param self the range holding @a addr
+ * @param addr the faulting address
+ * @param log_i the index of the latest checkpoint in the logs of the model allocator
+ * @return the count of copied bytes, 0 if the page could not be made writable
+ *
+ * This is called from the write fault handler, on the thread which is processing the LP. Since the faulting write
+ * comes from the model code, the page copy can be safely allocated here.
+ */
+size_t cow_fault(struct cow_pages *self, void *addr, array_count_t log_i)
+{
+	size_t page_size = mem_page_size();
+	unsigned char *page = self->base + (((unsigned char *)addr - self->base) & ~(page_size - 1));
+	struct cow_undo undo = {.log_i = log_i, .page = page, .copy = mm_alloc(page_size)};
+	memcpy(undo.copy, page, page_size);
+	array_push(self->undos, undo);
+	self->dirty = true;
+
+	return mem_pages_protect(page, page_size, true) ? 0 : page_size;
+}
+
+/**
+ * @brief Write-protect the pages of a copy-on-write range written since the last checkpoint
+ * @param self the range to protect
+ */
+void cow_protect(struct cow_pages *self)
+{
+	if(self->dirty) {
+		if(unlikely(mem_pages_protect(self->base, self->size, false))) {
+			logger(LOG_FATAL, "Unable to write-protect the model memory for a copy-on-write checkpoint!");
+			abort();
+		}
+		self->dirty = false;
+	}
+}
+
+/**
+ * @brief Restore a copy-on-write range at the moment a checkpoint was taken
+ * @param self the range to restore
+ * @param log_i the index of the restored checkpoint in the logs of the model allocator
+ *
+ * The range is left writable, so that the caller can amend it without saving pages on behalf of the checkpoints being
+ * discarded: cow_protect() must be called afterwards.
+ */
+void cow_restore(struct cow_pages *self, array_count_t log_i)
+{
+	if(unlikely(mem_pages_protect(self->base, self->size, true))) {
+		logger(LOG_FATAL, "Unable to make the model memory writable to restore a copy-on-write checkpoint!");
+		abort();
+	}
+	self->dirty = true;
+
+	size_t page_size = mem_page_size();
+	array_count_t j = array_count(self->undos);
+	// newest copies first, so that the ones saved right after the restored checkpoint win
+	while(j && array_get_at(self->undos, j - 1).log_i >= log_i) {
+		struct cow_undo *undo = &array_get_at(self->undos, --j);
+		memcpy(undo->page, undo->copy, page_size);
+		mm_free(undo->copy);
+	}
+	array_count(self->undos) = j;
+}
+
+/**
+ * @brief Discard the history of a copy-on-write range older than a checkpoint
+ * @param self the range
+ * @param log_i the count of checkpoints being removed from the head of the logs of the model allocator
+ */
+void cow_fossil_collect(struct cow_pages *self, array_count_t log_i)
+{
+	array_count_t j = 0;
+	while(j < array_count(self->undos) && array_get_at(self->undos, j).log_i < log_i)
+		mm_free(array_get_at(self->undos, j++).copy);
+	array_truncate_first(self->undos, j);
+
+	for(j = 0; j < array_count(self->undos); ++j)
+		array_get_at(self->undos, j).log_i -= log_i;
+}
@@ -0,0 +1,49 @@
+/**
+ * @file mm/buddy/cow.h
+ *
+ * @brief Copy-on-write state saving of page ranges
+ *
+ * A range of pages is write-protected when a checkpoint is taken. The first write to each page saves a copy of the
+ * page, tagged with the index of the checkpoint, before making it writable again: restoring a checkpoint copies back
+ * only the pages written since then.
+ *
+ * SPDX-FileCopyrightText: 2008-2023 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#pragma once
+
+#include <datatypes/array.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/// The content of a page at the moment of a checkpoint
+struct cow_undo {
+	/// The index of the checkpoint in the logs of the model allocator
+	array_count_t log_i;
+	/// A pointer to the page
+	unsigned char *page;
+	/// A copy of the page as it was when the checkpoint was taken
+	unsigned char *copy;
+};
+
+/// A range of pages saved copy-on-write
+struct cow_pages {
+	/// A pointer to the first page
+	unsigned char *base;
+	/// The size in bytes of the range, a multiple of the page size
+	size_t size;
+	/// If set, some pages may be writable and must be protected at the next checkpoint
+	bool dirty;
+	/// The saved pages, in the order they have been first written after a checkpoint
+	dyn_array(struct cow_undo) undos;
+};
+
+extern void cow_init(struct cow_pages *self, void *base, size_t size);
+extern void cow_fini(struct cow_pages *self);
+extern void cow_resize(struct cow_pages *self, size_t size);
+extern bool cow_contains(const struct cow_pages *self, const void *ptr);
+extern size_t cow_fault(struct cow_pages *self, void *addr, array_count_t log_i);
+extern void cow_protect(struct cow_pages *self);
+extern void cow_restore(struct cow_pages *self, array_count_t log_i);
+extern void cow_fossil_collect(struct cow_pages *self, array_count_t log_i);
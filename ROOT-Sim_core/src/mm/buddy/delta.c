@@ -0,0 +1,206 @@
+/**
+ * @file mm/buddy/delta.c
+ *
+ * @brief Delta encoding of checkpoints
+ *
+ * Each run starts with a byte holding the kind of its blocks in the two most significant bits and the count of its
+ * blocks minus one in the others. A run of referenced blocks is followed by the index of its first block in the
+ * reference checkpoint, a run of verbatim blocks by their contents.
+ *
+ * SPDX-FileCopyrightText: 2008-2023 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#include <mm/buddy/delta.h>
+
+#include <core/intrinsics.h>
+#include <mm/mm.h>
+
+#include <string.h>
+
+/// The kinds of the blocks of an encoded checkpoint
+enum delta_run_type {
+	/// The blocks are all zeroes
+	DELTA_RUN_ZERO = 0,
+	/// The blocks are equal to consecutive blocks of the reference checkpoint
+	DELTA_RUN_REF,
+	/// The blocks are stored verbatim
+	DELTA_RUN_LITERAL
+};
+
+/// The maximum count of blocks in a run
+#define DELTA_RUN_MAX 64U
+
+/**
+ * @brief Compute the hash of a block
+ * @param block a pointer to the block
+ * @return the hash of the block
+ */
+static uint64_t delta_block_hash(const unsigned char *block)
+{
+	uint64_t h = 0;
+	for(unsigned i = 0; i < DELTA_BLOCK_SIZE; i += sizeof(uint64_t)) {
+		uint64_t w;
+		memcpy(&w, block + i, sizeof(w));
+		h = (h ^ w) * UINT64_C(0x9E3779B97F4A7C15);
+	}
+	return h ^ (h >> 32U);
+}
+
+/**
+ * @brief Check whether a block is all zeroes
+ * @param block a pointer to the block
+ * @return true if the block is all zeroes, false otherwise
+ */
+static bool delta_block_is_zero(const unsigned char *block)
+{
+	uint64_t acc = 0;
+	for(unsigned i = 0; i < DELTA_BLOCK_SIZE; i += sizeof(uint64_t)) {
+		uint64_t w;
+		memcpy(&w, block + i, sizeof(w));
+		acc |= w;
+	}
+	return acc == 0;
+}
+
+/**
+ * @brief Encode a checkpoint
+ * @param src a pointer to the checkpoint to encode
+ * @param size the size in bytes of the checkpoint to encode
+ * @param ref a pointer to the reference checkpoint, NULL to encode the checkpoint by itself
+ * @param ref_size the size in bytes of the reference checkpoint, zero if @a ref is NULL
+ * @return the encoded checkpoint, NULL if it would not be smaller than the original one
+ *
+ * The blocks of the reference checkpoint are indexed by content, so that the blocks which moved because of the
+ * allocations and deallocations in between are still found.
+ */
+struct mm_delta *delta_encode(const void *src, size_t size, const void *ref, size_t ref_size)
+{
+	const unsigned char *s = src;
+	const unsigned char *r = ref;
+	size_t blocks = size / DELTA_BLOCK_SIZE;
+	size_t ref_blocks = min(ref_size / DELTA_BLOCK_SIZE, UINT32_MAX);
+
+	// open addressing table of the indices, plus one, of the distinct non-zero blocks of the reference
+	size_t cap = 1;
+	while(cap < 2 * ref_blocks)
+		cap <<= 1U;
+	uint32_t *slots = mm_alloc(cap * sizeof(*slots));
+	memset(slots, 0, cap * sizeof(*slots));
+
+	for(uint32_t j = 0; j < ref_blocks; ++j) {
+		const unsigned char *b = r + (size_t)j * DELTA_BLOCK_SIZE;
+		if(delta_block_is_zero(b))
+			continue;
+
+		size_t h = delta_block_hash(b) & (cap - 1);
+		while(slots[h] && memcmp(b, r + (size_t)(slots[h] - 1) * DELTA_BLOCK_SIZE, DELTA_BLOCK_SIZE))
+			h = (h + 1) & (cap - 1);
+		if(!slots[h])
+			slots[h] = j + 1;
+	}
+
+	struct mm_delta *ret = mm_alloc(
+	    offsetof(struct mm_delta, runs) + blocks * (DELTA_BLOCK_SIZE + 1) + size % DELTA_BLOCK_SIZE);
+	unsigned char *out = ret->runs;
+	unsigned char *run = NULL;
+	enum delta_run_type run_type = DELTA_RUN_ZERO;
+	unsigned run_count = 0;
+	uint32_t next_ref = 0;
+
+	for(size_t i = 0; i < blocks; ++i) {
+		const unsigned char *b = s + i * DELTA_BLOCK_SIZE;
+		enum delta_run_type type = DELTA_RUN_LITERAL;
+		uint32_t idx = 0;
+
+		if(run != NULL && run_type == DELTA_RUN_REF && next_ref < ref_blocks &&
+		    !memcmp(b, r + (size_t)next_ref * DELTA_BLOCK_SIZE, DELTA_BLOCK_SIZE)) {
+			type = DELTA_RUN_REF;
+			idx = next_ref;
+		} else if(delta_block_is_zero(b)) {
+			type = DELTA_RUN_ZERO;
+		} else if(ref_blocks) {
+			size_t h = delta_block_hash(b) & (cap - 1);
+			while(slots[h]) {
+				if(!memcmp(b, r + (size_t)(slots[h] - 1) * DELTA_BLOCK_SIZE, DELTA_BLOCK_SIZE)) {
+					type = DELTA_RUN_REF;
+					idx = slots[h] - 1;
+					break;
+				}
+				h = (h + 1) & (cap - 1);
+			}
+		}
+
+		if(run == NULL || type != run_type || run_count == DELTA_RUN_MAX ||
+		    (type == DELTA_RUN_REF && idx != next_ref)) {
+			run = out++;
+			run_type = type;
+			run_count = 0;
+			if(type == DELTA_RUN_REF) {
+				memcpy(out, &idx, sizeof(idx));
+				out += sizeof(idx);
+			}
+		}
+		*run = (unsigned char)(run_type << 6U | run_count);
+		++run_count;
+
+		if(type == DELTA_RUN_LITERAL) {
+			memcpy(out, b, DELTA_BLOCK_SIZE);
+			out += DELTA_BLOCK_SIZE;
+		}
+		next_ref = idx + 1;
+	}
+
+	memcpy(out, s + blocks * DELTA_BLOCK_SIZE, size % DELTA_BLOCK_SIZE);
+	out += size % DELTA_BLOCK_SIZE;
+	mm_free(slots);
+
+	size_t enc_size = (size_t)(out - (unsigned char *)ret);
+	if(enc_size >= size) {
+		mm_free(ret);
+		return NULL;
+	}
+
+	ret->size = size;
+	return mm_realloc(ret, enc_size);
+}
+
+/**
+ * @brief Decode a checkpoint
+ * @param self the encoded checkpoint
+ * @param ref a pointer to the reference checkpoint it has been encoded against, NULL if encoded by itself
+ * @param dst a pointer to the memory area to decode the checkpoint to, holding at least @a self->size bytes
+ */
+void delta_decode(const struct mm_delta *self, const void *ref, void *dst)
+{
+	const unsigned char *in = self->runs;
+	const unsigned char *r = ref;
+	unsigned char *out = dst;
+	size_t blocks = self->size / DELTA_BLOCK_SIZE;
+
+	while(blocks) {
+		enum delta_run_type type = *in >> 6U;
+		size_t len = (size_t)((*in & (DELTA_RUN_MAX - 1)) + 1) * DELTA_BLOCK_SIZE;
+		blocks -= len / DELTA_BLOCK_SIZE;
+		++in;
+
+		switch(type) {
+			case DELTA_RUN_ZERO:
+				memset(out, 0, len);
+				break;
+			case DELTA_RUN_REF: {
+				uint32_t idx;
+				memcpy(&idx, in, sizeof(idx));
+				in += sizeof(idx);
+				memcpy(out, r + (size_t)idx * DELTA_BLOCK_SIZE, len);
+				break;
+			}
+			default:
+				memcpy(out, in, len);
+				in += len;
+				break;
+		}
+		out += len;
+	}
+
+	memcpy(out, in, self->size % DELTA_BLOCK_SIZE);
+}
@@ -0,0 +1,30 @@
+/**
+ * @file mm/buddy/delta.h
+ *
+ * @brief Delta encoding of checkpoints
+ *
+ * A checkpoint is encoded as a sequence of 64 bytes blocks, each one either all zeroes, equal to a block of an
+ * optional reference checkpoint or stored verbatim. Consecutive blocks of the same kind are coalesced in runs, so that sparse
+ * bitmaps and unchanged data take a few bytes each.
+ *
+ * SPDX-FileCopyrightText: 2008-2023 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// The size in bytes of the blocks a checkpoint is split in by the delta encoding
+#define DELTA_BLOCK_SIZE 64U
+
+/// An encoded checkpoint
+struct mm_delta {
+	/// The size in bytes of the decoded checkpoint
+	uint_fast32_t size;
+	/// The encoded runs of blocks, followed by the bytes past the last whole block
+	unsigned char runs[];
+};
+
+extern struct mm_delta *delta_encode(const void *src, size_t size, const void *ref, size_t ref_size);
+extern void delta_decode(const struct mm_delta *self, const void *ref, void *dst);
@@ -0,0 +1,166 @@
+/**
+ * @file mm/buddy/large.c
+ *
+ * @brief Checkpointable large objects
+ *
+ * SPDX-FileCopyrightText: 2008-2023 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#include <mm/buddy/large.h>
+
+#include <arch/mem.h>
+#include <core/intrinsics.h>
+#include <lp/lp.h>
+#include <mm/buddy/multi.h>
+
+#include <errno.h>
+
+/**
+ * @brief Allocate a new extent
+ * @param self the model allocator state
+ * @param req_size the requested size in bytes, rounded up to a multiple of the page size
+ * @return a pointer to the first page of the extent, NULL if unsuccessful
+ */
+void *extent_malloc(struct mm_state *self, size_t req_size)
+{
+	size_t page_size = mem_page_size();
+	size_t size = (req_size + page_size - 1) & ~(page_size - 1);
+
+	unsigned char *base = mem_pages_map(size);
+	if(unlikely(base == NULL)) {
+		errno = ENOMEM;
+		logger(LOG_WARN, "LP %p was unable to map %zu bytes!", current_lp, size);
+		return NULL;
+	}
+
+	struct mm_extent *e = mm_alloc(sizeof(*e));
+	cow_init(&e->pages, base, size);
+	e->birth = array_count(self->logs);
+	e->death = EXTENT_ALIVE;
+	array_push(self->extents, e);
+	return base;
+}
+
+/**
+ * @brief Release the resources of an extent, without removing it from the extents of its LP
+ * @param e the extent to destroy
+ */
+static void extent_destroy(struct mm_extent *e)
+{
+	cow_fini(&e->pages);
+	mem_pages_unmap(e->pages.base, e->pages.size);
+	mm_free(e);
+}
+
+/**
+ * @brief Free an extent
+ * @param self the model allocator state
+ * @param e the extent to free
+ */
+void extent_free(struct mm_state *self, struct mm_extent *e)
+{
+	if(e->birth < array_count(self->logs)) {
+		// a checkpoint holds this extent: keep it around until it is fossil collected
+		e->death = array_count(self->logs);
+		return;
+	}
+
+	array_count_t i = array_count(self->extents);
+	while(array_get_at(self->extents, --i) != e)
+		;
+	array_lazy_remove_at(self->extents, i);
+	extent_destroy(e);
+}
+
+/**
+ * @brief Find the extent holding an address
+ * @param self the model allocator state
+ * @param ptr the address to look for
+ * @return the extent holding @a ptr, NULL if none
+ */
+struct mm_extent *extent_find(const struct mm_state *self, const void *ptr)
+{
+	array_count_t i = array_count(self->extents);
+	while(i--) {
+		struct mm_extent *e = array_get_at(self->extents, i);
+		if(cow_contains(&e->pages, ptr))
+			return e;
+	}
+	return NULL;
+}
+
+/**
+ * @brief Release all the extents, regardless of the checkpoints
+ * @param self the model allocator state
+ */
+void extent_all_free(struct mm_state *self)
+{
+	array_count_t i = array_count(self->extents);
+	while(i--)
+		extent_destroy(array_get_at(self->extents, i));
+
+	array_count(self->extents) = 0;
+}
+
+/**
+ * @brief Write-protect the extents written since the last checkpoint
+ * @param self the model allocator state
+ *
+ * This must be called after the new checkpoint is added to the logs of the model allocator.
+ */
+void extent_checkpoint_take(struct mm_state *self)
+{
+	array_count_t i = array_count(self->extents);
+	while(i--)
+		cow_protect(&array_get_at(self->extents, i)->pages);
+}
+
+/**
+ * @brief Restore the extents at the moment a checkpoint was taken
+ * @param self the model allocator state
+ * @param log_i the index of the restored checkpoint in the logs of the model allocator
+ */
+void extent_checkpoint_restore(struct mm_state *self, array_count_t log_i)
+{
+	array_count_t i = array_count(self->extents);
+	while(i--) {
+		struct mm_extent *e = array_get_at(self->extents, i);
+		if(e->birth > log_i) {
+			array_lazy_remove_at(self->extents, i);
+			extent_destroy(e);
+			continue;
+		}
+
+		if(e->death > log_i)
+			e->death = EXTENT_ALIVE;
+
+		cow_restore(&e->pages, log_i);
+		cow_protect(&e->pages);
+	}
+}
+
+/**
+ * @brief Discard the extents history older than a checkpoint
+ * @param self the model allocator state
+ * @param log_i the count of checkpoints being removed from the head of the logs of the model allocator
+ */
+void extent_fossil_collect(struct mm_state *self, array_count_t log_i)
+{
+	if(!log_i)
+		return;
+
+	array_count_t i = array_count(self->extents);
+	while(i--) {
+		struct mm_extent *e = array_get_at(self->extents, i);
+		if(e->death <= log_i) {
+			array_lazy_remove_at(self->extents, i);
+			extent_destroy(e);
+			continue;
+		}
+
+		cow_fossil_collect(&e->pages, log_i);
+		e->birth = e->birth > log_i ? e->birth - log_i : 0;
+		if(e->death != EXTENT_ALIVE)
+			e->death -= log_i;
+	}
+}
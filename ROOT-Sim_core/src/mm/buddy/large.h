@@ -0,0 +1,43 @@
+/**
+ * @file mm/buddy/large.h
+ *
+ * @brief Checkpointable large objects
+ *
+ * The allocations too big for a buddy system are served with dedicated page ranges, called extents. Extents are not
+ * copied in the checkpoints: they are saved copy-on-write, so that the cost of state saving is proportional to the
+ * written pages only.
+ *
+ * SPDX-FileCopyrightText: 2008-2023 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#pragma once
+
+#include <datatypes/array.h>
+#include <mm/buddy/cow.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+
+struct mm_state;
+
+/// The death index of a live extent
+#define EXTENT_ALIVE ARRAY_COUNT_MAX
+
+/// A range of pages holding a single large allocation
+struct mm_extent {
+	/// The pages of the allocation
+	struct cow_pages pages;
+	/// The count of checkpoints taken before the allocation
+	array_count_t birth;
+	/// The count of checkpoints taken before the deallocation, EXTENT_ALIVE if still allocated
+	array_count_t death;
+};
+
+extern void *extent_malloc(struct mm_state *self, size_t req_size);
+extern void extent_free(struct mm_state *self, struct mm_extent *e);
+extern struct mm_extent *extent_find(const struct mm_state *self, const void *ptr);
+extern void extent_all_free(struct mm_state *self);
+
+extern void extent_checkpoint_take(struct mm_state *self);
+extern void extent_checkpoint_restore(struct mm_state *self, array_count_t log_i);
+extern void extent_fossil_collect(struct mm_state *self, array_count_t log_i);
@@ -9,10 +9,14 @@
 #include <ROOT-Sim.h>
 
 #include <mm/buddy/multi.h>
+#include <arch/timer.h>
 #include <core/intrinsics.h>
+#include <log/stats.h>
 #include <lp/lp.h>
 #include <mm/buddy/buddy.h>
 #include <mm/buddy/ckpt.h>
+#include <mm/buddy/large.h>
+#include <mm/mem_governor.h>
 
 #include <errno.h>
 
@@ -22,26 +26,107 @@
 #define is_log_incremental(l) false
 #endif
 
+/// The maximum count of buddy systems of a single LP
+#define MM_BUDDIES_MAX (1U << 14U)
+/// The address space reserved for the buddy systems of all the LPs of a node
+#define MM_BUDDIES_RESERVATION_MAX (1ULL << 45U)
+
+/// The count of buddy systems fitting in the address range reserved for each LP
+static array_count_t buddies_max = MM_BUDDIES_MAX;
+
+/**
+ * @brief Handle a write to a write-protected page of the model memory of a LP
+ * @param self the model allocator state of the LP
+ * @param addr the faulting address
+ * @return true if the page belongs to the LP and has been saved and made writable, false otherwise
+ */
+static bool model_allocator_lp_write_fault(struct mm_state *self, void *addr)
+{
+	if(unlikely(array_is_empty(self->logs)))
+		return false;
+
+	struct cow_pages *pages = &self->buddies_pages;
+	if(!cow_contains(pages, addr)) {
+		struct mm_extent *e = extent_find(self, addr);
+		if(e == NULL || e->death != EXTENT_ALIVE)
+			return false;
+		pages = &e->pages;
+	}
+
+	timer_uint t = timer_hr_new();
+	size_t copied = cow_fault(pages, addr, array_count(self->logs) - 1);
+	self->cow_size += copied;
+	stats_take(STATS_CKPT_TIME, timer_hr_value(t));
+	return copied != 0;
+}
+
+/**
+ * @brief Handle a write to a write-protected page of the model memory
+ * @param addr the faulting address
+ * @return true if the page belongs to a LP of this thread and has been saved and made writable, false otherwise
+ */
+static bool model_allocator_write_fault(void *addr)
+{
+	if(likely(current_lp != NULL) && model_allocator_lp_write_fault(&current_lp->mm_state, addr))
+		return true;
+
+	// the core may write the memory of a LP while processing another one, e.g. in the retractable events library
+	for(uint64_t i = lid_thread_first; i < lid_thread_end; ++i)
+		if(&lps[i] != current_lp && model_allocator_lp_write_fault(&lps[i].mm_state, addr))
+			return true;
+
+	return false;
+}
+
+/**
+ * @brief Initialize the node-wide facilities of the model allocator
+ *
+ * With copy-on-write checkpointing, installs the write fault handler which saves the pages written after a checkpoint.
+ * Sizes the address ranges reserved for the buddy systems of the LPs, so that the ones of all the LPs of this node fit
+ * in the address space.
+ */
+void model_allocator_global_init(void)
+{
+	if(global_config.ckpt_cow && mem_write_fault_handler_set(model_allocator_write_fault)) {
+		logger(LOG_FATAL, "Unable to install the write fault handler of the model allocator!");
+		abort();
+	}
+
+	uint64_t lp_max = MM_BUDDIES_RESERVATION_MAX / sizeof(struct buddy_state) / max(n_lps_node, 1U);
+	buddies_max = (array_count_t)min(lp_max, MM_BUDDIES_MAX);
+}
+
 void model_allocator_lp_init(struct mm_state *self)
 {
-	array_init(self->buddies);
+	self->buddies = mem_pages_reserve(buddies_max * sizeof(struct buddy_state));
+	if(unlikely(self->buddies == NULL)) {
+		logger(LOG_FATAL, "Unable to reserve the address space for the model memory!");
+		abort();
+	}
+	self->buddies_count = 0;
+	memset(self->free_hints, 0, sizeof(self->free_hints));
+	cow_init(&self->buddies_pages, self->buddies, 0);
+
 	array_init(self->logs);
+	array_init(self->extents);
 	self->full_ckpt_size = offsetof(struct mm_checkpoint, chkps) + sizeof(struct buddy_state *);
+	self->cow_size = 0;
+	self->ckpt_size = self->full_ckpt_size;
 }
 
 void model_allocator_lp_fini(struct mm_state *self)
 {
+	extent_all_free(self);
+	array_fini(self->extents);
+
 	array_count_t i = array_count(self->logs);
 	while(i--)
 		mm_free(array_get_at(self->logs, i).c);
 
 	array_fini(self->logs);
 
-	i = array_count(self->buddies);
-	while(i--)
-		mm_free(array_get_at(self->buddies, i));
-
-	array_fini(self->buddies);
+	cow_fini(&self->buddies_pages);
+	mem_pages_unmap(self->buddies, buddies_max * sizeof(struct buddy_state));
 }
 
 void *rs_malloc(size_t req_size)
@@ -49,32 +134,47 @@ void *rs_malloc(size_t req_size)
 	if(unlikely(!req_size))
 		return NULL;
 
+	// the serial runtime never rolls back, so the model memory needs no checkpointable allocator
+	if(unlikely(global_config.serial))
+		return malloc(req_size);
+
+	struct mm_state *self = &current_lp->mm_state;
 	uint_fast8_t req_blks_exp = buddy_allocation_block_compute(req_size);
-	if(unlikely(req_blks_exp > B_TOTAL_EXP)) {
+	if(unlikely(req_blks_exp > B_TOTAL_EXP))
+		return extent_malloc(self, req_size);
+
+	// the buddy systems before the hint have no room for this size class
+	array_count_t *hint = &self->free_hints[req_blks_exp - B_BLOCK_EXP];
+	for(array_count_t i = *hint; i < self->buddies_count; ++i) {
+		void *ret = buddy_malloc(&self->buddies[i], req_blks_exp);
+		if(likely(ret != NULL)) {
+			*hint = i;
+			self->full_ckpt_size += 1 << req_blks_exp;
+			return ret;
+		}
+	}
+
+	if(unlikely(self->buddies_count == buddies_max)) {
 		errno = ENOMEM;
-		logger(LOG_WARN, "LP %p requested a memory block bigger than %u!", current_lp, 1U << B_TOTAL_EXP);
+		logger(LOG_WARN, "LP %p exhausted the %u buddy systems reserved for its memory!", current_lp, buddies_max);
 		return NULL;
 	}
 
-	struct mm_state *self = &current_lp->mm_state;
-	self->full_ckpt_size += 1 << req_blks_exp;
-
-	array_count_t i = array_count(self->buddies);
-	while(i--) {
-		void *ret = buddy_malloc(array_get_at(self->buddies, i), req_blks_exp);
-		if(likely(ret != NULL))
-			return ret;
+	struct buddy_state *new_buddy = &self->buddies[self->buddies_count];
+	if(unlikely(mem_pages_commit(new_buddy, sizeof(*new_buddy)))) {
+		errno = ENOMEM;
+		logger(LOG_WARN, "LP %p was unable to commit the memory of a new buddy system!", current_lp);
+		return NULL;
+	}
+	if(global_config.ckpt_cow) {
+		size_t page_size = mem_page_size();
+		cow_resize(&self->buddies_pages, ((uintptr_t)(new_buddy + 1) - (uintptr_t)self->buddies + page_size - 1) &
+		    ~(page_size - 1));
 	}
-
-	struct buddy_state *new_buddy = mm_alloc(sizeof(*new_buddy));
 	buddy_init(new_buddy);
 
-	for(i = 0; i < array_count(self->buddies); ++i)
-		if(array_get_at(self->buddies, i) > new_buddy)
-			break;
-
-	array_add_at(self->buddies, i, new_buddy);
-	self->full_ckpt_size += offsetof(struct buddy_checkpoint, base_mem);
+	*hint = self->buddies_count++;
+	self->full_ckpt_size += (1 << req_blks_exp) + offsetof(struct buddy_checkpoint, base_mem);
 	return buddy_malloc(new_buddy, req_blks_exp);
 }
 
@@ -89,19 +189,16 @@ void *rs_calloc(size_t nmemb, size_t size)
 	return ret;
 }
 
-static inline struct buddy_state *buddy_find_by_address(struct mm_state *self, const void *ptr)
+/**
+ * @brief Compute the index of the buddy system holding an address
+ * @param self the model allocator state
+ * @param ptr the address
+ * @return the index of the buddy system holding @a ptr, a value not less than @a self->buddies_count if none
+ */
+static inline array_count_t buddy_index_by_address(const struct mm_state *self, const void *ptr)
 {
-	array_count_t l = 0, h = array_count(self->buddies) - 1;
-	while(1) {
-		array_count_t m = (l + h) / 2;
-		struct buddy_state *b = array_get_at(self->buddies, m);
-		if(ptr < (void *)b)
-			h = m - 1;
-		else if(ptr > (void *)(b + 1))
-			l = m + 1;
-		else
-			return b;
-	}
+	uintptr_t diff = (uintptr_t)ptr - (uintptr_t)self->buddies;
+	return diff < self->buddies_count * sizeof(struct buddy_state) ? diff / sizeof(struct buddy_state) : ARRAY_COUNT_MAX;
 }
 
 void rs_free(void *ptr)
@@ -109,9 +206,24 @@ void rs_free(void *ptr)
 	if(unlikely(!ptr))
 		return;
 
+	if(unlikely(global_config.serial)) {
+		free(ptr);
+		return;
+	}
+
 	struct mm_state *self = &current_lp->mm_state;
-	struct buddy_state *b = buddy_find_by_address(self, ptr);
+	array_count_t i = buddy_index_by_address(self, ptr);
+	if(unlikely(i >= self->buddies_count)) {
+		extent_free(self, extent_find(self, ptr));
+		return;
+	}
+
+	struct buddy_state *b = &self->buddies[i];
 	self->full_ckpt_size -= buddy_free(b, ptr);
+
+	// the freed block may have made room for the size classes up to the largest free one
+	for(uint_fast8_t e = B_BLOCK_EXP; e <= b->longest[0]; ++e)
+		self->free_hints[e - B_BLOCK_EXP] = min(self->free_hints[e - B_BLOCK_EXP], i);
 }
 
 void *rs_realloc(void *ptr, size_t req_size)
@@ -124,19 +236,31 @@ void *rs_realloc(void *ptr, size_t req_size)
 	if(!ptr)
 		return rs_malloc(req_size);
 
+	if(unlikely(global_config.serial))
+		return realloc(ptr, req_size);
+
 	struct mm_state *self = &current_lp->mm_state;
-	struct buddy_state *b = buddy_find_by_address(self, ptr);
-	struct buddy_realloc_res ret = buddy_best_effort_realloc(b, ptr, req_size);
-	if(ret.handled) {
-		self->full_ckpt_size += ret.variation;
-		return ptr;
+	size_t original;
+	array_count_t i = buddy_index_by_address(self, ptr);
+	if(unlikely(i >= self->buddies_count)) {
+		struct mm_extent *e = extent_find(self, ptr);
+		if(req_size <= e->pages.size)
+			return ptr;
+		original = e->pages.size;
+	} else {
+		struct buddy_realloc_res ret = buddy_best_effort_realloc(&self->buddies[i], ptr, req_size);
+		if(ret.handled) {
+			self->full_ckpt_size += ret.variation;
+			return ptr;
+		}
+		original = ret.original;
 	}
 
 	void *new_buffer = rs_malloc(req_size);
 	if(unlikely(new_buffer == NULL))
 		return NULL;
 
-	memcpy(new_buffer, ptr, min(req_size, ret.original));
+	memcpy(new_buffer, ptr, min(req_size, original));
 	rs_free(ptr);
 
 	return new_buffer;
@@ -145,31 +269,134 @@ void *rs_realloc(void *ptr, size_t req_size)
 void __write_mem(const void *ptr, size_t s)
 {
 	struct mm_state *self = &current_lp->mm_state;
-	if(unlikely(!s || array_is_empty(self->buddies)))
+	if(unlikely(!s))
 		return;
 
-	if(unlikely(ptr < (void *)array_get_at(self->buddies, 0) || ptr > (void *)(array_peek(self->buddies) + 1)))
+	// the writes to the extents are tracked by the write fault handler
+	array_count_t i = buddy_index_by_address(self, ptr);
+	if(unlikely(i >= self->buddies_count))
 		return;
 
-	struct buddy_state *b = buddy_find_by_address(self, ptr);
+	buddy_dirty_mark(&self->buddies[i], ptr, s);
+}
+
+/**
+ * @brief Encode the checkpoint of a log, if convenient
+ * @param log the log, holding a plain checkpoint
+ * @param ref the plain checkpoint to encode against, NULL to encode the checkpoint by itself
+ */
+static void checkpoint_log_encode(struct mm_log *log, const struct mm_checkpoint *ref)
+{
+	struct mm_delta *d = delta_encode(log->c, log->c->ckpt_size, ref, ref == NULL ? 0 : ref->ckpt_size);
+	if(d == NULL)
+		return;
+
+	mm_free(log->c);
+	log->d = d;
+	log->enc = ref == NULL ? MM_LOG_PACKED : MM_LOG_DELTA;
+}
+
+/**
+ * @brief Decode the checkpoint of a log
+ * @param log the log, holding a checkpoint not encoded against another one
+ * @param ref the plain checkpoint it has been encoded against, NULL if encoded by itself
+ */
+static void checkpoint_log_decode(struct mm_log *log, const struct mm_checkpoint *ref)
+{
+	struct mm_checkpoint *ckp = mm_alloc(log->d->size);
+	delta_decode(log->d, ref, ckp);
+	mm_free(log->d);
+	log->c = ckp;
+	log->enc = MM_LOG_PLAIN;
+}
+
+/**
+ * @brief Compress the checkpoints of the latest two logs
+ * @param self the model allocator state
+ *
+ * The latest checkpoint is encoded by itself, while the previous one is encoded against it, since consecutive
+ * checkpoints mostly share their contents. This way a new checkpoint needs to decode only the latest one and fossil
+ * collection can discard the oldest checkpoints, since no other checkpoint is encoded against them.
+ */
+static void checkpoint_compress(struct mm_state *self)
+{
+	struct mm_log *log = &array_get_at(self->logs, array_count(self->logs) - 1);
+	if(array_count(self->logs) > 1) {
+		struct mm_log *prev = log - 1;
+		if(prev->enc == MM_LOG_PACKED)
+			checkpoint_log_decode(prev, NULL);
+		if(prev->enc == MM_LOG_PLAIN)
+			checkpoint_log_encode(prev, log->c);
+	}
+	checkpoint_log_encode(log, NULL);
+}
 
-	buddy_dirty_mark(b, ptr, s);
+/**
+ * @brief Decode the checkpoint of a log
+ * @param self the model allocator state
+ * @param i the index of the log
+ * @return the plain checkpoint of the log
+ *
+ * The checkpoints of the following logs are decoded in turn, from the first one not encoded against another one
+ * backwards, and released: the caller is expected to discard the following logs.
+ */
+static struct mm_checkpoint *checkpoint_decompress(struct mm_state *self, array_count_t i)
+{
+	array_count_t j = i;
+	while(array_get_at(self->logs, j).enc == MM_LOG_DELTA)
+		++j;
+
+	if(array_get_at(self->logs, j).enc == MM_LOG_PACKED)
+		checkpoint_log_decode(&array_get_at(self->logs, j), NULL);
+
+	while(j > i) {
+		struct mm_checkpoint *ref = array_get_at(self->logs, j).c;
+		checkpoint_log_decode(&array_get_at(self->logs, j - 1), ref);
+		mm_free(ref);
+		array_get_at(self->logs, j).c = NULL;
+		--j;
+	}
+	return array_get_at(self->logs, i).c;
 }
 
+/**
+ * @brief Take a checkpoint of the model memory of a LP
+ * @param self the model allocator state
+ * @param ref_i the reference index of the checkpoint
+ * @return the count of bytes copied to save the state
+ *
+ * The pages saved copy-on-write are copied after the checkpoint is taken, when they are first written: they are
+ * accounted in the size of the next checkpoint.
+ */
 // todo: incremental
-void model_allocator_checkpoint_take(struct mm_state *self, array_count_t ref_i)
+uint_fast32_t model_allocator_checkpoint_take(struct mm_state *self, array_count_t ref_i)
 {
-	struct mm_checkpoint *ckp = mm_alloc(self->full_ckpt_size);
+	uint_fast32_t size = global_config.ckpt_cow ? offsetof(struct mm_checkpoint, chkps) : self->full_ckpt_size;
+	struct mm_checkpoint *ckp = mm_alloc(size);
 	ckp->ckpt_size = self->full_ckpt_size;
+	ckp->buddies_count = self->buddies_count;
 
-	struct mm_log mm_log = {.ref_i = ref_i, .c = ckp};
+	struct mm_log mm_log = {.ref_i = ref_i, .enc = MM_LOG_PLAIN, .c = ckp};
 	array_push(self->logs, mm_log);
 
-	struct buddy_checkpoint *buddy_ckp = (struct buddy_checkpoint *)ckp->chkps;
-	array_count_t i = array_count(self->buddies);
-	while(i--)
-		buddy_ckp = checkpoint_full_take(array_get_at(self->buddies, i), buddy_ckp);
-	buddy_ckp->orig = NULL;
+	if(global_config.ckpt_cow) {
+		cow_protect(&self->buddies_pages);
+	} else {
+		struct buddy_checkpoint *buddy_ckp = (struct buddy_checkpoint *)ckp->chkps;
+		array_count_t i = self->buddies_count;
+		while(i--)
+			buddy_ckp = checkpoint_full_take(&self->buddies[i], buddy_ckp);
+		buddy_ckp->orig = NULL;
+
+		if(global_config.ckpt_compress && (!global_config.mem_budget || mem_governor_pressure_check()))
+			checkpoint_compress(self);
+	}
+
+	extent_checkpoint_take(self);
+
+	self->ckpt_size = size + self->cow_size;
+	self->cow_size = 0;
+	return self->ckpt_size;
 }
 
 void model_allocator_checkpoint_next_force_full(struct mm_state *self)
@@ -184,22 +411,37 @@ array_count_t model_allocator_checkpoint_restore(struct mm_state *self, array_co
 	while(array_get_at(self->logs, i).ref_i > ref_i)
 		i--;
 
-	struct mm_checkpoint *ckp = array_get_at(self->logs, i).c;
+	struct mm_checkpoint *ckp = checkpoint_decompress(self, i);
 	self->full_ckpt_size = ckp->ckpt_size;
-	const struct buddy_checkpoint *buddy_ckp = (struct buddy_checkpoint *)ckp->chkps;
-
-	array_count_t k = array_count(self->buddies);
-	while(k--) {
-		struct buddy_state *b = array_get_at(self->buddies, k);
-		const struct buddy_checkpoint *c = checkpoint_full_restore(array_get_at(self->buddies, k), buddy_ckp);
-		if(unlikely(c == NULL)) {
-			buddy_init(b);
+
+	if(global_config.ckpt_cow) {
+		cow_restore(&self->buddies_pages, i);
+		// the buddy systems created after the checkpoint are kept, empty
+		for(array_count_t k = ckp->buddies_count; k < self->buddies_count; ++k) {
+			buddy_init(&self->buddies[k]);
 			self->full_ckpt_size += offsetof(struct buddy_checkpoint, base_mem);
-		} else {
-			buddy_ckp = c;
+		}
+		cow_protect(&self->buddies_pages);
+	} else {
+		const struct buddy_checkpoint *buddy_ckp = (struct buddy_checkpoint *)ckp->chkps;
+		array_count_t k = self->buddies_count;
+		while(k--) {
+			struct buddy_state *b = &self->buddies[k];
+			const struct buddy_checkpoint *c = checkpoint_full_restore(b, buddy_ckp);
+			if(unlikely(c == NULL)) {
+				buddy_init(b);
+				self->full_ckpt_size += offsetof(struct buddy_checkpoint, base_mem);
+			} else {
+				buddy_ckp = c;
+			}
 		}
 	}
 
+	// any buddy system may have regained room
+	memset(self->free_hints, 0, sizeof(self->free_hints));
+
+	extent_checkpoint_restore(self, i);
+
 	for(array_count_t j = array_count(self->logs) - 1; j > i; --j)
 		mm_free(array_get_at(self->logs, j).c);
 
@@ -230,6 +472,8 @@ array_count_t model_allocator_fossil_lp_collect(struct mm_state *self, array_cou
 	while(j--)
 		mm_free(array_get_at(self->logs, j).c);
 
+	cow_fossil_collect(&self->buddies_pages, log_i);
+	extent_fossil_collect(self, log_i);
 	array_truncate_first(self->logs, log_i);
 	return ref_i;
 }
@@ -9,6 +9,9 @@
 #pragma once
 
 #include <datatypes/array.h>
+#include <mm/buddy/buddy.h>
+#include <mm/buddy/cow.h>
+#include <mm/buddy/delta.h>
 
 #include <assert.h>
 #include <stdalign.h>
@@ -19,25 +22,56 @@
 struct mm_checkpoint {
 	/// The total count of allocated bytes at the moment of the checkpoint
 	uint_fast32_t ckpt_size;
-	/// The sequence of checkpoints of the allocated buddy systems (see @a buddy_checkpoint)
+	/// The count of buddy systems in use at the moment of the checkpoint
+	array_count_t buddies_count;
+	/// The sequence of checkpoints of the allocated buddy systems (see @a buddy_checkpoint), empty if the buddy
+	/// systems are saved copy-on-write
 	unsigned char chkps[];
 };
 
+/// The ways a checkpoint can be stored
+enum mm_log_encoding {
+	/// The checkpoint is stored as is
+	MM_LOG_PLAIN = 0,
+	/// The checkpoint is encoded by itself (see @a mm_delta)
+	MM_LOG_PACKED,
+	/// The checkpoint is encoded against the one of the next log (see @a mm_delta)
+	MM_LOG_DELTA
+};
+
 /// Binds a checkpoint together with a reference index
 struct mm_log {
 	/// The reference index, used to identify this checkpoint
 	array_count_t ref_i;
-	/// A pointer to the actual checkpoint
-	struct mm_checkpoint *c;
+	/// How the checkpoint is stored
+	enum mm_log_encoding enc;
+	union {
+		/// A pointer to the actual checkpoint, if @a enc is MM_LOG_PLAIN
+		struct mm_checkpoint *c;
+		/// A pointer to the encoded checkpoint otherwise
+		struct mm_delta *d;
+	};
 };
 
 /// The checkpointable memory context assigned to a single LP
 struct mm_state {
-	/// The array of pointers to the allocated buddy systems for the LP
-	dyn_array(struct buddy_state *) buddies;
+	/// The buddy systems of the LP, laid out contiguously in an address range reserved for the LP
+	struct buddy_state *buddies;
+	/// The count of buddy systems in use in @a buddies
+	array_count_t buddies_count;
+	/// For each allocation size class, the index of the first buddy system which may have room for it
+	array_count_t free_hints[B_TOTAL_EXP - B_BLOCK_EXP + 1];
+	/// The pages of the buddy systems, if they are saved copy-on-write
+	struct cow_pages buddies_pages;
 	/// The array of checkpoints
 	dyn_array(struct mm_log) logs;
-	/// The total count of allocated bytes
+	/// The array of pointers to the extents holding the large allocations for the LP (see @a mm_extent)
+	dyn_array(struct mm_extent *) extents;
+	/// The total count of allocated bytes, not including the extents
 	uint_fast32_t full_ckpt_size;
+	/// The count of bytes copied by the write faults since the latest checkpoint
+	uint_fast32_t cow_size;
+	/// The count of bytes actually copied to save the latest checkpoint
+	uint_fast32_t ckpt_size;
 };
 
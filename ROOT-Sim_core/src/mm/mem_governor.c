@@ -0,0 +1,152 @@
+/**
+ * @file mm/mem_governor.c
+ *
+ * @brief Memory pressure driven flow control
+ *
+ * The resident set of the node is sampled at each GVT and compared against the configured memory budget. Above the
+ * soft limit, a new GVT is requested right away, the thread-local LPs are eagerly fossil collected and the processing
+ * of messages too far ahead of the GVT is deferred. Above the hard limit, the LPs which ran beyond the processing
+ * horizon are also rolled back, so that the memory held by their speculative trajectory is reclaimed.
+ *
+ * SPDX-FileCopyrightText: 2008-2023 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#include <mm/mem_governor.h>
+
+#include <arch/mem.h>
+#include <datatypes/msg_queue.h>
+#include <gvt/fossil.h>
+#include <gvt/gvt.h>
+#include <lp/lp.h>
+
+#include <stdatomic.h>
+
+/// The memory pressure levels recognized by the governor
+enum mem_governor_level {
+	/// The resident set is below the soft limit
+	MEM_GOVERNOR_NONE = 0,
+	/// The resident set is between the soft and the hard limit
+	MEM_GOVERNOR_SOFT,
+	/// The resident set is above the hard limit
+	MEM_GOVERNOR_HARD
+};
+
+/// The resident set size in bytes above which optimistic processing is slowed down
+static size_t soft_limit;
+/// The resident set size in bytes above which the LPs furthest ahead are rolled back
+static size_t hard_limit;
+/// The last memory pressure level sampled by the master thread
+static _Atomic unsigned mem_level;
+__thread simtime_t mem_governor_horizon = SIMTIME_MAX;
+/// The value of the previous GVT
+static __thread simtime_t last_gvt;
+/// The logical time window allowed ahead of the GVT while throttling
+/** This is the GVT advancement observed in the last unthrottled GVT period */
+static __thread simtime_t gvt_window;
+
+/**
+ * @brief Initializes the memory governor at the node level
+ */
+void mem_governor_global_init(void)
+{
+	if(!global_config.mem_budget)
+		return;
+
+	// If statistics are enabled, the facilities have already been set up
+	if(global_config.stats_file == NULL && mem_stat_setup() < 0) {
+		logger(LOG_ERROR, "Unable to extract memory statistics, the memory governor is disabled!");
+		global_config.mem_budget = 0;
+		return;
+	}
+
+	size_t budget = (size_t)global_config.mem_budget << 20U;
+	soft_limit = budget / 100 * MEM_GOVERNOR_SOFT_PERC;
+	hard_limit = budget / 100 * MEM_GOVERNOR_HARD_PERC;
+	atomic_store_explicit(&mem_level, MEM_GOVERNOR_NONE, memory_order_relaxed);
+}
+
+/**
+ * @brief Sample the resident set size and publish the corresponding memory pressure level
+ *
+ * This is called only by the master thread of the node, since the memory statistics facilities are not thread-safe.
+ */
+static void mem_level_sample(void)
+{
+	size_t rss = mem_stat_rss_current_get();
+	unsigned level = rss > hard_limit ? MEM_GOVERNOR_HARD : rss > soft_limit ? MEM_GOVERNOR_SOFT : MEM_GOVERNOR_NONE;
+	unsigned old_level = atomic_exchange_explicit(&mem_level, level, memory_order_relaxed);
+
+	if(unlikely(level != old_level))
+		logger(level ? LOG_WARN : LOG_INFO, "Memory pressure level changed from %u to %u (resident set %zu MiB)",
+		    old_level, level, rss >> 20U);
+
+	if(level)
+		gvt_start_early();
+}
+
+/**
+ * @brief Update the memory governor state after a GVT computation
+ * @param current_gvt the value of the freshly computed GVT
+ */
+void mem_governor_on_gvt(simtime_t current_gvt)
+{
+	if(likely(!global_config.mem_budget))
+		return;
+
+	simtime_t delta = current_gvt - last_gvt;
+	last_gvt = current_gvt;
+	if(mem_governor_horizon == SIMTIME_MAX || delta > gvt_window)
+		gvt_window = delta;
+
+	if(!rid)
+		mem_level_sample();
+
+	unsigned level = atomic_load_explicit(&mem_level, memory_order_relaxed);
+	if(likely(level == MEM_GOVERNOR_NONE)) {
+		mem_governor_horizon = SIMTIME_MAX;
+		return;
+	}
+
+	for(uint64_t i = lid_thread_first; i < lid_thread_end; ++i) {
+		struct lp_ctx *lp = &lps[i];
+		if(fossil_is_needed(lp)) {
+			auto_ckpt_recompute(&lp->auto_ckpt, lp->mm_state.ckpt_size);
+			fossil_lp_collect(lp);
+			lp->p.bound = unlikely(array_is_empty(lp->p.p_msgs)) ? -1.0 : lp->p.bound;
+		}
+	}
+
+	if(level == MEM_GOVERNOR_SOFT) {
+		mem_governor_horizon = current_gvt + gvt_window;
+		return;
+	}
+
+	mem_governor_horizon = current_gvt + gvt_window / 2;
+	for(uint64_t i = lid_thread_first; i < lid_thread_end; ++i)
+		process_lp_cancelback(&lps[i], mem_governor_horizon);
+}
+
+/**
+ * @brief Check whether the resident set of the node is above the soft limit of the memory budget
+ * @return true if the memory governor is enabled and the node is under memory pressure, false otherwise
+ */
+bool mem_governor_pressure_check(void)
+{
+	return atomic_load_explicit(&mem_level, memory_order_relaxed) != MEM_GOVERNOR_NONE;
+}
+
+/**
+ * @brief Check whether the next message of the current thread falls within the processing horizon
+ * @return true if the next message can be processed, false otherwise
+ *
+ * A deferred message still contributes to the GVT reduction, as if it had been extracted.
+ */
+bool mem_governor_throttle_check(void)
+{
+	simtime_t t = msg_queue_time_peek();
+	if(t <= mem_governor_horizon)
+		return true;
+
+	gvt_on_msg_extraction(t);
+	return false;
+}
@@ -0,0 +1,32 @@
+/**
+ * @file mm/mem_governor.h
+ *
+ * @brief Memory pressure driven flow control
+ *
+ * The module which throttles optimistic processing when the node resident set approaches the configured budget
+ *
+ * SPDX-FileCopyrightText: 2008-2023 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#pragma once
+
+#include <core/core.h>
+
+/// The percentage of the memory budget above which optimistic processing is slowed down
+#define MEM_GOVERNOR_SOFT_PERC 80
+/// The percentage of the memory budget above which the LPs furthest ahead are rolled back
+#define MEM_GOVERNOR_HARD_PERC 95
+
+/// The logical time beyond which the current thread is not allowed to process messages
+extern __thread simtime_t mem_governor_horizon;
+
+/**
+ * @brief Check whether the current thread is allowed to process its next message
+ * @return true if the next message can be processed, false otherwise
+ */
+#define mem_governor_can_process() (likely(mem_governor_horizon == SIMTIME_MAX) || mem_governor_throttle_check())
+
+extern void mem_governor_global_init(void);
+extern void mem_governor_on_gvt(simtime_t current_gvt);
+extern bool mem_governor_throttle_check(void);
+extern bool mem_governor_pressure_check(void);
@@ -14,13 +14,16 @@
 #include <datatypes/msg_queue.h>
 #include <distributed/mpi.h>
 #include <gvt/fossil.h>
+#include <log/records.h>
 #include <log/stats.h>
+#include <mm/mem_governor.h>
 #include <mm/msg_allocator.h>
 
 static void worker_thread_init(rid_t this_rid)
 {
 	rid = this_rid;
 	stats_init();
+	records_init();
 	auto_ckpt_init();
 	msg_allocator_init();
 	msg_queue_init();
@@ -51,6 +54,7 @@ static void worker_thread_fini(void)
 	}
 
 	lp_fini();
+	records_fini();
 	msg_queue_fini();
 	sync_thread_barrier();
 	msg_allocator_fini();
@@ -64,7 +68,7 @@ static thrd_ret_t THREAD_CALL_CONV parallel_thread_run(void *rid_arg)
 		mpi_remote_msg_handle();
 
 		unsigned i = 64;
-		while(i--)
+		while(i-- && mem_governor_can_process())
 			process_msg();
 
 		simtime_t current_gvt = gvt_phase_run();
@@ -72,6 +76,9 @@ static thrd_ret_t THREAD_CALL_CONV parallel_thread_run(void *rid_arg)
 			termination_on_gvt(current_gvt);
 			auto_ckpt_on_gvt();
 			fossil_on_gvt(current_gvt);
+			lp_on_gvt(current_gvt);
+			records_on_gvt(current_gvt);
+			mem_governor_on_gvt(current_gvt);
 			msg_allocator_on_gvt(current_gvt);
 			stats_on_gvt(current_gvt);
 		}
@@ -84,8 +91,12 @@ static thrd_ret_t THREAD_CALL_CONV parallel_thread_run(void *rid_arg)
 
 void parallel_global_init(void)
 {
+	sync_thread_barrier_reset();
 	stats_global_init();
+	records_global_init();
+	mem_governor_global_init();
 	lp_global_init();
+	model_allocator_global_init();
 	msg_queue_global_init();
 	termination_global_init();
 	gvt_global_init();
@@ -97,6 +108,7 @@ static void parallel_global_fini(void)
 	control_msg_fini();
 	msg_queue_global_fini();
 	lp_global_fini();
+	lp_initialized_reset();
 	stats_global_fini();
 }
 
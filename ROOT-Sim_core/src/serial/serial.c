@@ -12,12 +12,19 @@
 #include <core/control_msg.h>
 #include <datatypes/heap.h>
 #include <lib/retractable/retractable.h>
+#include <log/records.h>
 #include <log/stats.h>
 #include <lp/common.h>
 #include <mm/msg_allocator.h>
 
 /// The messages queue of the serial runtime
 static heap_declare(struct lp_msg *) queue;
+/// The message used to deliver retractable events, which the serial runtime handles in place
+static struct lp_msg retractable_msg = {.m_type = LP_RETRACTABLE};
+#ifndef NDEBUG
+/// The timestamp of the message being processed, used to detect messages sent in the past
+static simtime_t current_t;
+#endif
 
 /**
  * @brief Initialize the serial simulation environment
@@ -26,6 +33,8 @@ void serial_simulation_init(void)
 {
 	stats_global_init();
 	stats_init();
+	records_global_init();
+	records_init();
 	msg_allocator_init();
 	retractable_lib_init();
 	heap_init(queue);
@@ -35,14 +44,13 @@ void serial_simulation_init(void)
 	memset(lps, 0, sizeof(*lps) * global_config.lps);
 
 	n_lps_node = global_config.lps;
+	lid_thread_end = global_config.lps;
 
 	for(lp_id_t i = 0; i < global_config.lps; ++i) {
 		struct lp_ctx *lp = &lps[i];
 
 		lp->termination_t = -1;
 
-		model_allocator_lp_init(&lp->mm_state);
-
 		current_lp = lp;
 		retractable_lib_lp_init(lp);
 
@@ -69,18 +77,20 @@ static void serial_simulation_fini(void)
 		struct lp_ctx *lp = &lps[i];
 		current_lp = lp;
 		global_config.dispatcher(i, 0, LP_FINI, NULL, 0, lp->state_pointer);
-		model_allocator_lp_fini(&lp->mm_state);
+		retractable_lib_lp_fini(lp);
 	}
 
 	for(array_count_t i = 0; i < array_count(queue); ++i)
 		msg_allocator_free(array_get_at(queue, i));
 
 	mm_free(lps);
+	lp_initialized_reset();
 
 	control_msg_fini();
 	heap_fini(queue);
 	retractable_lib_fini();
 	msg_allocator_fini();
+	records_fini();
 	stats_global_fini();
 }
 
@@ -92,19 +102,26 @@ static int serial_simulation_run(void)
 	timer_uint last_vt = timer_new();
 	lp_id_t to_terminate = global_config.lps;
 
-	while(likely(!heap_is_empty(queue))) {
-		struct lp_msg *msg = heap_min(queue);
-
-		if(retractable_is_before(msg->dest_t))
-			msg = retractable_extract();
+	while(true) {
+		struct lp_msg *msg;
+		if(retractable_is_before(likely(!heap_is_empty(queue)) ? heap_min(queue)->dest_t : SIMTIME_MAX))
+			msg = retractable_extract_in_place(&retractable_msg);
+		else if(likely(!heap_is_empty(queue)))
+			msg = heap_min(queue);
+		else
+			break;
 
+#ifndef NDEBUG
+		current_t = msg->dest_t;
+#endif
 		struct lp_ctx *lp = &lps[msg->dest];
 		current_lp = lp;
 
 		common_msg_process(lp, msg);
 		retractable_reschedule(lp);
 
-		if(unlikely(lp->termination_t < 0 && global_config.committed(msg->dest, lp->state_pointer))) {
+		if(unlikely(lp->termination_t < 0 && global_config.committed != NULL &&
+		    global_config.committed(msg->dest, lp->state_pointer))) {
 			lp->termination_t = msg->dest_t;
 			if(unlikely(!--to_terminate)) {
 				stats_on_gvt(msg->dest_t);
@@ -114,15 +131,14 @@ static int serial_simulation_run(void)
 
 		if(global_config.gvt_period <= timer_value(last_vt)) {
 			stats_on_gvt(msg->dest_t);
+			lp_on_gvt(msg->dest_t);
 			if(unlikely(msg->dest_t >= global_config.termination_time))
 				break;
 			last_vt = timer_new();
 		}
 
-		if(msg->m_type != LP_RETRACTABLE)
-			heap_extract(queue, msg_is_before);
-
-		msg_allocator_free(msg);
+		if(msg != &retractable_msg)
+			msg_allocator_free(heap_extract(queue, msg_is_before));
 	}
 
 	stats_dump();
@@ -145,7 +161,7 @@ void ScheduleNewEvent_serial(lp_id_t receiver, simtime_t timestamp, unsigned eve
 	msg->raw_flags = 0;
 
 #ifndef NDEBUG
-	if(unlikely(msg_is_before(msg, heap_min(queue)))) {
+	if(unlikely(timestamp < current_t)) {
 		logger(LOG_FATAL, "Sending a message in the PAST!");
 		abort();
 	}
@@ -0,0 +1,103 @@
+/**
+ * @file test/tests/gvt/notify.c
+ *
+ * @brief Test: GVT notification of the model
+ *
+ * SPDX-FileCopyrightText: 2008-2023 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#include <test.h>
+
+#include <ROOT-Sim.h>
+
+#include <stdatomic.h>
+
+/// The count of LPs of the simulations run in this test
+#define NOTIFY_TEST_LPS 4
+
+/// The termination time of the simulations run in this test
+#define NOTIFY_TEST_TERMINATION 2000.0
+
+/// The state of the LPs of this test
+struct notify_state {
+	/// The id of the LP holding this state
+	lp_id_t me;
+};
+
+/// The latest GVT each LP has been notified of
+static simtime_t notified_gvt[NOTIFY_TEST_LPS];
+/// The count of notifications which broke the expected guarantees
+static _Atomic unsigned notify_errs;
+/// The count of notifications received
+static _Atomic unsigned notify_count;
+
+static void NotifyProcessEvent(lp_id_t me, simtime_t now, unsigned event_type, _unused const void *event_content,
+    _unused unsigned event_size, void *st)
+{
+	struct notify_state *state = st;
+	switch(event_type) {
+		case LP_INIT:
+			state = rs_malloc(sizeof(*state));
+			state->me = me;
+			SetState(state);
+			ScheduleNewEvent(me, 1.0, 0, NULL, 0);
+			break;
+		case LP_FINI:
+			rs_free(state);
+			break;
+		default:
+			test_thread_sleep(1);
+			ScheduleNewEvent((me + 1) % NOTIFY_TEST_LPS, now + 1.0, 0, NULL, 0);
+	}
+}
+
+static void NotifyOnGvt(lp_id_t me, simtime_t gvt, const void *st)
+{
+	const struct notify_state *state = st;
+	atomic_fetch_add_explicit(&notify_count, 1, memory_order_relaxed);
+	// The LP is notified in the thread hosting it, with the state it has set and a GVT which never goes backwards. Once
+	// no event is left, the whole trajectory is committed
+	unsigned errs = state == NULL || state->me != me || gvt < notified_gvt[me] ||
+	    (gvt > NOTIFY_TEST_TERMINATION && gvt != SIMTIME_MAX);
+	notified_gvt[me] = gvt;
+	if(errs)
+		atomic_fetch_add_explicit(&notify_errs, errs, memory_order_relaxed);
+}
+
+static struct simulation_configuration serial_conf = {
+    .lps = NOTIFY_TEST_LPS,
+    .termination_time = NOTIFY_TEST_TERMINATION,
+    .gvt_period = 1000,
+    .serial = true,
+    .dispatcher = NotifyProcessEvent,
+    .on_gvt = NotifyOnGvt,
+};
+
+static struct simulation_configuration parallel_conf = {
+    .lps = NOTIFY_TEST_LPS,
+    .n_threads = 2,
+    .termination_time = NOTIFY_TEST_TERMINATION,
+    .gvt_period = 1000,
+    .serial = false,
+    .dispatcher = NotifyProcessEvent,
+    .on_gvt = NotifyOnGvt,
+};
+
+static int notify_test(void *conf)
+{
+	for(lp_id_t i = 0; i < NOTIFY_TEST_LPS; ++i)
+		notified_gvt[i] = 0.0;
+	notify_errs = 0;
+	notify_count = 0;
+
+	if(RootsimInit((struct simulation_configuration *)conf) || RootsimRun())
+		return -1;
+
+	return notify_errs || !notify_count;
+}
+
+int main(void)
+{
+	test("Test GVT notification serial", notify_test, &serial_conf);
+	test("Test GVT notification parallel", notify_test, &parallel_conf);
+}
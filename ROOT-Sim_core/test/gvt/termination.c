@@ -11,6 +11,7 @@
 #include <ROOT-Sim.h>
 
 #include <memory.h>
+#include <stdatomic.h>
 
 static _Atomic bool initialized = false;
 
@@ -29,12 +30,62 @@ static bool DummyCanEnd(_unused lp_id_t lid, _unused const void *state)
 	return false; // Makes the simulation run infinitely
 }
 
+/// The termination time of the simulations run without a termination detection function
+#define HORIZON_TEST_TERMINATION 100.0
+
+/// The latest timestamp of an event processed by the simulations run without a termination detection function
+static _Atomic simtime_t horizon_max_t;
+
+static void HorizonProcessEvent(lp_id_t me, simtime_t now, unsigned event_type, _unused const void *event_content,
+    _unused unsigned event_size, _unused void *st)
+{
+	switch(event_type) {
+		case LP_INIT:
+			ScheduleNewEvent(me, 1.0, 0, NULL, 0);
+			break;
+		case LP_FINI:
+			break;
+		default:
+			for(simtime_t t = horizon_max_t; t < now;)
+				if(atomic_compare_exchange_weak(&horizon_max_t, &t, now))
+					break;
+			ScheduleNewEvent(me, now + 1.0, 0, NULL, 0);
+	}
+}
+
 static struct simulation_configuration serial_conf = {
     .lps = 1, .dispatcher = DummyProcessEvent, .committed = DummyCanEnd, .serial = true};
 
 static struct simulation_configuration parallel_conf = {
     .lps = 1, .dispatcher = DummyProcessEvent, .committed = DummyCanEnd, .serial = false};
 
+static struct simulation_configuration serial_horizon_conf = {
+    .lps = 4,
+    .termination_time = HORIZON_TEST_TERMINATION,
+    .serial = true,
+    .dispatcher = HorizonProcessEvent,
+    .committed = NULL,
+};
+
+static struct simulation_configuration parallel_horizon_conf = {
+    .lps = 4,
+    .termination_time = HORIZON_TEST_TERMINATION,
+    .serial = false,
+    .dispatcher = HorizonProcessEvent,
+    .committed = NULL,
+};
+
+static int horizon_termination_test(void *conf)
+{
+	horizon_max_t = 0.0;
+	if(RootsimInit((struct simulation_configuration *)conf) || RootsimRun())
+		return -1;
+
+	// The events past the termination time are never scheduled, the parallel runtime may stop before processing the
+	// last ones before it
+	return horizon_max_t > HORIZON_TEST_TERMINATION || horizon_max_t < HORIZON_TEST_TERMINATION - 1.0;
+}
+
 static int force_termination_test(void *conf)
 {
 	if(test_parallel_thread_id()) {
@@ -54,4 +105,6 @@ int main(void)
 	test_parallel("Test forced termination serial", force_termination_test, &serial_conf, 2);
 	initialized = false;
 	test_parallel("Test forced termination parallel", force_termination_test, &parallel_conf, 2);
+	test("Test termination time without CanEnd serial", horizon_termination_test, &serial_horizon_conf);
+	test("Test termination time without CanEnd parallel", horizon_termination_test, &parallel_horizon_conf);
 }
@@ -1,15 +1,28 @@
 /**
  * @file test/tests/integration/correctness/parallel.c
  *
- * @brief Test: integration test of the serial runtime
+ * @brief Test: integration test of the parallel runtime
+ *
+ * The model is run with each checkpointing mode and under memory pressure. The state of the current LP is sampled after
+ * each event, so that each configuration can also be checked for the behaviour it is expected to produce.
  *
  * SPDX-FileCopyrightText: 2008-2023 HPDCS Group <rootsim@googlegroups.com>
  * SPDX-License-Identifier: GPL-3.0-only
  */
 #include <test.h>
 
+#include <arch/mem.h>
+#include <lp/lp.h>
+#include <mm/mem_governor.h>
+
+#include <stdatomic.h>
+#include <stddef.h>
+
 #include "application.h"
 
+static void ProcessEventSampled(lp_id_t me, simtime_t now, unsigned event_type, const void *event_content,
+    unsigned event_size, void *st);
+
 struct simulation_configuration conf = {
     .lps = N_LPS,
     .n_threads = 2,
@@ -20,18 +33,84 @@ struct simulation_configuration conf = {
     .ckpt_interval = 0,
     .core_binding = false,
     .serial = false,
-    .dispatcher = ProcessEvent,
+    .dispatcher = ProcessEventSampled,
     .committed = CanEnd,
 };
 
+/// The samples taken after each event processed by the model
+static struct {
+	/// The count of samples in which the latest checkpoint of the LP copied whole pages only
+	_Atomic uint64_t page_ckpts;
+	/// The count of samples in which the latest checkpoint of the LP copied some partial page
+	_Atomic uint64_t other_ckpts;
+	/// The count of samples in which a checkpoint of the LP was held delta encoded
+	_Atomic uint64_t delta_encoded;
+	/// The count of samples taken while the thread was not allowed to process past a horizon
+	_Atomic uint64_t throttled;
+} samples;
+
+static void ProcessEventSampled(lp_id_t me, simtime_t now, unsigned event_type, const void *event_content,
+    unsigned event_size, void *st)
+{
+	ProcessEvent(me, now, event_type, event_content, event_size, st);
+
+	if(mem_governor_horizon != SIMTIME_MAX)
+		atomic_fetch_add_explicit(&samples.throttled, 1, memory_order_relaxed);
+
+	const struct mm_state *mm = &current_lp->mm_state;
+	if(array_is_empty(mm->logs))
+		return;
+
+	if((mm->ckpt_size - offsetof(struct mm_checkpoint, chkps)) % mem_page_size())
+		atomic_fetch_add_explicit(&samples.other_ckpts, 1, memory_order_relaxed);
+	else
+		atomic_fetch_add_explicit(&samples.page_ckpts, 1, memory_order_relaxed);
+
+	for(array_count_t i = 0; i < array_count(mm->logs); ++i) {
+		if(array_get_at(mm->logs, i).enc == MM_LOG_DELTA) {
+			atomic_fetch_add_explicit(&samples.delta_encoded, 1, memory_order_relaxed);
+			break;
+		}
+	}
+}
+
 static int correctness(void *config)
 {
-	RootsimInit((struct simulation_configuration *)config);
-	return RootsimRun();
+	const struct simulation_configuration *cfg = config;
+	atomic_store(&samples.page_ckpts, 0);
+	atomic_store(&samples.other_ckpts, 0);
+	atomic_store(&samples.delta_encoded, 0);
+	atomic_store(&samples.throttled, 0);
+
+	if(RootsimInit(cfg) || RootsimRun())
+		return -1;
+
+	int errs = 0;
+	// The LPs take checkpoints without a fixed interval too
+	errs += !atomic_load(&samples.page_ckpts) && !atomic_load(&samples.other_ckpts);
+	// A copy-on-write checkpoint copies the pages written since the previous one, a full copy the allocated blocks
+	errs += cfg->ckpt_cow != !atomic_load(&samples.other_ckpts);
+	// Without a memory budget, the full copy checkpoints are always delta encoded
+	errs += (cfg->ckpt_compress && !cfg->ckpt_cow) != (atomic_load(&samples.delta_encoded) != 0);
+	// A budget below the footprint of the runtime keeps the governor at the hard level from the first GVT
+	errs += (cfg->mem_budget != 0) != (atomic_load(&samples.throttled) != 0);
+	return errs;
 }
 
 int main(void)
 {
 	crc_table_init();
 	test("Correctness test (parallel)", correctness, &conf);
+
+	struct simulation_configuration governor = conf;
+	governor.mem_budget = 1;
+	test("Correctness test (parallel, memory governor)", correctness, &governor);
+
+	struct simulation_configuration cow = conf;
+	cow.ckpt_cow = true;
+	test("Correctness test (parallel, copy-on-write checkpointing)", correctness, &cow);
+
+	struct simulation_configuration delta = conf;
+	delta.ckpt_compress = true;
+	test("Correctness test (parallel, delta encoded checkpoints)", correctness, &delta);
 }
@@ -0,0 +1,47 @@
+/**
+ * @file test/tests/integration/correctness/rerun.c
+ *
+ * @brief Test: integration test of several simulations run back to back in the same process
+ *
+ * SPDX-FileCopyrightText: 2008-2023 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#include <test.h>
+
+#include "application.h"
+
+struct simulation_configuration conf = {
+    .lps = N_LPS,
+    .n_threads = 2,
+    .termination_time = 0.0,
+    .gvt_period = 100000,
+    .log_level = LOG_SILENT,
+    .stats_file = NULL,
+    .ckpt_interval = 0,
+    .core_binding = false,
+    .serial = false,
+    .dispatcher = ProcessEvent,
+    .committed = CanEnd,
+};
+
+static int correctness(void *config)
+{
+	struct simulation_configuration *cfg = config;
+	// Alternate the runtimes, so that each one starts over the leftovers of the other
+	static const bool runs[] = {false, true, false, true};
+
+	for(unsigned i = 0; i < sizeof(runs) / sizeof(*runs); ++i) {
+		cfg->serial = runs[i];
+		if(RootsimInit(cfg) || RootsimRun())
+			return -1;
+	}
+
+	// A run can't be started without initializing the core again
+	return RootsimRun() != -1;
+}
+
+int main(void)
+{
+	crc_table_init();
+	test("Correctness test (simulations run back to back)", correctness, &conf);
+}
@@ -0,0 +1,112 @@
+/**
+ * @file test/tests/log/records.c
+ *
+ * @brief Test: committed records module
+ *
+ * The records of a LP are emitted, partly rolled back and emitted again, then committed: the records file must only hold
+ * the ones of the final trajectory, once each and sorted by logical time.
+ *
+ * SPDX-FileCopyrightText: 2008-2023 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#include <test.h>
+
+#include <log/records.h>
+#include <lp/lp.h>
+
+#include <stdio.h>
+
+/// The prefix of the records files written in this test
+#define RECORDS_TEST_FILE "test_records"
+/// The count of events processed by the LP before the rollback
+#define RECORDS_TEST_EVENTS 10U
+/// The index of the first rolled back event
+#define RECORDS_TEST_ROLLBACK 6U
+/// The GVT which commits part of the records after the rollback
+#define RECORDS_TEST_GVT 7.0
+
+/**
+ * @brief Emit the record of a processed event
+ * @param lp the LP processing the event
+ * @param i the index of the event, which is also its timestamp
+ * @param value the contents of the record
+ */
+static void event_record(struct lp_ctx *lp, array_count_t i, uint64_t value)
+{
+	array_count(lp->p.p_msgs) = i;
+	records_lp_push(lp, (simtime_t)i, 1, &value);
+	array_count(lp->p.p_msgs) = i + 1;
+}
+
+static int records_test(_unused void *_)
+{
+	static struct lp_ctx lp;
+	int errs = 0;
+
+	global_config.records_file = RECORDS_TEST_FILE;
+	global_config.record_size = sizeof(uint64_t);
+	records_global_init();
+	records_init();
+
+	lps = &lp;
+	lid_thread_first = 0;
+	lid_thread_end = 1;
+	records_lp_init(&lp);
+
+	for(array_count_t i = 0; i < RECORDS_TEST_EVENTS; ++i)
+		event_record(&lp, i, i);
+
+	// The rolled back events are processed again, and emit different records
+	records_lp_rollback(&lp, RECORDS_TEST_ROLLBACK);
+	errs += array_count(lp.rec.meta) != RECORDS_TEST_ROLLBACK;
+	for(array_count_t i = RECORDS_TEST_ROLLBACK; i < RECORDS_TEST_EVENTS; ++i)
+		event_record(&lp, i, 100 + i);
+
+	records_on_gvt(RECORDS_TEST_GVT);
+	errs += array_count(lp.rec.meta) != RECORDS_TEST_EVENTS - (array_count_t)RECORDS_TEST_GVT;
+
+	// The records past the GVT are still discarded by a rollback
+	records_lp_rollback(&lp, RECORDS_TEST_EVENTS - 1);
+	records_lp_fini(&lp);
+	records_fini();
+	global_config.records_file = NULL;
+	lps = NULL;
+
+	FILE *f = fopen(RECORDS_TEST_FILE ".0.0", "rb");
+	if(f == NULL)
+		return -1;
+
+	uint32_t header[6];
+	errs += fread(header, sizeof(header), 1, f) != 1;
+	errs += header[0] != RECORDS_MAGIC || header[1] != RECORDS_VERSION || header[4] != sizeof(uint64_t);
+
+	uint64_t cnt;
+	errs += fread(&cnt, sizeof(cnt), 1, f) != 1;
+	errs += cnt != RECORDS_TEST_EVENTS - 1;
+	if(errs) {
+		fclose(f);
+		return errs;
+	}
+
+	simtime_t t[RECORDS_TEST_EVENTS];
+	uint64_t lp_id[RECORDS_TEST_EVENTS], data[RECORDS_TEST_EVENTS];
+	uint32_t type[RECORDS_TEST_EVENTS];
+	errs += fread(t, sizeof(*t), cnt, f) != cnt;
+	errs += fread(lp_id, sizeof(*lp_id), cnt, f) != cnt;
+	errs += fread(data, sizeof(*data), cnt, f) != cnt;
+	errs += fread(type, sizeof(*type), cnt, f) != cnt;
+	fclose(f);
+
+	for(uint64_t i = 0; i < cnt; ++i) {
+		uint64_t expected = i < RECORDS_TEST_ROLLBACK ? i : 100 + i;
+		errs += t[i] != (simtime_t)i || lp_id[i] != 0 || data[i] != expected || type[i] != 1;
+	}
+
+	remove(RECORDS_TEST_FILE ".0.0");
+	return errs;
+}
+
+int main(void)
+{
+	test("Testing committed records across a rollback", records_test, NULL);
+}
@@ -86,7 +86,7 @@ def test_stats_file(base_name, expected):
     if not os.path.isfile(full_base_name + ".bin"):
         sys.exit(1)
     sys.argv[1] = full_base_name + ".bin"
-    runpy.run_path(path_name=RS_SCRIPT_PATH, run_name="__main__")
+    rs_globals = runpy.run_path(path_name=RS_SCRIPT_PATH, run_name="__main__")
     with open(full_base_name + ".txt", "r", encoding="utf8") as report_file:
         data = report_file.read()
 
@@ -101,6 +101,24 @@ def test_stats_file(base_name, expected):
         elif expected_field != match[i + 1]:
             sys.exit(1)
 
+    return rs_globals["RSStats"](full_base_name + ".bin")
+
+
+def test_profile(rs_stats):
+    """
+    Test the profiling statistics
+
+    :param rs_stats: the RSStats object loaded from the profiling statistics file
+    """
+    if rs_stats.lp_profile_get("processed messages") != {0: 10, 8: 10}:
+        sys.exit(1)
+    if rs_stats.lp_profile_get("rollbacks", aggregate_gvts=False) != [{0: 1, 8: 1}, {0: 1, 8: 1}]:
+        sys.exit(1)
+    if rs_stats.msg_type_profile_get("processed messages") != {3: 20, 65534: 4}:
+        sys.exit(1)
+    if rs_stats.msg_type_profile_get("rollbacks") != {3: 4}:
+        sys.exit(1)
+
 
 if __name__ == "__main__":
     RS_SCRIPT_PATH, BIN_FOLDER = test_init()
@@ -113,5 +131,9 @@ if __name__ == "__main__":
                                         "100.00", "0", "0", "0", "0", "48.56", "4", "12.14", "NZ", "NZ"])
     test_stats_file("measures_stats", ["NZ", "0", "1", "2", "16", "156", "102", "24", "30", "20", "60", "15.87", "1.20",
                                        "80.95", "0", "0", "0", "0", "0.0", "1", "0.0", "NZ", "NZ"])
+    profile_stats = test_stats_file("profile_stats", ["NZ", "0", "1", "2", "16", "0", "0", "0", "0", "0", "0", "0.00",
+                                                      "0.00", "100.00", "0", "0", "0", "0", "12.12", "2", "6.06", "NZ",
+                                                      "NZ"])
+    test_profile(profile_stats)
 
-    # TODO: test the actual RSStats python object
+    # TODO: test more thoroughly the RSStats python object
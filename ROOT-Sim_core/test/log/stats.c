@@ -7,6 +7,7 @@
  * SPDX-License-Identifier: GPL-3.0-only
  */
 #include "log/stats.h"
+#include "lp/lp.h"
 
 #include <test.h>
 
@@ -85,6 +86,24 @@ int stats_measures_test(_unused void *arg)
 	return 0;
 }
 
+int stats_profile_test(_unused void *arg)
+{
+	rid = test_parallel_thread_id();
+	lid_thread_first = rid * 8;
+	lid_thread_end = lid_thread_first + 8;
+	stats_init();
+
+	for(unsigned i = 0; i < 2; ++i) {
+		stats_profile_lp_take(lid_thread_first, STATS_PROFILE_MSG_PROCESSED, 5);
+		stats_profile_lp_take(lid_thread_first, STATS_PROFILE_ROLLBACK, 1);
+		stats_profile_msg_take(3, STATS_PROFILE_MSG_PROCESSED, 5);
+		stats_profile_msg_take(3, STATS_PROFILE_ROLLBACK, 1);
+		stats_profile_msg_take(LP_INIT, STATS_PROFILE_MSG_PROCESSED, 1);
+		stats_on_gvt(gvt_tests[i]);
+	}
+	return 0;
+}
+
 static void stats_subsystem_test(const char *name, test_fn thread_fn)
 {
 	global_config.stats_file = name;
@@ -101,6 +120,8 @@ int main(void)
 	stats_subsystem_test("single_gvt_stats", stats_single_gvt_test);
 	stats_subsystem_test("multi_gvt_stats", stats_multi_gvt_test);
 	stats_subsystem_test("measures_stats", stats_measures_test);
+	global_config.stats_profile = true;
+	stats_subsystem_test("profile_stats", stats_profile_test);
 
 	// TODO: stress test the sample aggregation system
 }
@@ -0,0 +1,214 @@
+/**
+ * @file test/tests/log/telemetry.c
+ *
+ * @brief Test: live telemetry module
+ *
+ * A short serial simulation streams its telemetry to a file and to a Unix domain socket. Each received line must follow
+ * the documented InfluxDB line protocol format.
+ *
+ * SPDX-FileCopyrightText: 2008-2023 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#include <test.h>
+
+#include <arch/io.h>
+#include <log/telemetry.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/// The count of LPs of the simulations run in this test
+#define TELEMETRY_TEST_LPS 4
+/// The file endpoint used in this test
+#define TELEMETRY_TEST_FILE "test_telemetry.txt"
+/// The Unix domain socket endpoint used in this test
+#define TELEMETRY_TEST_SOCKET "test_telemetry.sock"
+
+static void TelemetryProcessEvent(lp_id_t me, simtime_t now, unsigned event_type, _unused const void *event_content,
+    _unused unsigned event_size, _unused void *st)
+{
+	switch(event_type) {
+		case LP_INIT:
+			ScheduleNewEvent(me, 1.0, 0, NULL, 0);
+			break;
+		case LP_FINI:
+			break;
+		default:
+			test_thread_sleep(1);
+			ScheduleNewEvent((me + 1) % TELEMETRY_TEST_LPS, now + 1.0, 0, NULL, 0);
+	}
+}
+
+static struct simulation_configuration conf = {
+    .lps = TELEMETRY_TEST_LPS,
+    .termination_time = 100.0,
+    .gvt_period = 1000,
+    .log_level = LOG_SILENT,
+    .serial = true,
+    .dispatcher = TelemetryProcessEvent,
+};
+
+/// The telemetry lines checked so far
+static struct {
+	/// The count of thread lines
+	unsigned threads;
+	/// The count of node lines
+	unsigned nodes;
+	/// The latest GVT reported
+	double gvt;
+} seen;
+
+/**
+ * @brief Check a telemetry line
+ * @param line the line, without the trailing newline
+ * @return the count of errors found in the line
+ */
+static int line_check(const char *line)
+{
+	int nid, n = -1;
+	unsigned rid;
+	double gvt, rate, rollback_ratio, idle_ratio;
+	uint64_t events, rollbacks, rolled_back, ts;
+	size_t rss;
+
+	if(sscanf(line,
+	       "rootsim_thread,node=%d,thread=%u gvt=%lf,events=%" SCNu64 "u,events_rate=%lf,rollbacks=%" SCNu64
+	       "u,rolled_back=%" SCNu64 "u,rollback_ratio=%lf,idle_ratio=%lf %" SCNu64 "%n",
+	       &nid, &rid, &gvt, &events, &rate, &rollbacks, &rolled_back, &rollback_ratio, &idle_ratio, &ts, &n) == 10 &&
+	    (size_t)n == strlen(line)) {
+		int errs = nid != 0 || rid != 0 || rate < 0.0 || !ts;
+		errs += rolled_back > events || rollback_ratio < 0.0 || rollback_ratio > 1.0;
+		errs += idle_ratio < 0.0 || idle_ratio > 1.0;
+		errs += gvt < seen.gvt;
+		seen.gvt = gvt;
+		++seen.threads;
+		return errs;
+	}
+
+	if(sscanf(line, "rootsim_node,node=%d gvt=%lf,gvt_rate=%lf,rss=%zuu %" SCNu64 "%n", &nid, &gvt, &rate, &rss, &ts,
+	       &n) == 5 &&
+	    (size_t)n == strlen(line)) {
+		++seen.nodes;
+		return nid != 0 || gvt != seen.gvt || rate < 0.0 || !rss || !ts;
+	}
+
+	return 1;
+}
+
+/**
+ * @brief Check a buffer of telemetry lines
+ * @param buf the buffer, which is modified by this function
+ * @param size the size of the buffer
+ * @return the count of errors found in the lines
+ */
+static int lines_check(char *buf, size_t size)
+{
+	int errs = 0;
+	while(size) {
+		char *end = memchr(buf, '\n', size);
+		if(end == NULL)
+			return errs + 1;
+		*end = '\0';
+		errs += line_check(buf);
+		size -= end + 1 - buf;
+		buf = end + 1;
+	}
+	return errs;
+}
+
+static void seen_reset(void)
+{
+	memset(&seen, 0, sizeof(seen));
+}
+
+static int telemetry_file_test(_unused void *_)
+{
+	seen_reset();
+	remove(TELEMETRY_TEST_FILE);
+	conf.telemetry_endpoint = TELEMETRY_TEST_FILE;
+	if(RootsimInit(&conf) || RootsimRun())
+		return -1;
+
+	FILE *f = fopen(TELEMETRY_TEST_FILE, "r");
+	if(f == NULL)
+		return -1;
+
+	int errs = 0;
+	char line[TELEMETRY_LINE_MAX];
+	while(fgets(line, sizeof(line), f) != NULL)
+		errs += lines_check(line, strlen(line));
+	fclose(f);
+	remove(TELEMETRY_TEST_FILE);
+
+	return errs || !seen.threads || !seen.nodes;
+}
+
+static int telemetry_socket_test(_unused void *_)
+{
+	seen_reset();
+	int s = socket(AF_UNIX, SOCK_DGRAM, 0);
+	if(s == -1)
+		return -1;
+
+	struct sockaddr_un addr = {.sun_family = AF_UNIX};
+	strcpy(addr.sun_path, TELEMETRY_TEST_SOCKET);
+	unlink(TELEMETRY_TEST_SOCKET);
+	if(bind(s, (struct sockaddr *)&addr, sizeof(addr))) {
+		close(s);
+		return -1;
+	}
+
+	conf.telemetry_endpoint = IO_ENDPOINT_UNIX_PREFIX TELEMETRY_TEST_SOCKET;
+	int errs = RootsimInit(&conf) || RootsimRun();
+
+	// Each datagram holds the lines written at a GVT. Lines are dropped when the socket is full
+	char buf[2 * TELEMETRY_LINE_MAX];
+	ssize_t l;
+	while((l = recv(s, buf, sizeof(buf), MSG_DONTWAIT)) > 0)
+		errs += lines_check(buf, l);
+
+	close(s);
+	unlink(TELEMETRY_TEST_SOCKET);
+	return errs || !seen.threads || !seen.nodes;
+}
+
+static int telemetry_termination_test(_unused void *_)
+{
+	seen_reset();
+	remove(TELEMETRY_TEST_FILE);
+	global_config.telemetry_endpoint = TELEMETRY_TEST_FILE;
+	telemetry_global_init();
+
+	// The first GVT only starts the period; the one of a terminated simulation produces no lines
+	telemetry_on_gvt(1.0);
+	test_thread_sleep(1);
+	telemetry_on_gvt(2.0);
+	test_thread_sleep(1);
+	telemetry_on_gvt(SIMTIME_MAX);
+	telemetry_global_fini();
+	global_config.telemetry_endpoint = NULL;
+
+	FILE *f = fopen(TELEMETRY_TEST_FILE, "r");
+	if(f == NULL)
+		return -1;
+
+	int errs = 0;
+	char line[TELEMETRY_LINE_MAX];
+	while(fgets(line, sizeof(line), f) != NULL)
+		errs += lines_check(line, strlen(line));
+	fclose(f);
+	remove(TELEMETRY_TEST_FILE);
+
+	return errs || seen.threads != 1 || seen.nodes != 1 || seen.gvt != 2.0;
+}
+
+int main(void)
+{
+	test("Testing telemetry to a file", telemetry_file_test, NULL);
+	test("Testing telemetry to a Unix domain socket", telemetry_socket_test, NULL);
+	test("Testing telemetry at the simulation termination", telemetry_termination_test, NULL);
+}
@@ -0,0 +1,93 @@
+/**
+ * @file test/tests/mm/governor.c
+ *
+ * @brief Test: memory pressure driven flow control
+ *
+ * A test of the memory governor levels and of the processing horizon they set. The resident set of the process is
+ * driven across the soft and the hard limit by mapping and touching some ballast memory between the GVT samples.
+ *
+ * SPDX-FileCopyrightText: 2008-2023 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#include <test.h>
+
+#include <arch/mem.h>
+#include <mm/mem_governor.h>
+
+#include <string.h>
+
+/// The memory budget in MiB used in this test
+#define GOVERNOR_TEST_BUDGET 128U
+
+static void *ballast;
+static size_t ballast_size;
+
+/**
+ * @brief Bring the resident set of the process close to the requested size
+ * @param rss the target resident set size as a percentage of the memory budget, 0 to just release the ballast
+ */
+static void rss_set(unsigned rss)
+{
+	if(ballast != NULL) {
+		mem_pages_unmap(ballast, ballast_size);
+		ballast = NULL;
+	}
+	if(!rss)
+		return;
+
+	size_t target = ((size_t)GOVERNOR_TEST_BUDGET << 20U) / 100 * rss;
+	size_t current = mem_stat_rss_current_get();
+	if(target <= current)
+		return;
+
+	size_t page = mem_page_size();
+	ballast_size = (target - current + page - 1) / page * page;
+	ballast = mem_pages_map(ballast_size);
+	// The pages are only accounted in the resident set once they are touched
+	memset(ballast, 0x5a, ballast_size);
+}
+
+int mem_governor_test(_unused void *_)
+{
+	int errs = 0;
+
+	global_config.mem_budget = GOVERNOR_TEST_BUDGET;
+	global_config.stats_file = NULL;
+	mem_governor_global_init();
+	errs += global_config.mem_budget != GOVERNOR_TEST_BUDGET;
+
+	rss_set(0);
+	mem_governor_on_gvt(10.0);
+	errs += mem_governor_pressure_check();
+	errs += mem_governor_horizon != SIMTIME_MAX;
+
+	// Soft level: the horizon is the GVT advancement of the last unthrottled period past the GVT
+	rss_set((MEM_GOVERNOR_SOFT_PERC + MEM_GOVERNOR_HARD_PERC) / 2);
+	mem_governor_on_gvt(20.0);
+	errs += !mem_governor_pressure_check();
+	errs += mem_governor_horizon != 30.0;
+
+	// The window doesn't shrink while throttling, else the GVT would advance slower and slower
+	mem_governor_on_gvt(25.0);
+	errs += mem_governor_horizon != 35.0;
+
+	// Hard level: the window is halved
+	rss_set(100);
+	mem_governor_on_gvt(30.0);
+	errs += !mem_governor_pressure_check();
+	errs += mem_governor_horizon != 35.0;
+
+	// Back to the soft level, with the window of the last unthrottled period
+	rss_set((MEM_GOVERNOR_SOFT_PERC + MEM_GOVERNOR_HARD_PERC) / 2);
+	mem_governor_on_gvt(40.0);
+	errs += !mem_governor_pressure_check();
+	errs += mem_governor_horizon != 50.0;
+
+	rss_set(0);
+	mem_governor_on_gvt(50.0);
+	errs += mem_governor_pressure_check();
+	errs += mem_governor_horizon != SIMTIME_MAX;
+
+	global_config.mem_budget = 0;
+	return errs;
+}
@@ -0,0 +1,86 @@
+/**
+ * @file test/tests/mm/large.c
+ *
+ * @brief Test: rollbackable large objects
+ *
+ * A test of the extents used by the model allocator to handle allocations bigger than a buddy system
+ *
+ * SPDX-FileCopyrightText: 2008-2023 HPDCS Group <rootsim@googlegroups.com>
+ * SPDX-License-Identifier: GPL-3.0-only
+ */
+#include <test.h>
+
+#include <lp/lp.h>
+#include <mm/buddy/buddy.h>
+#include "../mock.h"
+
+#define LARGE_TEST_SEED 0x1A76EUL
+#define LARGE_TEST_SIZE ((3U << B_TOTAL_EXP) + 40U)
+
+static void write_words(uint64_t *mem, unsigned count, unsigned stride, test_rng_state *l_rng_p)
+{
+	for(unsigned i = 0; i < count; i += stride)
+		mem[i] = rng_random_u(l_rng_p);
+}
+
+static int check_words(const uint64_t *mem, unsigned count, unsigned stride, test_rng_state *l_rng_p)
+{
+	int errs = 0;
+	for(unsigned i = 0; i < count; i += stride)
+		errs += mem[i] != rng_random_u(l_rng_p);
+	return errs;
+}
+
+int model_allocator_large_test(_unused void *_)
+{
+	int errs = 0;
+	unsigned words = LARGE_TEST_SIZE / sizeof(uint64_t);
+
+	struct lp_ctx *lp = test_lp_mock_get();
+	current_lp = lp;
+	model_allocator_global_init();
+	model_allocator_lp_init(&lp->mm_state);
+
+	test_rng_state l_rng, l_chk;
+	rng_init(&l_rng, LARGE_TEST_SEED);
+
+	uint64_t *mem = rs_malloc(LARGE_TEST_SIZE);
+	errs += mem == NULL;
+	write_words(mem, words, 1, &l_rng);
+
+	model_allocator_checkpoint_take(&lp->mm_state, 0);
+	l_chk = l_rng;
+
+	// sparse writes: only the touched pages are saved
+	write_words(mem, words, 1000, &l_rng);
+	uint64_t *other = rs_malloc(LARGE_TEST_SIZE);
+	errs += other == NULL;
+	write_words(other, words, 1, &l_rng);
+	model_allocator_checkpoint_take(&lp->mm_state, 1);
+
+	write_words(mem, words, 1, &l_rng);
+	rs_free(other);
+	model_allocator_checkpoint_take(&lp->mm_state, 2);
+
+	model_allocator_checkpoint_restore(&lp->mm_state, 1);
+	errs += check_words(mem, words, 1000, &l_chk);
+	errs += check_words(other, words, 1, &l_chk);
+
+	write_words(mem, words, 7, &l_rng);
+	model_allocator_checkpoint_restore(&lp->mm_state, 0);
+	rng_init(&l_rng, LARGE_TEST_SEED);
+	errs += check_words(mem, words, 1, &l_rng);
+
+	mem = rs_realloc(mem, 2 * LARGE_TEST_SIZE);
+	rng_init(&l_rng, LARGE_TEST_SEED);
+	errs += check_words(mem, words, 1, &l_rng);
+
+	model_allocator_checkpoint_take(&lp->mm_state, 1);
+	model_allocator_fossil_lp_collect(&lp->mm_state, 1);
+	errs += array_count(lp->mm_state.extents) != 1;
+
+	rs_free(mem);
+	model_allocator_lp_fini(&lp->mm_state);
+
+	return errs;
+}
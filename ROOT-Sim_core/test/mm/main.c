@@ -14,7 +14,9 @@
 
 extern int model_allocator_test(void *);
 extern int model_allocator_test_hard(void *);
+extern int model_allocator_large_test(void *);
 extern int parallel_malloc_test(void *);
+extern int mem_governor_test(void *);
 
 int main(void)
 {
@@ -22,5 +24,7 @@ int main(void)
 
 	test("Testing buddy system", model_allocator_test, NULL);
 	test("Testing buddy system (hard test)", model_allocator_test_hard, NULL);
+	test("Testing large objects", model_allocator_large_test, NULL);
 	test("Testing parallel memory operations", parallel_malloc_test, NULL);
+	test("Testing memory governor levels", mem_governor_test, NULL);
 }
@@ -18,7 +18,11 @@ struct rng_t {
   uint64_t state[4];
 };
 
-extern void initialize_stream(unsigned stream, struct rng_t *ctx);
+extern void initialize_master_seed(uint64_t seed);
+extern void initialize_stream(uint64_t stream, struct rng_t *ctx);
+extern void initialize_counter_stream(uint64_t seed, uint64_t stream, uint64_t counter, struct rng_t *ctx);
+extern uint64_t CounterRandomU64(uint64_t seed, uint64_t stream, uint64_t counter);
+extern double CounterRandom(uint64_t seed, uint64_t stream, uint64_t counter);
 extern uint64_t RandomU64(struct rng_t *ctx);
 extern double Random(struct rng_t *ctx);
 extern double Normal(struct rng_t *ctx);
@@ -64,7 +64,24 @@ static void init(void) {
 static const uint32_t xxtea_seeding_key[4] = {UINT32_C(0xd0a8f58a), UINT32_C(0x33359424), UINT32_C(0x09baa55b),
     UINT32_C(0x80e1bdb0)};
 
-void initialize_stream(unsigned stream, struct rng_t *ctx)
+/**
+ * @brief Set the master seed of the streams initialized with initialize_stream()
+ *
+ * Unless this is called, the master seed is taken from the wall clock time at startup.
+ *
+ * @param seed the new master seed
+ */
+void initialize_master_seed(uint64_t seed)
+{
+	master_seed = seed;
+}
+
+/**
+ * @brief Initialize a random stream from the master seed
+ * @param stream the id of the stream
+ * @param ctx the stream context to initialize
+ */
+void initialize_stream(uint64_t stream, struct rng_t *ctx)
 {
 	ctx->state[0] = stream;
 	ctx->state[1] = master_seed;
@@ -73,6 +90,59 @@ void initialize_stream(unsigned stream, struct rng_t *ctx)
 	xxtea_encode((uint32_t *)ctx->state, 8, xxtea_seeding_key);
 }
 
+/**
+ * @brief Initialize a random stream from an explicit seed, without using the master seed
+ *
+ * XXTEA is a permutation, so different (@a seed, @a stream, @a counter) triples always give different states, which
+ * also differ from the ones of initialize_stream(). The counter allows deriving many independent streams from the same
+ * stream id, e.g. one per event, so that their state does not need to be kept.
+ *
+ * @param seed the seed of the stream
+ * @param stream the id of the stream
+ * @param counter the sub-stream of the stream
+ * @param ctx the stream context to initialize
+ */
+void initialize_counter_stream(uint64_t seed, uint64_t stream, uint64_t counter, struct rng_t *ctx)
+{
+	ctx->state[0] = stream;
+	ctx->state[1] = seed;
+	ctx->state[2] = counter;
+	ctx->state[3] = ~seed;
+	xxtea_encode((uint32_t *)ctx->state, 8, xxtea_seeding_key);
+}
+
+/**
+ * @brief Return a random 64-bit value which only depends on its arguments
+ *
+ * This is a counter-based generator: the values can be drawn in any order, without keeping a stream state. The
+ * (@a counter, @a stream) block is encrypted with XXTEA, keyed with @a seed, so that the values of a seed are all
+ * different.
+ *
+ * @param seed the seed of the stream
+ * @param stream the id of the stream
+ * @param counter the position of the value in the stream
+ * @return The random number
+ */
+uint64_t CounterRandomU64(uint64_t seed, uint64_t stream, uint64_t counter)
+{
+	uint64_t v[2] = {counter, stream};
+	const uint32_t key[4] = {(uint32_t)seed, (uint32_t)(seed >> 32), xxtea_seeding_key[2], xxtea_seeding_key[3]};
+	xxtea_encode((uint32_t *)v, 4, key);
+	return v[0];
+}
+
+/**
+ * @brief Return a random value in [0,1) according to a uniform distribution, which only depends on its arguments
+ * @param seed the seed of the stream
+ * @param stream the id of the stream
+ * @param counter the position of the value in the stream
+ * @return The random number
+ */
+double CounterRandom(uint64_t seed, uint64_t stream, uint64_t counter)
+{
+	return (double)(CounterRandomU64(seed, stream, counter) >> 11) * 0x1.0p-53;
+}
+
 /**
  * @brief Return a random-bak 64-bit value
  * @return The random-bak number
@@ -9,6 +9,8 @@
 #include <stdint.h>
 #include <test.h>
 
+#include <ROOT-Sim/random.h>
+
 extern uint64_t master_seed;
 
 int test_rng_is_initialized(_unused void *_)
@@ -17,8 +19,28 @@ int test_rng_is_initialized(_unused void *_)
 	return 0;
 }
 
+int test_rng_seeded_streams(_unused void *_)
+{
+	struct rng_t a, b;
+
+	initialize_master_seed(42);
+	initialize_stream(7, &a);
+	initialize_stream(7, &b);
+	test_assert(RandomU64(&a) == RandomU64(&b));
+
+	initialize_counter_stream(42, 7, 0, &a);
+	initialize_counter_stream(42, 7, 1, &b);
+	test_assert(RandomU64(&a) != RandomU64(&b));
+
+	test_assert(CounterRandomU64(42, 7, 3) == CounterRandomU64(42, 7, 3));
+	test_assert(CounterRandomU64(42, 7, 3) != CounterRandomU64(43, 7, 3));
+	test_assert(CounterRandomU64(42, 7, 3) != CounterRandomU64(42, 8, 3));
+	return 0;
+}
+
 int main(void)
 {
 	test("RNG is initialized", test_rng_is_initialized, NULL);
+	test("Seeded RNG streams are reproducible", test_rng_seeded_streams, NULL);
 	return 0;
 }